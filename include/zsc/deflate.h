@@ -67,6 +67,15 @@
 #define HEAP_SIZE (2*L_CODES+1)
 /* maximum heap size */
 
+// Abcouwer ZSC - counting many literals at once, see tally_lits()
+#define LIT_COUNT_WAYS 2
+/* Interleaved count tables, so a repeated byte is not one dependency chain.
+ * They are kept in heap[], which is only used while building trees.
+ */
+
+#define LIT_COUNT_MIN 512
+/* Fewer literals than this are counted directly in the literal tree */
+
 #define MAX_BITS 15
 /* All codes must not exceed MAX_BITS bits */
 
@@ -212,6 +221,25 @@ typedef struct internal_state {
 
     I32 nice_match; /* Stop searching when current match exceeds this */
 
+    // Abcouwer ZSC - skip through unmatched input, see deflateAccel()
+    U32 accel;
+    /* The step after a miss grows by one every 2^(MAX_ACCEL-accel) misses,
+     * 0 for no skipping. Used only for compression levels <= 3.
+     */
+
+    U32 misses; /* positions without a match since the last match */
+
+    // Abcouwer ZSC - adaptive chain limit, see deflateAdaptChain()
+    U32 adapt_chain;      /* nonzero to adapt chain_limit to recent gains */
+    U32 min_chain_length; /* chain_limit is never lowered below this */
+    U32 chain_limit;      /* hash chains are searched no further than this */
+    U32 deep_walks;       /* chain searches counted since the last change */
+    U32 deep_cost;        /* entries they visited in their deeper halves */
+    U32 deep_gain;        /* match length they gained there */
+
+    // Abcouwer ZSC - run shortcut, see deflateFastRuns()
+    U32 fast_runs; /* nonzero to emit long runs without searching them */
+
                 /* used by trees.c: */
     /* Didn't use ct_data typedef below to suppress compiler warning */
     struct ct_data_s dyn_ltree[HEAP_SIZE];   /* literal and length tree */
@@ -310,12 +338,20 @@ ZSC_COMPILE_ASSERT(Z_DEFLATE_STATE_SIZE >= sizeof(deflate_state),
  * distances are limited to MAX_DIST instead of WSIZE.
  */
 
+// Abcouwer ZSC - skipping through unmatched input, see deflateAccel()
+#define MAX_ACCEL 7
+/* Largest accel, for which the step grows with every miss */
+
+#define MAX_MISSES 0xffff
+/* Misses are counted up to this, bounding the step */
+
 #define WIN_INIT MAX_MATCH
 /* Number of bytes after end of data in window to initialize in order to avoid
    memory checker errors from longest match routines */
 
         /* in trees.c */
 void _tr_init (deflate_state *s);
+void _tr_init_desc (deflate_state *s);
 void _tr_flush_block (deflate_state *s, U8 *buf,
                         U32 stored_len, I32 last);
 void _tr_flush_bits (deflate_state *s);
@@ -347,6 +383,7 @@ extern const U8 _dist_code[];
     U16 dist = (U16)(distance); \
     (s)->d_buf[(s)->last_lit] = dist; \
     (s)->l_buf[(s)->last_lit++] = len; \
+    (s)->matches++; \
     dist--; \
     (s)->dyn_ltree[_length_code[len]+LITERALS+1].Freq++; \
     (s)->dyn_dtree[d_code(dist)].Freq++; \
@@ -9,3 +9,5 @@
  */
 
 void inflate_fast (z_stream * strm, U32 start);
+void inflate_fast_fixed (z_stream * strm, U32 start);
+void inflate_fast_count (z_stream * strm, U32 start);
@@ -40,6 +40,11 @@
 #include "zsc/zlib.h"
 #include "zsc/inftrees.h"
 
+/* Abcouwer ZSC - index sizes of the fixed code tables, which have no
+   second-level tables */
+#define FIXED_LENBITS 9
+#define FIXED_DISTBITS 5
+
 /* Possible inflate modes between inflate() calls */
 typedef enum {
     HEAD = 16180,   /* i: waiting for magic header */
@@ -144,6 +149,7 @@ typedef struct {
     U16 work[288];   /* work area for code table building */
     code codes[ENOUGH];         /* space for code tables */
     I32 sane;                   /* if false, allow invalid distance too far */
+    I32 count;                  /* if true, count output but don't write it */
     I32 back;                   /* bits back of last unprocessed length/lit */
     U32 was;               /* initial length of match */
 } inflate_state;
@@ -23,7 +23,8 @@
  *
  * Modified version of zlib.h for safety-critical applications.
  * Modifications:
- *   * Removed gzip and compress functions, deflateCopy, inflateCopy, crc combine.
+ *   * Removed gzip and compress functions, crc combine.
+ *   * deflateCopy, inflateCopy replaced by deflateCopyTo, inflateCopyTo.
  *   * Added functions for sizing work buffers for deflation and inflation.
  *   * Various modifications per MISRA and P10 guidelines.
  * Original file header follows.
@@ -577,8 +578,59 @@ ZlibReturn deflateGetDictionary (z_stream * strm,
    stream state is inconsistent.
 */
 
-// Abcouwer ZSC - removed deflateCopy
-// copying then doing allocs will spool more memory from the work buffer.
+ZlibReturn deflateCopyTo (z_stream * dest, z_stream * source);
+/*
+     Sets the destination stream as a complete copy of the source stream.
+   Abcouwer ZSC - replaces deflateCopy.  Rather than allocating, the copy is
+   taken from the work buffer that the application has set in dest->next_work
+   and dest->avail_work, which must be at least the deflateWorkSize2() of the
+   source's windowBits and memLevel.  All other fields of dest are overwritten.
+
+     This function can be useful when several compression strategies will be
+   tried, for example when there are several ways of pre-processing the input
+   data with a filter, or when many messages share a common prefix or
+   dictionary: prime one stream once, then copy it for each message.  The
+   streams that will be discarded should then be abandoned (or ended with
+   deflateEnd); their work buffers may be reused.
+
+     deflateCopyTo returns Z_OK if success, or Z_STREAM_ERROR if the source
+   stream state was inconsistent, dest was Z_NULL or the same as source, or
+   dest's work buffer was missing or too small.  msg is left unchanged in both
+   source and destination.
+*/
+
+ZlibReturn deflateStateImageBound (I32 windowBits, I32 memLevel,
+                                   U32 *size_out);
+ZlibReturn deflateSaveState (z_stream * strm, U8 *image, U32 *image_len);
+ZlibReturn deflateLoadState (z_stream * strm, const U8 *image,
+                             U32 image_len);
+/*
+     Abcouwer ZSC - checkpoint and resume a deflate stream.  deflateSaveState
+   writes the complete stream state -- the state, the live part of the
+   window, the hash tables, and pending output and symbols -- into a compact
+   byte image with no pointers in it, protected by a CRC-32.  On entry,
+   *image_len is the size of image; on return it is the size written.  The
+   image can be kept, for example in non-volatile memory, and later restored
+   with deflateLoadState into any work buffer, after which deflate continues
+   exactly as the saved stream would have.  deflateStateImageBound gives the
+   largest image for the windowBits and memLevel given to deflateInit2.
+
+     For deflateLoadState, the application sets strm->next_work and
+   strm->avail_work as for deflateInit2; all other fields of strm are
+   overwritten.  total_in says how much of the input has been consumed, so
+   the application resumes with the input that follows.  next_in and next_out
+   are set to Z_NULL, and must be provided before calling deflate.  A gzip
+   header set with deflateSetHeader is not saved, so a stream with such a
+   header cannot be saved until deflate has written it.  Images are only
+   compatible with the same build of the library.
+
+     deflateSaveState returns Z_OK if success, Z_BUF_ERROR if the image buffer
+   was too small (with *image_len set to the size needed), or Z_STREAM_ERROR if
+   the stream state was inconsistent or the gzip header is not yet written.
+   deflateLoadState returns Z_OK if success, Z_DATA_ERROR if the image is
+   corrupt or from a different build, or Z_STREAM_ERROR if the work buffer
+   was missing or too small.
+*/
 
 ZlibReturn deflateReset (z_stream * strm);
 /*
@@ -619,6 +671,12 @@ ZlibReturn deflateParams (z_stream * strm,
    compressed before deflateParams(), and the new level and strategy will be
    applied to the the data compressed after deflateParams().
 
+     Abcouwer ZSC - If all input consumed so far has already been compressed
+   and flushed, as right after deflate() with Z_SYNC_FLUSH or Z_FULL_FLUSH,
+   the deflate(strm, Z_BLOCK) would have nothing to do and is skipped.  The
+   change then takes effect without writing any output, even if avail_out is
+   zero.
+
      deflateParams returns Z_OK on success, Z_STREAM_ERROR if the source stream
    state was inconsistent or if a parameter was invalid, or Z_BUF_ERROR if
    there was not enough output space to complete the compression of the
@@ -645,6 +703,53 @@ ZlibReturn deflateTune (z_stream * strm,
    returns Z_OK on success, or Z_STREAM_ERROR for an invalid deflate stream.
  */
 
+ZlibReturn deflateAccel (z_stream * strm, I32 accel);
+/*
+     Abcouwer ZSC - Let the fast compression levels (1 to 3) skip through
+   input that is not matching.  After each position without a match, deflate
+   steps ahead by one more byte for every 2^(7 - accel) consecutive misses,
+   emitting the skipped bytes as literals without hashing or searching them.
+   The step returns to one byte as soon as a match is found.  accel is 0 (the
+   default, no skipping) to 7 (the step grows with every miss); higher values
+   are faster on poorly compressible data and lose more matches.  Has no
+   effect at levels 4 to 9.
+
+     deflateAccel() can be called after deflateInit() or deflateInit2(), and
+   like deflateTune() is undone by deflateReset().  It returns Z_OK on
+   success, or Z_STREAM_ERROR for an invalid deflate stream or accel.
+ */
+
+ZlibReturn deflateAdaptChain (z_stream * strm, I32 adapt);
+/*
+     Abcouwer ZSC - If adapt is nonzero, let the hash chain search limit adapt
+   to the input.  Deflate keeps track of how much match length the deeper half
+   of each chain search gains.  When deep searches rarely find a longer match,
+   as on spreadsheets and other tabular data, the limit is halved; when they
+   often do, it is doubled.  The limit stays between a floor set by the level
+   and the level's max_chain (or that set by deflateTune()).  This mostly
+   speeds up levels 7 to 9, which search long chains.
+
+     deflateAdaptChain() can be called after deflateInit() or deflateInit2(),
+   and like deflateTune() is undone by deflateReset().  It returns Z_OK on
+   success, or Z_STREAM_ERROR for an invalid deflate stream.
+ */
+
+ZlibReturn deflateFastRuns (z_stream * strm, I32 fast_runs);
+/*
+     Abcouwer ZSC - If fast_runs is nonzero, let the lazy compression levels
+   (4 to 9) get through long runs of one repeated byte, such as zeroed memory,
+   without searching them.  Wherever the next 258 bytes all repeat the byte
+   before them, a maximal match at distance one is emitted directly.  This is
+   much faster on sparse data, but the output can be larger: a match that
+   would have started inside a run and continued past its end is lost, and
+   the run is not entered in the hash table for later matches.  Off by
+   default.  Has no effect at levels 1 to 3.
+
+     deflateFastRuns() can be called after deflateInit() or deflateInit2(),
+   and like deflateTune() is undone by deflateReset().  It returns Z_OK on
+   success, or Z_STREAM_ERROR for an invalid deflate stream.
+ */
+
 U32 deflateBound (z_stream * strm,
                                        U32 sourceLen);
 /*
@@ -872,8 +977,50 @@ ZlibReturn inflateSync (z_stream * strm);
    input each time, until success or end of the input data.
 */
 
-// Abcouwer ZSC - removed inflateCopy
-// copying then doing allocs will spool more memory from the work buffer.
+ZlibReturn inflateCopyTo (z_stream * dest, z_stream * source);
+/*
+     Sets the destination stream as a complete copy of the source stream.
+   Abcouwer ZSC - replaces inflateCopy.  Rather than allocating, the copy is
+   taken from the work buffer that the application has set in dest->next_work
+   and dest->avail_work, which must be at least the inflateWorkSize2() of the
+   source's windowBits.  All other fields of dest are overwritten.
+
+     This function can be useful when randomly accessing a large stream.  The
+   first pass through the stream can periodically record the inflate state,
+   allowing restarting inflate at those points when randomly accessing the
+   stream.  It can also fork a stream primed with a dictionary or a shared
+   prefix into many messages.
+
+     inflateCopyTo returns Z_OK if success, or Z_STREAM_ERROR if the source
+   stream state was inconsistent, dest was Z_NULL or the same as source, or
+   dest's work buffer was missing or too small.  msg is left unchanged in both
+   source and destination.
+*/
+
+ZlibReturn inflateStateImageBound (I32 windowBits, U32 *size_out);
+ZlibReturn inflateSaveState (z_stream * strm, U8 *image, U32 *image_len);
+ZlibReturn inflateLoadState (z_stream * strm, const U8 *image,
+                             U32 image_len);
+/*
+     Abcouwer ZSC - checkpoint and resume an inflate stream, as with
+   deflateSaveState and deflateLoadState.  The image holds the state and the
+   valid part of the window.  inflateStateImageBound gives the largest image
+   for the windowBits given to inflateInit2.
+
+     For inflateLoadState, the application sets strm->next_work and
+   strm->avail_work as for inflateInit2; all other fields of strm are
+   overwritten.  total_in and total_out say where to resume the input and
+   output.  A gzip header requested with inflateGetHeader is not saved, so a
+   stream with such a request cannot be saved until the header has been
+   read; call inflateGetHeader again after loading if needed.
+
+     inflateSaveState returns Z_OK if success, Z_BUF_ERROR if the image buffer
+   was too small (with *image_len set to the size needed), or Z_STREAM_ERROR if
+   the stream state was inconsistent or the gzip header is not yet read.
+   inflateLoadState returns Z_OK if success, Z_DATA_ERROR if the image is
+   corrupt or from a different build, or Z_STREAM_ERROR if the work buffer
+   was missing or too small.
+*/
 
 ZlibReturn inflateReset (z_stream * strm);
 /*
@@ -989,6 +1136,28 @@ ZlibReturn inflateGetHeader (z_stream * strm,
    stream state was inconsistent.
 */
 
+ZlibReturn inflateCount (z_stream * strm, I32 count);
+/*
+     Abcouwer ZSC - inflateCount() puts inflate() in counting mode if count is
+   true.  In counting mode, the stream is fully decoded and checked for
+   validity, but no literal, match, or stored bytes are written to next_out,
+   and no sliding window is kept.  avail_out and total_out advance as if the
+   data had been written, so setting avail_out to U32_MAX and decoding to the
+   end of the stream gives the uncompressed length in total_out.  next_out
+   must still be non-null, but is not written to or advanced.  Since the data
+   is not available, the check value of the data is not computed or
+   validated while counting.  Unlike inflateValidate(strm, 0), this does not
+   outlast counting mode.  Distances are still checked against the amount of
+   output so far.
+
+     inflateCount() must be called after inflateInit2() or inflateReset(),
+   and before the first call of inflate().  Counting mode is cleared by
+   inflateReset().
+
+     inflateCount returns Z_OK if success, or Z_STREAM_ERROR if the source
+   stream state was inconsistent.
+*/
+
 /*
 int inflateBackInit (z_stream * strm, int windowBits,
                                         unsigned U8 *window);
@@ -1175,6 +1344,19 @@ U32 adler32_z (U32 adler, const U8 *buf,
      Same as adler32(), but with a size_t length.
 */
 
+ZlibReturn adler32_multi (U32 *adlers, const U8 * const *bufs,
+                                     const z_size_t *lens, U32 count);
+/*
+     Update count independent running Adler-32 checksums at once.  For each i
+   less than count, adlers[i] is replaced by adler32_z(adlers[i], bufs[i],
+   lens[i]).  A Z_NULL bufs[i] sets adlers[i] to the initial value, as in
+   adler32().  This is a convenience for checking a batch of small messages;
+   it is no faster than separate adler32_z() calls.
+
+     adler32_multi returns Z_OK on success, or Z_STREAM_ERROR if adlers, bufs,
+   or lens is Z_NULL.
+*/
+
 /*
 U32 adler32_combine (U32 adler1, U32 adler2,
                                           z_off_t len2);
@@ -1210,6 +1392,22 @@ U32 crc32_z (U32 crc, const U8 *buf,
      Same as crc32(), but with a size_t length.
 */
 
+ZlibReturn crc32_multi (U32 *crcs, const U8 * const *bufs,
+                                   const z_size_t *lens, U32 count);
+/*
+     Update count independent running CRC-32s at once.  For each i less than
+   count, crcs[i] is replaced by crc32_z(crcs[i], bufs[i], lens[i]).  A Z_NULL
+   bufs[i] sets crcs[i] to the initial value, as in crc32().  The buffers are
+   processed four at a time in lockstep, which is faster than separate calls
+   when there are many short buffers, as when checking a batch of small
+   messages or frame CRCs.  Buffers of similar length benefit most; the part
+   of each buffer beyond the shortest in its group of four is finished one
+   buffer at a time.
+
+     crc32_multi returns Z_OK on success, or Z_STREAM_ERROR if crcs, bufs, or
+   lens is Z_NULL.
+*/
+
 /*
 U32 crc32_combine (U32 crc1, U32 crc2, z_off_t len2);
 
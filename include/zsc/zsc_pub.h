@@ -75,6 +75,184 @@
 extern "C" {
 #endif
 
+/**
+ * @brief One segment of a scatter/gather list of output buffers
+ */
+typedef struct zsc_iovec_s {
+    U8 *base; /**< start of the segment */
+    U32 len;  /**< length of the segment, in bytes */
+} zsc_iovec;
+
+/**
+ * @brief One segment of a scatter/gather list of input buffers
+ */
+typedef struct zsc_const_iovec_s {
+    const U8 *base; /**< start of the segment */
+    U32 len;        /**< length of the segment, in bytes */
+} zsc_const_iovec;
+
+/**
+ * @brief Layout of the zsc info subfield of a gzip extra field
+ * The subfield is the two ID bytes, a two byte little-endian length,
+ * then the source_len, num_blocks, and max_block_len of a zsc_info,
+ * each as a four byte little-endian value.
+ */
+enum {
+    ZSC_INFO_SI1 = 'Z', ///< first subfield ID byte
+    ZSC_INFO_SI2 = 'S', ///< second subfield ID byte
+    ZSC_INFO_DATA_LEN = 12, ///< length of subfield data
+    ZSC_INFO_SUBFIELD_LEN = 4 + ZSC_INFO_DATA_LEN, ///< length with ID and length
+    ZSC_INFO_HEADER_LEN = 2 + ZSC_INFO_SUBFIELD_LEN, ///< max growth of header
+    ZSC_INFO_EXTRA_MAX = 256 ///< max length of the extra field, with info
+};
+
+/**
+ * @brief Sizes describing a buffer compressed with zsc_compress_gzip_info2()
+ */
+typedef struct zsc_info_s {
+    U32 source_len;    /**< uncompressed size, in bytes */
+    U32 num_blocks;    /**< number of max_block_len sections of the input */
+    U32 max_block_len; /**< max_block_len used for compression */
+} zsc_info;
+
+/**
+ * @brief One message of a batch for zsc_uncompress_batch()
+ */
+typedef struct zsc_batch_item_s {
+    const U8 *source; /**< compressed message */
+    U32 source_len;   /**< in: length of source; out: bytes processed */
+    U8 *dest;         /**< output slot */
+    U32 dest_len;     /**< in: length of dest; out: bytes decompressed */
+    ZlibReturn err;   /**< out: Z_OK if this message decompressed */
+} zsc_batch_item;
+
+/**
+ * @brief One configuration tried on each block by zsc_compress_race()
+ */
+typedef struct zsc_race_entry_s {
+    I32 level;             /**< compression level */
+    ZlibStrategy strategy; /**< compression strategy */
+} zsc_race_entry;
+
+/**
+ * @brief Reversible filters applied to each block of input before deflate
+ */
+typedef enum {
+    ZSC_FILTER_NONE = 0,     ///< input is deflated as is
+    ZSC_FILTER_DELTA = 1,    ///< difference of each byte from width bytes back
+    ZSC_FILTER_XOR = 2,      ///< xor of each byte with the one width bytes back
+    ZSC_FILTER_TRANSPOSE = 3, ///< byte b of every width byte record together,
+                              ///< the byte shuffle of width byte elements
+    ZSC_FILTER_PNG = 4        ///< PNG predictor chosen per stride byte row,
+                              ///< for width byte pixels. Adds a byte per row.
+} zsc_filter_type;
+
+/**
+ * @brief PNG predictors, as stored in the byte ahead of each row
+ */
+enum {
+    ZSC_PNG_NONE = 0,    ///< pixel as is
+    ZSC_PNG_SUB = 1,     ///< less the pixel to the left
+    ZSC_PNG_UP = 2,      ///< less the pixel above
+    ZSC_PNG_AVERAGE = 3, ///< less the mean of left and above
+    ZSC_PNG_PAETH = 4    ///< less the Paeth prediction
+};
+
+/**
+ * @brief A filter and its parameters
+ */
+typedef struct zsc_filter_s {
+    zsc_filter_type type; /**< which filter */
+    U32 width;            /**< sample, record, or pixel width, in bytes */
+    U32 stride;           /**< row length in bytes, for ZSC_FILTER_PNG,
+                               at most ZSC_FILTER_MAX_STRIDE */
+} zsc_filter;
+
+/**
+ * @brief Layout of the header ahead of a filtered deflate stream
+ * The two ID bytes, the version, the filter type, then the filter width,
+ * the block length, and the filter stride, each as a four byte
+ * little-endian value.
+ */
+enum {
+    ZSC_FILTER_ID1 = 'Z', ///< first header ID byte
+    ZSC_FILTER_ID2 = 'F', ///< second header ID byte
+    ZSC_FILTER_VERSION = 1, ///< header version
+    ZSC_FILTER_HEADER_LEN = 16, ///< length of the header
+    ZSC_FILTER_MAX_WIDTH = 65535, ///< largest filter width
+    ZSC_FILTER_MAX_STRIDE = 16777216 ///< largest ZSC_FILTER_PNG row length
+};
+
+/**
+ * @brief Layout of a deduplicated container, and its chunk sizes
+ * The two ID bytes, the version, a reserved zero byte, then the source
+ * length, the number of chunks, the number of bytes in chunks stored
+ * in the deflate stream, and the number of those bytes between full
+ * flushes, each as a four byte little-endian value.
+ * A table follows with a length and an offset for each chunk. A chunk
+ * whose offset is its own position in the source is in the deflate stream,
+ * otherwise it is a copy of the bytes at that earlier offset.
+ * The deflate stream of the stored chunks comes last.
+ */
+enum {
+    ZSC_DEDUP_ID1 = 'Z', ///< first header ID byte
+    ZSC_DEDUP_ID2 = 'D', ///< second header ID byte
+    ZSC_DEDUP_VERSION = 2, ///< header version
+    ZSC_DEDUP_HEADER_LEN = 20, ///< length of the header
+    ZSC_DEDUP_ENTRY_LEN = 8, ///< length of a chunk table entry
+    ZSC_DEDUP_MIN_CHUNK = 2048, ///< shortest chunk, but for the last
+    ZSC_DEDUP_AVG_CHUNK = 8192, ///< typical chunk length, a power of two
+    ZSC_DEDUP_MAX_CHUNK = 65536 ///< longest chunk
+};
+
+/**
+ * @brief Sizes of a dictionary registry
+ */
+enum {
+    ZSC_DICT_MAX = 16,   ///< most dictionaries in a registry
+    ZSC_DICT_SLOTS = 32, ///< lookup slots, a power of two, twice the most
+    ZSC_DICT_MAX_LEN = 32768 ///< longest dictionary kept, the largest window
+};
+
+/**
+ * @brief A registered preset dictionary
+ */
+typedef struct zsc_dict_s {
+    const U8 *data; /**< dictionary, owned by the caller */
+    U32 len;        /**< length of data, in bytes */
+    U32 id;         /**< Adler-32 of data, the zlib DICTID */
+} zsc_dict;
+
+/**
+ * @brief Preset dictionaries, found by the DICTID in a zlib header
+ * Set up by zsc_dict_registry_init(), then filled by zsc_dict_register().
+ */
+typedef struct zsc_dict_registry_s {
+    zsc_dict dicts[ZSC_DICT_MAX]; /**< dictionaries, in registration order */
+    U32 num_dicts;                /**< number of dictionaries registered */
+    U8 slots[ZSC_DICT_SLOTS];     /**< index + 1 by hash of id, 0 if empty */
+} zsc_dict_registry;
+
+/**
+ * @brief State kept between frames by the reference frame functions
+ * Set up by zsc_compress_frame_init() or zsc_uncompress_frame_init(),
+ * then only read by the caller.
+ */
+typedef struct zsc_frame_s {
+    U8 *ref;               /**< tail of the previous frame, start of work */
+    U32 ref_len;           /**< bytes in ref, 0 if no reference is held */
+    U32 ref_max;           /**< room for ref, the window size */
+    U8 *work;              /**< working memory after ref */
+    U32 work_len;          /**< length of working memory after ref */
+    I32 level;             /**< compression level */
+    I32 window_bits;       /**< base two logarithm of the window size */
+    I32 mem_level;         /**< memory level for deflate */
+    ZlibStrategy strategy; /**< compression strategy */
+    U32 keyframe_interval; /**< frames from one keyframe to the next,
+                                0 for a keyframe only when needed */
+    U32 frames;            /**< frames since the last keyframe, counting it */
+} zsc_frame;
+
 /**
  * @brief Get minimum size of a work buffer, default compression settings
  * Returns the size of working memory that must be provided to a compression function
@@ -294,122 +472,1133 @@ ZlibReturn zsc_compress_gzip2(
         gz_header * gz_header);
 
 /**
- * @brief Get minimum size of a work buffer, default decompression settings
- * Returns the size of working memory that must be provided to a decompression
- * function using default settings.
+ * @brief Compress a buffer with a gzip header carrying zsc info
+ * As zsc_compress_gzip(), but with a zsc_info subfield placed at the front
+ * of the gzip extra field, ahead of any extra field in gz_header.
+ * The output remains a standard gzip stream.
+ * The output may be up to ZSC_INFO_HEADER_LEN bytes larger than the size
+ * given by get_max_output_size_gzip().
  *
- * @param size_out  Minimum size required for working memory
- * @return Z_OK if there was no error
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress_gzip().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), compression will fail.
+ * @param level         Compression level
+ * @param gz_header *    Pointer to a GZip header, or Z_NULL for a default one.
+ *                      Its extra field, if any, must be no longer than
+ *                      ZSC_INFO_EXTRA_MAX - ZSC_INFO_SUBFIELD_LEN bytes.
+ * @return Z_OK if compression succeeded, an error code otherwise.
  */
-ZlibReturn zsc_uncompress_get_min_work_buf_size(U32 *size_out);
+ZlibReturn zsc_compress_gzip_info(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        gz_header * gz_header);
 
 /**
- * @brief Get minimum size of a work buffer, custom window size
- * Returns the size of working memory that must be provided to a decompression
- * function using default settings.
+ * @brief Compress a buffer with custom settings and a gzip header
+ * carrying zsc info
+ * As zsc_compress_gzip2(), but with a zsc_info subfield placed at the front
+ * of the gzip extra field, ahead of any extra field in gz_header.
+ * The output remains a standard gzip stream.
+ * The output may be up to ZSC_INFO_HEADER_LEN bytes larger than the size
+ * given by get_max_output_size_gzip2().
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress_gzip2().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), compression will fail.
+ * @param level         Compression level
+ * @param window_bits   the base two logarithm of the window size, plus 16.
+ *                      Must specify a gzip wrapper.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param strategy      Compression strategy
+ * @param gz_header *    Pointer to a GZip header, or Z_NULL for a default one.
+ *                      Its extra field, if any, must be no longer than
+ *                      ZSC_INFO_EXTRA_MAX - ZSC_INFO_SUBFIELD_LEN bytes.
+ * @return Z_OK if compression succeeded, Z_STREAM_ERROR if the wrapper
+ *         is not gzip, an error code otherwise.
+ */
+ZlibReturn zsc_compress_gzip_info2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header);
+
+/**
+ * @brief Compress a scatter/gather list of buffers
+ * Equivalent to zsc_compress() on the concatenation of the source segments,
+ * with the output written across the dest segments in order.
+ * Segments may have any length, including zero.
+ *
+ * @param dest          Array of output segments
+ * @param dest_cnt      Number of output segments
+ * @param dest_len      After call, gets the total size of compressed output.
+ * @param source        Array of input segments
+ * @param source_cnt    Number of input segments
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), compression will fail.
+ * @param level         Compression level
+ * @return Z_OK if compression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_compress_iov(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level);
+
+/**
+ * @brief Compress a scatter/gather list of buffers with custom settings
+ * and a gzip header
+ * Equivalent to zsc_compress_gzip2() on the concatenation of the source
+ * segments, with the output written across the dest segments in order.
+ * Block boundaries fall every max_block_len bytes of the concatenated input,
+ * regardless of where the segment boundaries are.
  *
+ * @param dest          Array of output segments
+ * @param dest_cnt      Number of output segments
+ * @param dest_len      After call, gets the total size of compressed output.
+ * @param source        Array of input segments
+ * @param source_cnt    Number of input segments
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress_gzip2().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), compression will fail.
+ * @param level         Compression level
  * @param window_bits   the base two logarithm of the window size.
  *                      Should be in the range 9 to 15.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param strategy      Compression strategy
+ * @param gz_header *    Pointer to a GZip header
+ * @return Z_OK if compression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_compress_iov_gzip2(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header);
+
+/**
+ * @brief Get minimum size of a work buffer for zsc_compress_race()
+ * Three deflate states plus two blocks of output.
+ *
+ * @param max_block_len Maximum length of a compressed output.
+ * @param window_bits   the base two logarithm of the window size.
+ *                      May carry the raw or gzip wrapper offsets.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
  * @param size_out      Minimum size required for working memory
- * @return  Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ * @return Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
  */
-ZlibReturn zsc_uncompress_get_min_work_buf_size2(
-        I32 window_bits, U32 *size_out);
+ZlibReturn zsc_compress_race_get_min_work_buf_size(
+        U32 max_block_len, I32 window_bits, I32 mem_level, U32 *size_out);
 
 /**
- * @brief Decompress a buffer.
- * If some blocks were found to have a data error, but there were no other issues,
- * The function will return Z_DATA_ERROR and fill the output buffer with the
- * blocks that did not have errors.
+ * @brief Compress a buffer, choosing the best configuration per block
+ * Each max_block_len section of the input is compressed once with every
+ * entry, each from a copy of the same state, and the smallest result is
+ * kept. All entries then continue from the winner's state. Blocks are
+ * separated by full flushes, which discard the match history, so the choice
+ * for one block does not affect the next, and the output is never larger
+ * than zsc_compress_race() given any one of the entries alone. This is not
+ * a bound against zsc_compress2(), whose blocks can come out differently.
+ * The output is decompressed like that of zsc_compress2().
+ * Costs roughly num_entries times the time of a single configuration.
  *
  * @param dest          Output buffer
  * @param dest_len      Length of output buffer, in bytes
- *                      If smaller than the size of the compressed data,
- *                      compression will fail.
- *                      It is up to the client to decide how appropriately size
- *                      this buffer.
- *                      After call, gets the size of decompressed output.
- * @param source        Input compressed buffer
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
  * @param source_len    Length of input buffer, in bytes
- *                      After call, gets number of bytes actually processed.
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
  * @param work          Working memory
  * @param work_len      Length of work buffer. If less than size given by
- *                      get_min_work_buf_size(), decompression will fail.
- * @return Z_OK if decompression succeeded, an error code otherwise.
+ *                      zsc_compress_race_get_min_work_buf_size(),
+ *                      compression will fail.
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Add 16 for a gzip wrapper, or negate for raw deflate.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param entries       Configurations to race, or Z_NULL for level 6 with
+ *                      Z_DEFAULT_STRATEGY, Z_FILTERED, Z_RLE, and
+ *                      Z_HUFFMAN_ONLY.
+ * @param num_entries   Number of entries, ignored if entries is Z_NULL.
+ * @return Z_OK if compression succeeded, an error code otherwise.
  */
-ZlibReturn zsc_uncompress(
-        U8 *dest, U32 *dest_len, const U8 *source,
-        U32 *source_len, U8 *work, U32 work_len);
+ZlibReturn zsc_compress_race(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len,
+        I32 window_bits, I32 mem_level,
+        const zsc_race_entry *entries, U32 num_entries);
 
 /**
- * @brief Decompress a buffer with a gzip header.
+ * @brief Get minimum size of a work buffer for zsc_compress_verify2()
+ * A deflate state, an inflate state, and a small scratch buffer.
+ *
+ * @param window_bits   the base two logarithm of the window size.
+ *                      May carry the raw or gzip wrapper offsets.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param size_out      Minimum size required for working memory
+ * @return Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ */
+ZlibReturn zsc_compress_verify_get_min_work_buf_size2(I32 window_bits,
+        I32 mem_level, U32 *size_out);
+
+/**
+ * @brief Compress a buffer with default settings, checking the output
+ * Equivalent to zsc_compress_verify2() with default settings.
+ *
  * @param dest          Output buffer
  * @param dest_len      Length of output buffer, in bytes
- *                      If smaller than the size of the compressed data,
- *                      compression will fail.
- *                      It is up to the client to decide how appropriately size
- *                      this buffer.
- *                      After call, gets the size of decompressed output.
- * @param source        Input compressed buffer
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
  * @param source_len    Length of input buffer, in bytes
- *                      After call, gets number of bytes actually processed.
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
  * @param work          Working memory
  * @param work_len      Length of work buffer. If less than size given by
- *                      get_min_work_buf_size(), decompression will fail.
- * @param gz_head       Pointer to where the gzip wrapper will be saved.
- * @return Z_OK if decompression succeeded, an error code otherwise.
+ *                      zsc_compress_verify_get_min_work_buf_size2(),
+ *                      compression will fail.
+ * @param level         Compression level
+ * @param bad_block     After call, gets the index of the first block that
+ *                      failed verification, or U32_MAX if none did.
+ * @return Z_OK if compression and verification succeeded,
+ *         Z_DATA_ERROR if verification failed, an error code otherwise.
  */
-ZlibReturn zsc_uncompress_gzip(
-        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
-        U8 *work, U32 work_len, gz_header * gz_head);
+ZlibReturn zsc_compress_verify(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        U32 *bad_block);
 
 /**
- * @brief Decompress a buffer with a custom window size.
+ * @brief Compress a buffer with custom settings, checking the output
+ * Same as zsc_compress_gzip2(), but after each deflate() call the output
+ * just produced is inflated and compared against the source, while both are
+ * still in cache. Verification runs inline, in the same pass, at roughly
+ * the cost of a decompression. The inflate state and its scratch output
+ * come from the end of the work buffer.
+ *
  * @param dest          Output buffer
  * @param dest_len      Length of output buffer, in bytes
- *                      If smaller than the size of the compressed data,
- *                      compression will fail.
- *                      It is up to the client to decide how appropriately size
- *                      this buffer.
- *                      After call, gets the size of decompressed output.
- * @param source        Input compressed buffer
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
  * @param source_len    Length of input buffer, in bytes
- *                      After call, gets number of bytes actually processed.
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
  * @param work          Working memory
  * @param work_len      Length of work buffer. If less than size given by
- *                      get_min_work_buf_size(), decompression will fail.
+ *                      zsc_compress_verify_get_min_work_buf_size2(),
+ *                      compression will fail.
+ * @param level         Compression level
  * @param window_bits   the base two logarithm of the window size.
- *                      Should be in the range 9 to 15.
- * @return Z_OK if decompression succeeded, an error code otherwise.
+ *                      Add 16 for a gzip wrapper, or negate for raw deflate.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param strategy      Compression strategy
+ * @param gz_header     Pointer to a GZip header, or Z_NULL
+ * @param bad_block     After call, gets the index of the first
+ *                      max_block_len block of the source that failed
+ *                      verification, or U32_MAX if none did.
+ * @return Z_OK if compression and verification succeeded,
+ *         Z_DATA_ERROR if verification failed, an error code otherwise.
  */
-ZlibReturn zsc_uncompress2(
-        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
-        U8 *work, U32 work_len, I32 window_bits);
+ZlibReturn zsc_compress_verify2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header, U32 *bad_block);
 
 /**
- * @brief Decompress a buffer with a GZIP wrapper and a custom window size.
+ * @brief Get minimum size of a work buffer for zsc_compress_filter2()
+ * A deflate state plus one block of filtered input.
+ *
+ * @param max_block_len Maximum length of a compressed output.
+ * @param window_bits   the base two logarithm of the window size.
+ *                      May carry the raw or gzip wrapper offsets.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param filter        Filter to apply
+ * @param size_out      Minimum size required for working memory
+ * @return Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ */
+ZlibReturn zsc_compress_filter_get_min_work_buf_size2(U32 max_block_len,
+        I32 window_bits, I32 mem_level, const zsc_filter *filter,
+        U32 *size_out);
+
+/**
+ * @brief Compress a buffer with default settings, filtering each block
+ * Equivalent to zsc_compress_filter2() with default settings.
+ *
  * @param dest          Output buffer
  * @param dest_len      Length of output buffer, in bytes
- *                      If smaller than the size of the compressed data,
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      zsc_compress_filter_get_min_work_buf_size2(),
  *                      compression will fail.
- *                      It is up to the client to decide how appropriately size
- *                      this buffer.
- *                      After call, gets the size of decompressed output.
- * @param source        Input compressed buffer
- * @param source_len    Length of input buffer, in bytes.
- *                      After call, gets number of bytes actually processed.
+ * @param level         Compression level
+ * @param filter        Filter to apply
+ * @return Z_OK if compression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_compress_filter(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        const zsc_filter *filter);
+
+/**
+ * @brief Compress a buffer with custom settings, filtering each block
+ * Each max_block_len section of the input is passed through the filter into
+ * the end of the work buffer, then deflated and full flushed as in
+ * zsc_compress2(). The filter starts over on each section, so sections stay
+ * independent. The output starts with a ZSC_FILTER_HEADER_LEN byte header
+ * giving the filter and block length, followed by the deflate stream.
+ * For ZSC_FILTER_TRANSPOSE, max_block_len should be a multiple of the width,
+ * and for ZSC_FILTER_PNG, a multiple of the stride. Since ZSC_FILTER_PNG
+ * adds a byte per row, dest should allow for the length given by
+ * zsc_filter_get_encoded_len().
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output,
+ *                      and the length of each filtered section.
  * @param work          Working memory
  * @param work_len      Length of work buffer. If less than size given by
- *                      get_min_work_buf_size(), decompression will fail.
+ *                      zsc_compress_filter_get_min_work_buf_size2(),
+ *                      compression will fail.
+ * @param level         Compression level
  * @param window_bits   the base two logarithm of the window size.
- *                      Should be in the range 9 to 15.
- * @param gz_head       Pointer to where the gzip wrapper will be saved.
- * @return Z_OK if decompression succeeded, an error code otherwise.
+ *                      Add 16 for a gzip wrapper, or negate for raw deflate.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param strategy      Compression strategy
+ * @param filter        Filter to apply
+ * @return Z_OK if compression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_compress_filter2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        const zsc_filter *filter);
+
+/**
+ * @brief Get minimum size of a work buffer, default decompression settings
+ * Returns the size of working memory that must be provided to a decompression
+ * function using default settings.
+ *
+ * @param size_out  Minimum size required for working memory
+ * @return Z_OK if there was no error
+ */
+ZlibReturn zsc_uncompress_get_min_work_buf_size(U32 *size_out);
+
+/**
+ * @brief Get minimum size of a work buffer, custom window size
+ * Returns the size of working memory that must be provided to a decompression
+ * function using default settings.
+ *
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Should be in the range 9 to 15.
+ * @param size_out      Minimum size required for working memory
+ * @return  Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ */
+ZlibReturn zsc_uncompress_get_min_work_buf_size2(
+        I32 window_bits, U32 *size_out);
+
+/**
+ * @brief Get the size of a buffer once decompressed, default window size
+ * Decodes the buffer without writing any output, to find the exact
+ * size of the output buffer that zsc_uncompress() needs.
+ * Check values are not validated, since the output isn't produced.
+ *
+ * @param source        Input compressed buffer
+ * @param source_len    Length of input buffer, in bytes.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), the call will fail.
+ * @param size_out      Size of the decompressed data.
+ *                      On error, the size decoded before the error.
+ * @return Z_OK if the size was found, Z_DATA_ERROR if the stream is corrupt,
+ *         Z_BUF_ERROR if it is truncated, or another error code.
+ */
+ZlibReturn zsc_uncompress_get_size(
+        const U8 *source, U32 source_len, U8 *work, U32 work_len,
+        U32 *size_out);
+
+/**
+ * @brief Get the size of a buffer once decompressed, custom window size
+ * Decodes the buffer without writing any output, to find the exact
+ * size of the output buffer that zsc_uncompress2() or zsc_uncompress_gzip2()
+ * needs. Check values are not validated, since the output isn't produced.
+ *
+ * @param source        Input compressed buffer
+ * @param source_len    Length of input buffer, in bytes.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size2(), the call will fail.
+ * @param window_bits   the base two logarithm of the window size,
+ *                      plus 16 for a gzip wrapper.
+ * @param size_out      Size of the decompressed data.
+ *                      On error, the size decoded before the error.
+ * @return Z_OK if the size was found, Z_DATA_ERROR if the stream is corrupt,
+ *         Z_BUF_ERROR if it is truncated, or another error code.
+ */
+ZlibReturn zsc_uncompress_get_size2(
+        const U8 *source, U32 source_len, U8 *work, U32 work_len,
+        I32 window_bits, U32 *size_out);
+
+/**
+ * @brief Read the zsc info from the gzip header of a compressed buffer
+ * Parses only the gzip header, without decompressing.
+ * If the header has a crc (FHCRC), it is checked. Without one, the info
+ * is unchecked, and should be used only as a hint.
+ *
+ * @param source        Input compressed buffer
+ * @param source_len    Length of input buffer, in bytes.
+ * @param info          Gets the info, if present.
+ * @return Z_OK if the info was found, Z_DATA_ERROR if the buffer is not
+ *         gzip, has no info subfield, or fails its header crc,
+ *         Z_BUF_ERROR if the header is truncated.
+ */
+ZlibReturn zsc_uncompress_get_info(
+        const U8 *source, U32 source_len, zsc_info *info);
+
+/**
+ * @brief Decompress a buffer.
+ * If some blocks were found to have a data error, but there were no other issues,
+ * The function will return Z_DATA_ERROR and fill the output buffer with the
+ * blocks that did not have errors.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      If smaller than the size of the compressed data,
+ *                      compression will fail.
+ *                      It is up to the client to decide how appropriately size
+ *                      this buffer.
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input compressed buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets number of bytes actually processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), decompression will fail.
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress(
+        U8 *dest, U32 *dest_len, const U8 *source,
+        U32 *source_len, U8 *work, U32 work_len);
+
+/**
+ * @brief Decompress a buffer with a gzip header.
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      If smaller than the size of the compressed data,
+ *                      compression will fail.
+ *                      It is up to the client to decide how appropriately size
+ *                      this buffer.
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input compressed buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets number of bytes actually processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), decompression will fail.
+ * @param gz_head       Pointer to where the gzip wrapper will be saved.
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_gzip(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, gz_header * gz_head);
+
+/**
+ * @brief Decompress a buffer with a custom window size.
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      If smaller than the size of the compressed data,
+ *                      compression will fail.
+ *                      It is up to the client to decide how appropriately size
+ *                      this buffer.
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input compressed buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets number of bytes actually processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), decompression will fail.
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Should be in the range 9 to 15.
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits);
+
+/**
+ * @brief Decompress a buffer with a GZIP wrapper and a custom window size.
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      If smaller than the size of the compressed data,
+ *                      compression will fail.
+ *                      It is up to the client to decide how appropriately size
+ *                      this buffer.
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input compressed buffer
+ * @param source_len    Length of input buffer, in bytes.
+ *                      After call, gets number of bytes actually processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), decompression will fail.
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Should be in the range 9 to 15.
+ * @param gz_head       Pointer to where the gzip wrapper will be saved.
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ *         If the gzip header carries zsc info (see zsc_compress_gzip_info2())
+ *         and a header crc, and dest_len is smaller than the size it gives,
+ *         returns Z_BUF_ERROR before decompressing.
  */
 ZlibReturn zsc_uncompress_gzip2(
         U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
         U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head);
 
+/**
+ * @brief Decompress a scatter/gather list of buffers.
+ * Equivalent to zsc_uncompress() on the concatenation of the source segments,
+ * with the output written across the dest segments in order.
+ *
+ * @param dest          Array of output segments
+ * @param dest_cnt      Number of output segments
+ * @param dest_len      After call, gets the total size of decompressed output.
+ * @param source        Array of input segments
+ * @param source_cnt    Number of input segments
+ * @param source_len    After call, gets number of bytes actually processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), decompression will fail.
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_iov(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt, U32 *source_len,
+        U8 *work, U32 work_len);
+
+/**
+ * @brief Decompress a scatter/gather list of buffers with a GZIP wrapper
+ * and a custom window size.
+ * Equivalent to zsc_uncompress_gzip2() on the concatenation of the source
+ * segments, with the output written across the dest segments in order.
+ *
+ * @param dest          Array of output segments
+ * @param dest_cnt      Number of output segments
+ * @param dest_len      After call, gets the total size of decompressed output.
+ * @param source        Array of input segments
+ * @param source_cnt    Number of input segments
+ * @param source_len    After call, gets number of bytes actually processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), decompression will fail.
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Should be in the range 9 to 15.
+ * @param gz_head       Pointer to where the gzip wrapper will be saved.
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_iov_gzip2(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head);
+
+/**
+ * @brief Decompress a batch of small messages with one inflate state.
+ * Each message is decompressed as by zsc_uncompress_gzip2() without a
+ * gz_head, but the work buffer is checked and the stream initialized once
+ * for the batch, then reset between messages. A message that fails is
+ * recorded in its item and the batch continues. Unlike
+ * zsc_uncompress_gzip2(), a corrupt message is not resynchronized.
+ *
+ * @param items         Array of messages. On return, each item's source_len,
+ *                      dest_len, and err are set.
+ * @param num_items     Number of messages
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size2(), the call will fail.
+ * @param window_bits   the base two logarithm of the window size,
+ *                      negative for raw deflate, or plus 16 for gzip.
+ * @param dictionary    Dictionary shared by the messages, or Z_NULL.
+ *                      Set up front for raw deflate, or when a zlib
+ *                      message asks for it. Not used with gzip.
+ * @param dict_len      Length of dictionary, in bytes.
+ * @return Z_OK if every message decompressed, the error of the first
+ *         message that failed, or an error code if the batch could not
+ *         be started, in which case every item gets that error.
+ */
+ZlibReturn zsc_uncompress_batch(
+        zsc_batch_item *items, U32 num_items, U8 *work, U32 work_len,
+        I32 window_bits, const U8 *dictionary, U32 dict_len);
+
+/**
+ * @brief Get minimum size of a work buffer for zsc_uncompress_filter2()
+ * An inflate state plus one block of filtered output.
+ *
+ * @param max_block_len max_block_len used for compression
+ * @param window_bits   the base two logarithm of the window size,
+ *                      negative for raw deflate, or plus 16 for gzip.
+ * @param filter        Filter used for compression
+ * @param size_out      Minimum size required for working memory
+ * @return Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ */
+ZlibReturn zsc_uncompress_filter_get_min_work_buf_size2(U32 max_block_len,
+        I32 window_bits, const zsc_filter *filter, U32 *size_out);
+
+/**
+ * @brief Decompress a buffer from zsc_compress_filter(), default settings
+ * Equivalent to zsc_uncompress_filter2() with default window_bits.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets the number of bytes processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer, see
+ *                      zsc_uncompress_filter_get_min_work_buf_size2().
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_filter(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len);
+
+/**
+ * @brief Decompress a buffer from zsc_compress_filter2()
+ * Reads the filter header, then inflates one block at a time into the end
+ * of the work buffer and applies the inverse filter on the way to dest.
+ * As with zsc_uncompress2(), a corrupted block is skipped by finding the next
+ * flush point; since each block was filtered on its own, the blocks after it
+ * are still recovered.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets the number of bytes processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer, see
+ *                      zsc_uncompress_filter_get_min_work_buf_size2().
+ * @param window_bits   the base two logarithm of the window size,
+ *                      negative for raw deflate, or plus 16 for gzip.
+ * @return Z_OK if decompression succeeded, Z_DATA_ERROR if the header or
+ *         a block was corrupt, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_filter2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits);
+
+/**
+ * @brief Check that a filter is known and its parameters are in range
+ *
+ * @param filter    Filter to check
+ * @return Z_OK if the filter can be applied, Z_STREAM_ERROR otherwise
+ */
+ZlibReturn zsc_filter_check(const zsc_filter *filter);
+
+/**
+ * @brief Get the length of a buffer once filtered
+ * The same as len, except for ZSC_FILTER_PNG, which adds a byte per
+ * whole row. A partial row at the end is left as is.
+ *
+ * @param filter    Filter to apply
+ * @param len       Length of the buffer, in bytes
+ * @param size_out  Length once filtered
+ * @return Z_OK, or Z_STREAM_ERROR if the filter is improper or the
+ *         length would overflow
+ */
+ZlibReturn zsc_filter_get_encoded_len(const zsc_filter *filter, U32 len,
+        U32 *size_out);
+
+/**
+ * @brief Get the length of a filtered buffer once the filter is inverted
+ *
+ * @param filter        Filter that was applied
+ * @param encoded_len   Length of the filtered buffer, in bytes
+ * @param size_out      Length once unfiltered
+ * @return Z_OK, Z_STREAM_ERROR if the filter is improper, or Z_DATA_ERROR
+ *         if no buffer filters to encoded_len bytes
+ */
+ZlibReturn zsc_filter_get_decoded_len(const zsc_filter *filter,
+        U32 encoded_len, U32 *size_out);
+
+/**
+ * @brief Apply a filter to a buffer
+ * The filter starts over at the start of the buffer.
+ *
+ * @param filter    Filter to apply
+ * @param dest      Output buffer, not overlapping source, with room for
+ *                  the length given by zsc_filter_get_encoded_len()
+ * @param source    Input buffer
+ * @param len       Length of the input buffer, in bytes
+ * @return Z_OK if the filter was applied, Z_STREAM_ERROR if it is improper
+ */
+ZlibReturn zsc_filter_encode(const zsc_filter *filter,
+        U8 *dest, const U8 *source, U32 len);
+
+/**
+ * @brief Invert a filter applied by zsc_filter_encode()
+ *
+ * @param filter    Filter that was applied
+ * @param dest      Output buffer, len bytes, not overlapping source
+ * @param source    Filtered buffer, of the length given by
+ *                  zsc_filter_get_encoded_len() for len
+ * @param len       Length of the output buffer, in bytes
+ * @return Z_OK if the filter was inverted, Z_STREAM_ERROR if it is improper,
+ *         Z_DATA_ERROR if a row of ZSC_FILTER_PNG has an unknown predictor,
+ *         in which case that row is copied as is
+ */
+ZlibReturn zsc_filter_decode(const zsc_filter *filter,
+        U8 *dest, const U8 *source, U32 len);
+
+/**
+ * @brief Get minimum size of a work buffer for zsc_compress_dedup2()
+ * A chunk hash table sized for source_len, plus a deflate state.
+ *
+ * @param source_len    Length of input buffer, in bytes
+ * @param window_bits   the base two logarithm of the window size.
+ *                      May carry the raw or gzip wrapper offsets.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param size_out      Minimum size required for working memory
+ * @return Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ */
+ZlibReturn zsc_compress_dedup_get_min_work_buf_size2(U32 source_len,
+        I32 window_bits, I32 mem_level, U32 *size_out);
+
+/**
+ * @brief Get maximum size of output from zsc_compress_dedup2()
+ * The header, a full chunk table, and the bound for deflating all of
+ * source_len, as if no chunk repeated.
+ *
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output.
+ * @param level         Compression level
+ * @param window_bits   the base two logarithm of the window size.
+ * @param mem_level     how much memory to use for internal state.
+ * @param size_out      Maximum size of output
+ * @return Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ */
+ZlibReturn zsc_compress_dedup_get_max_output_size2(U32 source_len,
+        U32 max_block_len, I32 level, I32 window_bits, I32 mem_level,
+        U32 *size_out);
+
+/**
+ * @brief Compress a buffer with default settings, storing repeats once
+ * Equivalent to zsc_compress_dedup2() with default settings.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      zsc_compress_dedup_get_min_work_buf_size2(),
+ *                      compression will fail.
+ * @param level         Compression level
+ * @return Z_OK if compression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_compress_dedup(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level);
+
+/**
+ * @brief Compress a buffer with custom settings, storing repeats once
+ * Splits the source into chunks where a rolling gear hash of the last
+ * 32 bytes hits a mask, so that chunk boundaries follow the content and
+ * a repeated region gives the same chunks wherever it sits. A chunk equal
+ * to an earlier one, however far back, is written as a reference to it.
+ * The remaining chunks are deflated as one stream, with a full flush
+ * every max_block_len bytes of them, as in zsc_compress_gzip2().
+ * See ZSC_DEDUP_HEADER_LEN for the layout.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      zsc_compress_dedup_get_min_work_buf_size2(),
+ *                      compression will fail.
+ * @param level         Compression level
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Add 16 for a gzip wrapper, or negate for raw deflate.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param strategy      Compression strategy
+ * @return Z_OK if compression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_compress_dedup2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy);
+
+/**
+ * @brief Decompress a buffer from zsc_compress_dedup(), default settings
+ * Equivalent to zsc_uncompress_dedup2() with default window_bits.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets the number of bytes processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer, see
+ *                      zsc_uncompress_get_min_work_buf_size().
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_dedup(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len);
+
+/**
+ * @brief Decompress a buffer from zsc_compress_dedup2()
+ * Walks the chunk table, inflating stored chunks into place and copying
+ * repeated ones from earlier in dest. dest must hold the whole source.
+ * As in zsc_uncompress_gzip2(), a corrupt stream is resynchronized at the
+ * next full flush. Inflation then resumes at the place of the block after
+ * the flush, so chunks in later blocks are recovered. The bytes lost are
+ * zeroed, as are chunks copied from them, and Z_DATA_ERROR is returned.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets the number of bytes processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer, see
+ *                      zsc_uncompress_get_min_work_buf_size2().
+ * @param window_bits   the base two logarithm of the window size,
+ *                      negative for raw deflate, or plus 16 for gzip.
+ * @return Z_OK if decompression succeeded, Z_DATA_ERROR if the header,
+ *         table, or stream was corrupt, Z_BUF_ERROR if dest was too small,
+ *         an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_dedup2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits);
+
+/**
+ * @brief Get minimum size of a work buffer for zsc_compress_frame_init()
+ * A reference of the window size, plus a deflate state.
+ *
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Should be in the range 9 to 15.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param size_out      Minimum size required for working memory
+ * @return Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ */
+ZlibReturn zsc_compress_frame_get_min_work_buf_size2(I32 window_bits,
+        I32 mem_level, U32 *size_out);
+
+/**
+ * @brief Start a sequence of frames compressed against the previous frame
+ * The work buffer belongs to the sequence until it is no longer used.
+ * The first frame is always a keyframe.
+ *
+ * @param frame             State to set up
+ * @param work              Working memory
+ * @param work_len          Length of work buffer. If less than size given
+ *                          by zsc_compress_frame_get_min_work_buf_size2(),
+ *                          the call will fail.
+ * @param level             Compression level
+ * @param window_bits       the base two logarithm of the window size.
+ *                          Should be in the range 9 to 15; the zlib
+ *                          wrapper is always used.
+ * @param mem_level         how much memory to use for internal state.
+ *                          Should be in the range 1 to 9.
+ * @param strategy          Compression strategy
+ * @param keyframe_interval Frames from one keyframe to the next, so that
+ *                          a receiver that lost a frame can resync.
+ *                          0 for no periodic keyframes.
+ * @return Z_OK, Z_MEM_ERROR if work is too small, or Z_STREAM_ERROR if
+ *         parameters are improper
+ */
+ZlibReturn zsc_compress_frame_init(zsc_frame *frame, U8 *work, U32 work_len,
+        I32 level, I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        U32 keyframe_interval);
+
+/**
+ * @brief Compress a frame, using the previous frame as a dictionary
+ * Each frame is a complete zlib stream. Unless it is a keyframe, the last
+ * window of the previous frame is preset with deflateSetDictionary(), so
+ * the frame can refer to it; the stream then carries the Adler-32 of that
+ * reference, which zsc_uncompress_frame() checks. If a frame fails, the
+ * next one is a keyframe.
+ *
+ * @param frame         State from zsc_compress_frame_init()
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @return Z_OK if compression succeeded, Z_BUF_ERROR if dest was too small,
+ *         an error code otherwise.
+ */
+ZlibReturn zsc_compress_frame(zsc_frame *frame,
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len);
+
+/**
+ * @brief Get minimum size of a work buffer for zsc_uncompress_frame_init()
+ * A reference of the window size, plus an inflate state.
+ *
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Should be in the range 9 to 15.
+ * @param size_out      Minimum size required for working memory
+ * @return Z_STREAM_ERROR if parameters are improper, Z_OK otherwise
+ */
+ZlibReturn zsc_uncompress_frame_get_min_work_buf_size2(I32 window_bits,
+        U32 *size_out);
+
+/**
+ * @brief Start receiving a sequence of frames from zsc_compress_frame()
+ * The work buffer belongs to the sequence until it is no longer used.
+ *
+ * @param frame         State to set up
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      zsc_uncompress_frame_get_min_work_buf_size2(),
+ *                      the call will fail.
+ * @param window_bits   the base two logarithm of the window size used
+ *                      for compression, in the range 9 to 15.
+ * @return Z_OK, Z_MEM_ERROR if work is too small, or Z_STREAM_ERROR if
+ *         parameters are improper
+ */
+ZlibReturn zsc_uncompress_frame_init(zsc_frame *frame, U8 *work,
+        U32 work_len, I32 window_bits);
+
+/**
+ * @brief Decompress a frame from zsc_compress_frame()
+ * Keyframes decompress on their own. Other frames need the reference kept
+ * from the previous frame; if that frame was lost or failed, they fail
+ * with Z_DATA_ERROR until the next keyframe arrives.
+ *
+ * @param frame         State from zsc_uncompress_frame_init()
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets the number of bytes processed.
+ * @return Z_OK if decompression succeeded, Z_DATA_ERROR if the frame was
+ *         corrupt or its reference is not held, Z_BUF_ERROR if dest was
+ *         too small, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_frame(zsc_frame *frame,
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len);
+
+/**
+ * @brief Empty a dictionary registry
+ *
+ * @param reg   Registry to set up
+ * @return Z_OK
+ */
+ZlibReturn zsc_dict_registry_init(zsc_dict_registry *reg);
+
+/**
+ * @brief Add a preset dictionary to a registry
+ * The dictionary is hashed here, once. Only its last ZSC_DICT_MAX_LEN bytes
+ * are kept, since no window reaches further back; the ID is of those bytes.
+ * The data is not copied, and must outlive the registry.
+ *
+ * @param reg       Registry from zsc_dict_registry_init()
+ * @param data      Dictionary
+ * @param len       Length of dictionary, in bytes
+ * @param id_out    Gets the dictionary ID, to give zsc_compress_dict2()
+ * @return Z_OK if added, or already present; Z_STREAM_ERROR if the registry
+ *         is full, the dictionary is empty, or a different dictionary has
+ *         the same ID
+ */
+ZlibReturn zsc_dict_register(zsc_dict_registry *reg,
+        const U8 *data, U32 len, U32 *id_out);
+
+/**
+ * @brief Find a registered dictionary by ID
+ *
+ * @param reg   Registry from zsc_dict_registry_init()
+ * @param id    Dictionary ID, from zsc_dict_register() or a zlib header
+ * @return The dictionary, or Z_NULL if none has that ID
+ */
+const zsc_dict *zsc_dict_find(const zsc_dict_registry *reg, U32 id);
+
+/**
+ * @brief Compress a buffer with default settings and a preset dictionary
+ * Equivalent to zsc_compress_dict2() with default settings.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), compression will fail.
+ * @param level         Compression level
+ * @param reg           Registry holding the dictionary
+ * @param dict_id       ID of the dictionary, from zsc_dict_register()
+ * @return Z_OK if compression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_compress_dict(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        const zsc_dict_registry *reg, U32 dict_id);
+
+/**
+ * @brief Compress a buffer with custom settings and a preset dictionary
+ * Same as zsc_compress_gzip2() with the zlib wrapper, with the dictionary
+ * preset before the first block; its ID goes in the zlib header, for
+ * zsc_uncompress_dict2() to find. Since each full flush starts over, only
+ * the first max_block_len bytes refer to the dictionary.
+ * Pick the dictionary for each class of message by its ID.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of compressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param max_block_len Maximum length of a compressed output.
+ *                      See zsc_compress().
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size2(), compression will fail.
+ * @param level         Compression level
+ * @param window_bits   the base two logarithm of the window size.
+ *                      Should be in the range 8 to 15; raw and gzip
+ *                      streams can't carry a dictionary ID.
+ * @param mem_level     how much memory to use for internal state.
+ *                      Should be in the range 1 to 9.
+ * @param strategy      Compression strategy
+ * @param reg           Registry holding the dictionary
+ * @param dict_id       ID of the dictionary, from zsc_dict_register()
+ * @return Z_OK if compression succeeded, Z_STREAM_ERROR if the dictionary
+ *         is not registered, an error code otherwise.
+ */
+ZlibReturn zsc_compress_dict2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        const zsc_dict_registry *reg, U32 dict_id);
+
+/**
+ * @brief Decompress a buffer, default settings, finding its dictionary
+ * Equivalent to zsc_uncompress_dict2() with default window_bits.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets the number of bytes processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size(), decompression will fail.
+ * @param reg           Registry of dictionaries the message may use
+ * @return Z_OK if decompression succeeded, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_dict(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, const zsc_dict_registry *reg);
+
+/**
+ * @brief Decompress a buffer, custom settings, finding its dictionary
+ * Same as zsc_uncompress2(), but when the stream asks for a dictionary,
+ * the one with its ID is looked up in the registry and supplied.
+ * Streams without a dictionary decompress as usual.
+ *
+ * @param dest          Output buffer
+ * @param dest_len      Length of output buffer, in bytes
+ *                      After call, gets the size of decompressed output.
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ *                      After call, gets the number of bytes processed.
+ * @param work          Working memory
+ * @param work_len      Length of work buffer. If less than size given by
+ *                      get_min_work_buf_size2(), decompression will fail.
+ * @param window_bits   the base two logarithm of the window size.
+ * @param reg           Registry of dictionaries the message may use
+ * @return Z_OK if decompression succeeded, Z_NEED_DICT if the dictionary
+ *         is not registered, an error code otherwise.
+ */
+ZlibReturn zsc_uncompress_dict2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits,
+        const zsc_dict_registry *reg);
+
+/**
+ * @brief Get minimum size of a work buffer for zsc_estimate_ratio()
+ * Code histograms and hash chains for one 32 KiB window, about 130 KiB.
+ *
+ * @param size_out  Minimum size required for working memory
+ * @return Z_OK
+ */
+ZlibReturn zsc_estimate_get_min_work_buf_size(U32 *size_out);
+
+/**
+ * @brief Estimate the compressed size of a buffer without compressing it
+ * Parses four 32 KiB windows, spread evenly from the start to the end of
+ * the input, for matches with deflate's hash, a shorter chain search than
+ * the level's, and costs the codes that would be emitted by their entropy.
+ * Inputs of 128 KiB or less are parsed in full. The time taken is bounded
+ * whatever the input length, so a scheduler can rank buffers and choose
+ * levels before spending time on deflate. The estimate is typically within
+ * 10% of the compressed size; highly repetitive data, which compresses to
+ * a few percent of its length, is estimated the least closely.
+ *
+ * @param source        Input buffer
+ * @param source_len    Length of input buffer, in bytes
+ * @param level         Compression level the estimate is for
+ * @param work          Working memory
+ * @param work_len      Length of work buffer, see
+ *                      zsc_estimate_get_min_work_buf_size().
+ * @param size_out      Estimated size of zsc_compress() output with the
+ *                      zlib wrapper, never more than storing the input.
+ *                      The ratio is source_len / *size_out.
+ * @return Z_OK, Z_MEM_ERROR if work is too small, or Z_STREAM_ERROR if
+ *         the level is improper
+ */
+ZlibReturn zsc_estimate_ratio(const U8 *source, U32 source_len, I32 level,
+        U8 *work, U32 work_len, U32 *size_out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,27 @@
 // Abcouwer ZSC - remove ZLIB_INTERNAL
 
 #include "zsc/zlib.h"
+#include "zsc/zsc_conf_private.h"
+
+/* Abcouwer ZSC - Paranoid asserts are per-iteration checks in the inner
+ * loops of deflate and trees whose invariants are already asserted once
+ * per call. A configuration header may route them separately from the
+ * ZSC_ASSERT family, e.g. to nothing in a flight build. If it does not
+ * define them, they fall back to the ZSC_ASSERT family.
+ */
+#ifndef ZSC_ASSERT_PARANOID
+#define ZSC_ASSERT_PARANOID(test) ZSC_ASSERT(test)
+#endif
+#ifndef ZSC_ASSERT_PARANOID1
+#define ZSC_ASSERT_PARANOID1(test, arg1) ZSC_ASSERT1(test, arg1)
+#endif
+#ifndef ZSC_ASSERT_PARANOID2
+#define ZSC_ASSERT_PARANOID2(test, arg1, arg2) ZSC_ASSERT2(test, arg1, arg2)
+#endif
+#ifndef ZSC_ASSERT_PARANOID3
+#define ZSC_ASSERT_PARANOID3(test, arg1, arg2, arg3) \
+    ZSC_ASSERT3(test, arg1, arg2, arg3)
+#endif
 
 // Abcouwer ZSC - typedef ptrdiff_t moved to zsc_conf_global_types
 
@@ -152,4 +173,14 @@ extern const U8 * const z_errmsg[10]; /* indexed by 2-zlib_error */
 #define ZMIN(a,b) ((a)<(b) ?  (a) : (b))
 #define ZMAX(a,b) ((a)>(b) ?  (a) : (b))
 
+// Abcouwer ZSC - little-endian U32s, as in state images and zsc headers
+void zsc_put_u32_le(U8 *buf, U32 val);
+U32 zsc_get_u32_le(const U8 *buf);
+
+// Abcouwer ZSC - zero the bytes of a struct member in a state image that
+// starts with a copy of the struct at s, such as a pointer that must not
+// be saved, see deflateSaveState() and inflateSaveState()
+#define IMAGE_CLEAR(img, s, field) zmemzero((img) + \
+    (U32)((const U8 *)&(s)->field - (const U8 *)(s)), (U32)sizeof((s)->field))
+
 #endif /* ZUTIL_H */
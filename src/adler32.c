@@ -139,5 +139,28 @@ U32 adler32(adler, buf, len)
     return adler32_z(adler, buf, len);
 }
 
+/* ========================================================================= */
+/* Abcouwer ZSC - companion to crc32_multi().  Unlike the CRC table chain, the
+ * unrolled adds above already keep the CPU busy on short buffers; stepping
+ * several buffers in lockstep measured no faster, so this just loops.
+ */
+ZlibReturn adler32_multi(adlers, bufs, lens, count)
+    U32 *adlers;
+    const U8 * const *bufs;
+    const z_size_t *lens;
+    U32 count;
+{
+    U32 i;
+
+    if (adlers == Z_NULL || bufs == Z_NULL || lens == Z_NULL) {
+        return Z_STREAM_ERROR;
+    }
+
+    for (i = 0; i < count; i++) {
+        adlers[i] = adler32_z(adlers[i], bufs[i], lens[i]);
+    }
+    return Z_OK;
+}
+
 // Abcouwer ZSC - Remove adler combine functions
 // Joining two compressed buffers is beyond scope of ZSC.
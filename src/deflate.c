@@ -113,12 +113,18 @@ ZSC_PRIVATE block_state deflate_fast   (deflate_state *s, ZlibFlush flush);
 ZSC_PRIVATE block_state deflate_slow   (deflate_state *s, ZlibFlush flush);
 ZSC_PRIVATE block_state deflate_rle    (deflate_state *s, ZlibFlush flush);
 ZSC_PRIVATE block_state deflate_huff   (deflate_state *s, ZlibFlush flush);
+ZSC_PRIVATE I32 max_run_ahead  (deflate_state *s);
+ZSC_PRIVATE void tally_lits     (deflate_state *s, const U8 *buf, U32 n);
+ZSC_PRIVATE U32 rle_literals    (deflate_state *s);
 ZSC_PRIVATE void lm_init        (deflate_state *s);
 ZSC_PRIVATE void putShortMSB    (deflate_state *s, U32 b);
 ZSC_PRIVATE void flush_pending  (z_stream * strm);
 ZSC_PRIVATE U32 read_buf   (z_stream * strm, U8 *buf, U32 size);
 // Abcouwer ZSC - remove assembly functions
 ZSC_PRIVATE U32 longest_match  (deflate_state *s, U32 cur_match);
+ZSC_PRIVATE void adapt_chain_limit (deflate_state *s, U32 visited,
+                                    U32 deep_gain);
+ZSC_PRIVATE void reset_chain_limit (deflate_state *s);
 
 /* ===========================================================================
  * Local data
@@ -130,6 +136,20 @@ ZSC_PRIVATE U32 longest_match  (deflate_state *s, U32 cur_match);
 #  define TOO_FAR 4096
 /* Matches of length 3 are discarded if their distance exceeds TOO_FAR */
 
+#define RLE_CHUNK 16
+/* Abcouwer ZSC - bytes compared a step when finding the end of a run */
+
+/* Abcouwer ZSC - The adaptive chain limit is revisited after ADAPT_WALKS
+ * searches of at least ADAPT_MIN_VISIT chain entries. The deeper halves of
+ * those searches were worth their time if they gained a byte of match length
+ * for every ADAPT_COST entries visited there. The limit is halved if they
+ * gained less, and doubled if they gained ADAPT_GROW times as much.
+ */
+#define ADAPT_WALKS 256
+#define ADAPT_MIN_VISIT 8
+#define ADAPT_COST 64
+#define ADAPT_GROW 4
+
 /* Values for max_lazy_match, good_match and max_chain_length, depending on
  * the desired pack level (0..9). The values given below have been tuned to
  * exclude worst case performance for pathological files. Better values may be
@@ -140,24 +160,26 @@ typedef struct config_s {
    U16 max_lazy;    /* do not perform lazy search above this match length */
    U16 nice_length; /* quit search above this match length */
    U16 max_chain;
+   U16 min_chain;   /* Abcouwer ZSC - floor of an adaptive chain limit */
    compress_func func;
 } config;
 
 ZSC_PRIVATE const config configuration_table[10] = {
-/*      good lazy nice chain */
-/* 0 */ {0,    0,   0,    0, deflate_stored}, /* store only */
-/* 1 */ {4,    4,   8,    4, deflate_fast},   /* max speed, no lazy matches */
-/* 2 */ {4,    5,  16,    8, deflate_fast},
-/* 3 */ {4,    6,  32,   32, deflate_fast},
-
-/* 4 */ {4,    4,  16,   16, deflate_slow},   /* lazy matches */
-/* 5 */ {8,   16,  32,   32, deflate_slow},
-/* 6 */ {8,   16, 128,  128, deflate_slow},
-/* 7 */ {8,   32, 128,  256, deflate_slow},
-/* 8 */ {32, 128, 258, 1024, deflate_slow},
-/* 9 */ {32, 258, 258, 4096, deflate_slow}};  /* max compression */
+/*      good lazy nice chain  min */
+/* 0 */ {0,    0,   0,    0,   0, deflate_stored}, /* store only */
+/* 1 */ {4,    4,   8,    4,   4, deflate_fast},   /* max speed, no lazy */
+/* 2 */ {4,    5,  16,    8,   4, deflate_fast},
+/* 3 */ {4,    6,  32,   32,   4, deflate_fast},
+
+/* 4 */ {4,    4,  16,   16,   4, deflate_slow},   /* lazy matches */
+/* 5 */ {8,   16,  32,   32,   4, deflate_slow},
+/* 6 */ {8,   16, 128,  128,  16, deflate_slow},
+/* 7 */ {8,   32, 128,  256,  32, deflate_slow},
+/* 8 */ {32, 128, 258, 1024, 128, deflate_slow},
+/* 9 */ {32, 258, 258, 4096, 512, deflate_slow}};  /* max compression */
 
 /* Note: the deflate() code requires max_lazy >= MIN_MATCH and max_chain >= 4
+ * min_chain is only used when the chain limit adapts, see deflateAdaptChain().
  * For deflate_fast() (levels <= 3) good is ignored and lazy has a different
  * meaning.
  */
@@ -615,8 +637,12 @@ ZlibReturn deflateParams(z_stream * strm, I32 level, ZlibStrategy strategy)
     }
     func = configuration_table[s->level].func;
 
+    // Abcouwer ZSC - skip the flush if there is no unflushed input, as
+    // right after a full flush, where deflate() would reject it as a repeated
+    // flush. See zlib.h.
     if ((strategy != s->strategy || func != configuration_table[level].func)
-            && s->high_water) {
+            && s->high_water && (strm->avail_in != 0 || s->lookahead != 0
+            || (I32)s->strstart != s->block_start)) {
         /* Flush the last buffer: */
         ZlibReturn err = deflate(strm, Z_BLOCK);
         if (err == Z_STREAM_ERROR) {
@@ -640,6 +666,13 @@ ZlibReturn deflateParams(z_stream * strm, I32 level, ZlibStrategy strategy)
         s->good_match       = configuration_table[level].good_length;
         s->nice_match       = configuration_table[level].nice_length;
         s->max_chain_length = configuration_table[level].max_chain;
+        s->min_chain_length = configuration_table[level].min_chain;
+        reset_chain_limit(s);
+    }
+    // Abcouwer ZSC - the hash table was not slid, see fill_window()
+    if ((s->strategy == Z_HUFFMAN_ONLY || s->strategy == Z_RLE)
+            && strategy != Z_HUFFMAN_ONLY && strategy != Z_RLE) {
+        CLEAR_HASH(s);
     }
     s->strategy = strategy;
     return Z_OK;
@@ -664,6 +697,61 @@ ZlibReturn deflateTune(z_stream * strm,
     s->max_lazy_match = (U32)max_lazy;
     s->nice_match = nice_length;
     s->max_chain_length = (U32)max_chain;
+    // from the level's floor, so raising max_chain can raise it back
+    s->min_chain_length = ZMIN(configuration_table[s->level].min_chain,
+            s->max_chain_length);
+    reset_chain_limit(s);
+    return Z_OK;
+}
+
+/* ========================================================================= */
+ZlibReturn deflateAccel(z_stream * strm, I32 accel)
+{
+    deflate_state *s;
+
+    if (deflateStateCheck(strm)) {
+        return Z_STREAM_ERROR;
+    }
+    ZSC_ASSERT(strm != NULL);
+    s = strm->state;
+    ZSC_ASSERT(s != NULL);
+    if (accel < 0 || accel > MAX_ACCEL) {
+        ZSC_WARN1("deflateAccel() bad accel %d.", accel);
+        return Z_STREAM_ERROR;
+    }
+    s->accel = (U32)accel;
+    s->misses = 0;
+    return Z_OK;
+}
+
+/* ========================================================================= */
+ZlibReturn deflateAdaptChain(z_stream * strm, I32 adapt)
+{
+    deflate_state *s;
+
+    if (deflateStateCheck(strm)) {
+        return Z_STREAM_ERROR;
+    }
+    ZSC_ASSERT(strm != NULL);
+    s = strm->state;
+    ZSC_ASSERT(s != NULL);
+    s->adapt_chain = (adapt != 0) ? 1U : 0U;
+    reset_chain_limit(s);
+    return Z_OK;
+}
+
+/* ========================================================================= */
+ZlibReturn deflateFastRuns(z_stream * strm, I32 fast_runs)
+{
+    deflate_state *s;
+
+    if (deflateStateCheck(strm)) {
+        return Z_STREAM_ERROR;
+    }
+    ZSC_ASSERT(strm != NULL);
+    s = strm->state;
+    ZSC_ASSERT(s != NULL);
+    s->fast_runs = (fast_runs != 0) ? 1U : 0U;
     return Z_OK;
 }
 
@@ -1315,8 +1403,317 @@ ZlibReturn deflateEnd (z_stream * strm)
     return status == BUSY_STATE ? Z_DATA_ERROR : Z_OK;
 }
 
-// Abcouwer ZSC - removed deflateCopy
-// copying then doing allocs will spool more memory from the work buffer.
+/* =========================================================================
+ * Abcouwer ZSC - deflateCopy() returns as deflateCopyTo().  Rather than
+ * allocating, the copy is carved from dest's own work buffer, which the
+ * caller provides in dest->next_work and dest->avail_work.
+ */
+ZlibReturn deflateCopyTo (z_stream * dest, z_stream * source)
+{
+    deflate_state *ds;
+    deflate_state *ss;
+    U16 *overlay;
+    U8 *next_work;
+    U32 avail_work;
+    U32 work_size = U32_MAX;
+
+    if (deflateStateCheck(source) || dest == Z_NULL || dest == source) {
+        ZSC_WARN("In deflateCopyTo(), bad stream.");
+        return Z_STREAM_ERROR;
+    }
+    ZSC_ASSERT(source != Z_NULL);
+    ss = source->state;
+    ZSC_ASSERT(ss != Z_NULL);
+
+    if (dest->next_work == Z_NULL
+            || deflateWorkSize2((I32)ss->w_bits, (I32)ss->hash_bits - 7,
+                    &work_size) != Z_OK
+            || dest->avail_work < work_size) {
+        ZSC_WARN2("In deflateCopyTo(), bad dest work buffer: %d %d.",
+                dest->next_work == Z_NULL, dest->avail_work < work_size);
+        return Z_STREAM_ERROR;
+    }
+
+    next_work = dest->next_work;
+    avail_work = dest->avail_work;
+    zmemcpy((void *)dest, (void *)source, sizeof(z_stream));
+    dest->next_work = next_work;
+    dest->avail_work = avail_work;
+
+    /* same carving as deflateInit2_(), so the sizes checked above suffice */
+    ds = (deflate_state *) deflate_get_work_mem(dest, 1, sizeof(deflate_state));
+    ZSC_ASSERT(ds != Z_NULL);
+    zmemcpy((void *)ds, (void *)ss, sizeof(deflate_state));
+    dest->state = (struct internal_state *)ds;
+    ds->strm = dest;
+
+    ds->window = (U8 *) deflate_get_work_mem(dest, ds->w_size, 2*sizeof(U8));
+    ds->prev   = (Pos *)  deflate_get_work_mem(dest, ds->w_size, sizeof(Pos));
+    ds->head   = (Pos *)  deflate_get_work_mem(dest, ds->hash_size, sizeof(Pos));
+    overlay = (U16 *) deflate_get_work_mem(dest, ds->lit_bufsize,
+            sizeof(U16)+2);
+    ds->pending_buf = (U8 *) overlay;
+    ZSC_ASSERT(ds->window != Z_NULL);
+    ZSC_ASSERT(ds->prev != Z_NULL);
+    ZSC_ASSERT(ds->head != Z_NULL);
+    ZSC_ASSERT(ds->pending_buf != Z_NULL);
+
+    zmemcpy(ds->window, ss->window, ds->w_size * 2 * sizeof(U8));
+    zmemcpy((void *)ds->prev, (void *)ss->prev, ds->w_size * sizeof(Pos));
+    zmemcpy((void *)ds->head, (void *)ss->head, ds->hash_size * sizeof(Pos));
+    zmemcpy(ds->pending_buf, ss->pending_buf, ds->pending_buf_size);
+
+    ds->pending_out = ds->pending_buf + (ss->pending_out - ss->pending_buf);
+    ds->d_buf = overlay + ds->lit_bufsize/sizeof(U16);
+    ds->l_buf = ds->pending_buf + (1+sizeof(U16))*ds->lit_bufsize;
+
+    ds->l_desc.dyn_tree = ds->dyn_ltree;
+    ds->d_desc.dyn_tree = ds->dyn_dtree;
+    ds->bl_desc.dyn_tree = ds->bl_tree;
+
+    return Z_OK;
+}
+
+/* =========================================================================
+ * Abcouwer ZSC - checkpoint and resume.  The image is a header of
+ * little-endian U32s, the state struct with its pointers zeroed, the live
+ * part of the window, prev, head, pending output, pending symbols, and a
+ * CRC-32 of all of that.  Pointers are rebuilt against the work buffer on
+ * load, so the image may be restored anywhere, but only by the same build.
+ */
+#define DEFLATE_IMAGE_MAGIC 0x5a534344UL /* "ZSCD" */
+#define DEFLATE_IMAGE_HEADER (11*4)
+
+ZlibReturn deflateStateImageBound(I32 windowBits, I32 memLevel,
+        U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+    *size_out = U32_MAX;
+
+    // the work buffer holds the state, window, prev, head, and pending_buf
+    U32 work_size = U32_MAX;
+    ZlibReturn err = deflateWorkSize2(windowBits, memLevel, &work_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    // pending output and symbols are saved separately
+    *size_out = DEFLATE_IMAGE_HEADER + work_size
+            + 3 * (1U << (memLevel + 6)) + 4;
+    return Z_OK;
+}
+
+/* ========================================================================= */
+ZlibReturn deflateSaveState(z_stream * strm, U8 *image, U32 *image_len)
+{
+    deflate_state *s;
+
+    if (deflateStateCheck(strm) || image == Z_NULL || image_len == Z_NULL) {
+        ZSC_WARN("In deflateSaveState(), bad stream or image.");
+        return Z_STREAM_ERROR;
+    }
+    ZSC_ASSERT(strm != Z_NULL);
+    s = strm->state;
+    ZSC_ASSERT(s != Z_NULL);
+
+    // the gzip header is not saved, so it must already be written
+    if (s->gzhead != Z_NULL && s->status != BUSY_STATE
+            && s->status != FINISH_STATE) {
+        ZSC_WARN1("In deflateSaveState(), gzip header not yet written, "
+                "status %d.", s->status);
+        return Z_STREAM_ERROR;
+    }
+
+    U32 window_len = ZMAX(s->strstart + s->lookahead, s->high_water);
+    window_len = ZMIN(window_len, 2 * s->w_size);
+    U32 pending_off = (U32)(s->pending_out - s->pending_buf);
+    U32 len = DEFLATE_IMAGE_HEADER + (U32)sizeof(deflate_state) + window_len
+            + s->w_size * (U32)sizeof(Pos) + s->hash_size * (U32)sizeof(Pos)
+            + s->pending + s->last_lit * ((U32)sizeof(U16) + 1) + 4;
+    if (*image_len < len) {
+        ZSC_WARN2("In deflateSaveState(), image buffer (%u B) smaller "
+                "than needed (%u B).", *image_len, len);
+        *image_len = len;
+        return Z_BUF_ERROR;
+    }
+
+    U8 *p = image;
+    zsc_put_u32_le(p, DEFLATE_IMAGE_MAGIC);
+    zsc_put_u32_le(p + 4, (U32)sizeof(deflate_state));
+    zsc_put_u32_le(p + 8, s->w_bits);
+    zsc_put_u32_le(p + 12, s->hash_bits);
+    zsc_put_u32_le(p + 16, s->lit_bufsize);
+    zsc_put_u32_le(p + 20, window_len);
+    zsc_put_u32_le(p + 24, pending_off);
+    zsc_put_u32_le(p + 28, strm->total_in);
+    zsc_put_u32_le(p + 32, strm->total_out);
+    zsc_put_u32_le(p + 36, strm->adler);
+    zsc_put_u32_le(p + 40, (U32)strm->data_type);
+    p += DEFLATE_IMAGE_HEADER;
+
+    zmemcpy(p, (U8 *)s, sizeof(deflate_state));
+    IMAGE_CLEAR(p, s, strm);
+    IMAGE_CLEAR(p, s, pending_buf);
+    IMAGE_CLEAR(p, s, pending_out);
+    IMAGE_CLEAR(p, s, gzhead);
+    IMAGE_CLEAR(p, s, window);
+    IMAGE_CLEAR(p, s, prev);
+    IMAGE_CLEAR(p, s, head);
+    IMAGE_CLEAR(p, s, l_desc.dyn_tree);
+    IMAGE_CLEAR(p, s, l_desc.stat_desc);
+    IMAGE_CLEAR(p, s, d_desc.dyn_tree);
+    IMAGE_CLEAR(p, s, d_desc.stat_desc);
+    IMAGE_CLEAR(p, s, bl_desc.dyn_tree);
+    IMAGE_CLEAR(p, s, bl_desc.stat_desc);
+    IMAGE_CLEAR(p, s, l_buf);
+    IMAGE_CLEAR(p, s, d_buf);
+    p += sizeof(deflate_state);
+
+    zmemcpy(p, s->window, window_len);
+    p += window_len;
+    zmemcpy(p, (U8 *)s->prev, s->w_size * sizeof(Pos));
+    p += s->w_size * sizeof(Pos);
+    zmemcpy(p, (U8 *)s->head, s->hash_size * sizeof(Pos));
+    p += s->hash_size * sizeof(Pos);
+    zmemcpy(p, s->pending_out, s->pending);
+    p += s->pending;
+    zmemcpy(p, (U8 *)s->d_buf, s->last_lit * sizeof(U16));
+    p += s->last_lit * sizeof(U16);
+    zmemcpy(p, s->l_buf, s->last_lit);
+    p += s->last_lit;
+
+    ZSC_ASSERT2((U32)(p - image) + 4 == len, (U32)(p - image), len);
+    zsc_put_u32_le(p, crc32(0L, image, len - 4));
+    *image_len = len;
+    return Z_OK;
+}
+
+/* ========================================================================= */
+ZlibReturn deflateLoadState(z_stream * strm, const U8 *image, U32 image_len)
+{
+    deflate_state *s;
+
+    if (strm == Z_NULL || image == Z_NULL || strm->next_work == Z_NULL) {
+        ZSC_WARN("In deflateLoadState(), bad stream or image.");
+        return Z_STREAM_ERROR;
+    }
+
+    // check the header and CRC before touching the stream
+    if (image_len < DEFLATE_IMAGE_HEADER + sizeof(deflate_state) + 4
+            || zsc_get_u32_le(image) != DEFLATE_IMAGE_MAGIC
+            || zsc_get_u32_le(image + 4) != (U32)sizeof(deflate_state)) {
+        ZSC_WARN1("In deflateLoadState(), not an image from this build "
+                "(%u B).", image_len);
+        return Z_DATA_ERROR;
+    }
+    if (crc32(0L, image, image_len - 4)
+            != zsc_get_u32_le(image + image_len - 4)) {
+        ZSC_WARN("In deflateLoadState(), image CRC mismatch.");
+        return Z_DATA_ERROR;
+    }
+    U32 w_bits = zsc_get_u32_le(image + 8);
+    U32 hash_bits = zsc_get_u32_le(image + 12);
+    U32 lit_bufsize = zsc_get_u32_le(image + 16);
+    U32 window_len = zsc_get_u32_le(image + 20);
+    U32 pending_off = zsc_get_u32_le(image + 24);
+    if (w_bits < 9 || w_bits > 15 || hash_bits < 8
+            || hash_bits > MAX_MEM_LEVEL + 7
+            || lit_bufsize != 1U << (hash_bits - 1)) {
+        ZSC_WARN3("In deflateLoadState(), bad image parameters %u %u %u.",
+                w_bits, hash_bits, lit_bufsize);
+        return Z_DATA_ERROR;
+    }
+    U32 work_size = U32_MAX;
+    if (deflateWorkSize2((I32)w_bits, (I32)hash_bits - 7, &work_size) != Z_OK
+            || strm->avail_work < work_size) {
+        ZSC_WARN2("In deflateLoadState(), work buffer (%u B) smaller than "
+                "needed (%u B).", strm->avail_work, work_size);
+        return Z_STREAM_ERROR;
+    }
+
+    // carve the state as deflateInit2_() does, then fill it from the image
+    U8 *next_work = strm->next_work;
+    U32 avail_work = strm->avail_work;
+    s = (deflate_state *) deflate_get_work_mem(strm, 1, sizeof(deflate_state));
+    ZSC_ASSERT(s != Z_NULL);
+    const U8 *p = image + DEFLATE_IMAGE_HEADER;
+    zmemcpy((U8 *)s, p, sizeof(deflate_state));
+    p += sizeof(deflate_state);
+
+    // the struct was covered by the CRC, but check what would index memory
+    if (s->w_bits != w_bits || s->hash_bits != hash_bits
+            || s->lit_bufsize != lit_bufsize
+            || s->w_size != 1U << w_bits || s->hash_size != 1U << hash_bits
+            || s->pending_buf_size != lit_bufsize * (sizeof(U16)+2)
+            || window_len > 2 * s->w_size
+            || s->strstart + s->lookahead > 2 * s->w_size
+            || s->w_mask != s->w_size - 1 || s->hash_mask != s->hash_size - 1
+            || s->ins_h > s->hash_mask
+            || s->match_start >= 2 * s->w_size
+            || s->insert > s->strstart
+            || s->block_start > (I32)s->strstart
+            || s->level < 0 || s->level > 9 // indexes configuration_table
+            || s->strategy < 0 || s->strategy > Z_FIXED
+            || s->bi_valid < 0 || s->bi_valid > 16
+            || s->pending > s->pending_buf_size
+            || pending_off > s->pending_buf_size - s->pending
+            || s->last_lit > lit_bufsize
+            || image_len != DEFLATE_IMAGE_HEADER + sizeof(deflate_state)
+                + window_len + s->w_size * sizeof(Pos)
+                + s->hash_size * sizeof(Pos) + s->pending
+                + s->last_lit * (sizeof(U16) + 1) + 4) {
+        ZSC_WARN("In deflateLoadState(), inconsistent image.");
+        strm->next_work = next_work;
+        strm->avail_work = avail_work;
+        return Z_DATA_ERROR;
+    }
+
+    s->window = (U8 *) deflate_get_work_mem(strm, s->w_size, 2*sizeof(U8));
+    s->prev   = (Pos *)  deflate_get_work_mem(strm, s->w_size, sizeof(Pos));
+    s->head   = (Pos *)  deflate_get_work_mem(strm, s->hash_size, sizeof(Pos));
+    s->pending_buf = (U8 *) deflate_get_work_mem(strm, s->lit_bufsize,
+            sizeof(U16)+2);
+    ZSC_ASSERT(s->window != Z_NULL);
+    ZSC_ASSERT(s->prev != Z_NULL);
+    ZSC_ASSERT(s->head != Z_NULL);
+    ZSC_ASSERT(s->pending_buf != Z_NULL);
+    s->d_buf = (U16 *)s->pending_buf + s->lit_bufsize/sizeof(U16);
+    s->l_buf = s->pending_buf + (1+sizeof(U16))*s->lit_bufsize;
+    s->pending_out = s->pending_buf + pending_off;
+    s->gzhead = Z_NULL;
+    _tr_init_desc(s);
+
+    zmemcpy(s->window, p, window_len);
+    p += window_len;
+    zmemcpy((U8 *)s->prev, p, s->w_size * sizeof(Pos));
+    p += s->w_size * sizeof(Pos);
+    zmemcpy((U8 *)s->head, p, s->hash_size * sizeof(Pos));
+    p += s->hash_size * sizeof(Pos);
+    zmemcpy((U8 *)s->d_buf, p + s->pending, s->last_lit * sizeof(U16));
+    zmemcpy(s->l_buf, p + s->pending + s->last_lit * sizeof(U16),
+            s->last_lit);
+    zmemcpy(s->pending_out, p, s->pending);
+
+    strm->state = (struct internal_state *)s;
+    s->strm = strm;
+    strm->total_in = zsc_get_u32_le(image + 28);
+    strm->total_out = zsc_get_u32_le(image + 32);
+    strm->adler = zsc_get_u32_le(image + 36);
+    strm->data_type = (ZlibDataType)zsc_get_u32_le(image + 40);
+    strm->msg = Z_NULL;
+    strm->next_in = Z_NULL;
+    strm->avail_in = 0;
+    strm->next_out = Z_NULL;
+    strm->avail_out = 0;
+
+    if (deflateStateCheck(strm)) {
+        ZSC_WARN1("In deflateLoadState(), bad status %d.", s->status);
+        strm->state = Z_NULL;
+        strm->next_work = next_work;
+        strm->avail_work = avail_work;
+        return Z_DATA_ERROR;
+    }
+    return Z_OK;
+}
 
 /* ===========================================================================
  * Read a new buffer from the current input stream, update the adler32
@@ -1375,6 +1772,12 @@ ZSC_PRIVATE void lm_init (deflate_state *s)
     s->good_match       = configuration_table[s->level].good_length;
     s->nice_match       = configuration_table[s->level].nice_length;
     s->max_chain_length = configuration_table[s->level].max_chain;
+    s->min_chain_length = configuration_table[s->level].min_chain;
+    s->accel = 0;
+    s->misses = 0;
+    s->adapt_chain = 0;
+    reset_chain_limit(s);
+    s->fast_runs = 0;
 
     s->strstart = 0;
     s->block_start = 0L;
@@ -1402,6 +1805,9 @@ ZSC_PRIVATE U32 longest_match( deflate_state *s, U32 cur_match)
     ZSC_ASSERT(s != Z_NULL);
 
     U32 chain_length = s->max_chain_length;/* max hash chain length */
+    U32 chain_start;                         /* chain_length at the start */
+    U32 best_depth = 0;         /* entries visited before the best match */
+    U32 best_gain = 0;          /* match length the best match added */
     register U8 *scan = s->window + s->strstart; /* current string */
     register U8 *match;                      /* matched string */
     register I32 len;                           /* length of current match */
@@ -1426,10 +1832,15 @@ ZSC_PRIVATE U32 longest_match( deflate_state *s, U32 cur_match)
     ZSC_COMPILE_ASSERT(MAX_MATCH == 258, bad_max_match);
     ZSC_ASSERT1(s->hash_bits >= 8, s->hash_bits);
 
+    // Abcouwer ZSC - search no further than the adapted limit
+    if (s->adapt_chain != 0) {
+        chain_length = s->chain_limit;
+    }
     /* Do not waste too much time if we already have a good match: */
     if (s->prev_length >= s->good_match) {
         chain_length >>= 2;
     }
+    chain_start = chain_length;
     /* Do not look for matches beyond the end of the input. This is necessary
      * to make deflate deterministic.
      */
@@ -1440,10 +1851,21 @@ ZSC_PRIVATE U32 longest_match( deflate_state *s, U32 cur_match)
     // Assert: "need lookahead"
     ZSC_ASSERT3((U32)s->strstart <= s->window_size-MIN_LOOKAHEAD,
             (U32)s->strstart, s->window_size, MIN_LOOKAHEAD);
+    // Abcouwer ZSC - The invariants of the loop below are checked once here.
+    // Since strstart leaves MIN_LOOKAHEAD bytes, the scan bounded by strend
+    // stays in the window. The loop only repeats while chain_length != 0,
+    // so a nonzero count on entry keeps it from underflowing. Chained
+    // matches only move back from cur_match, so the first is the one to
+    // check against strstart. The per-iteration checks are paranoid.
+    // Assert: "wild scan"
+    ZSC_ASSERT3(strend <= s->window+(U32)(s->window_size-1),
+            strend, s->window, s->window_size);
+    ZSC_ASSERT(chain_length > 0);
+    // Assert: cur_match < s->strstart, "no future"
+    ZSC_ASSERT2(cur_match < s->strstart, cur_match, s->strstart);
 
     do {
-        // Assert: cur_match < s->strstart, "no future"
-        ZSC_ASSERT2(cur_match < s->strstart, cur_match, s->strstart);
+        ZSC_ASSERT_PARANOID2(cur_match < s->strstart, cur_match, s->strstart);
         match = s->window + cur_match;
 
         /* Skip to next match if the match length cannot increase
@@ -1477,7 +1899,7 @@ ZSC_PRIVATE U32 longest_match( deflate_state *s, U32 cur_match)
         scan += 2;
         match += 2;
         // Assert: "match[2]?"
-        ZSC_ASSERT2(*scan == *match, *scan, *match);
+        ZSC_ASSERT_PARANOID2(*scan == *match, *scan, *match);
 
         /* We check for insufficient lookahead only every 8th comparison;
          * the 256th check will be made at strstart+258. */
@@ -1488,7 +1910,7 @@ ZSC_PRIVATE U32 longest_match( deflate_state *s, U32 cur_match)
         } while (*scan == *match && scan < strend);
 
         // Assert: "wild scan"
-        ZSC_ASSERT3(scan <= s->window+(U32)(s->window_size-1),
+        ZSC_ASSERT_PARANOID3(scan <= s->window+(U32)(s->window_size-1),
                 scan, s->window, s->window_size);
 
         len = MAX_MATCH - (I32)(strend - scan);
@@ -1497,6 +1919,9 @@ ZSC_PRIVATE U32 longest_match( deflate_state *s, U32 cur_match)
 
         if (len > best_len) {
             s->match_start = cur_match;
+            // Abcouwer ZSC - note how deep the best match was found
+            best_depth = chain_start - chain_length;
+            best_gain = (U32)(len - best_len);
             best_len = len;
             if (len >= nice_match) {
                 break;
@@ -1505,12 +1930,21 @@ ZSC_PRIVATE U32 longest_match( deflate_state *s, U32 cur_match)
             scan_end   = scan[best_len];
         }
         // assert no underflow
-        ZSC_ASSERT(chain_length>0);
+        ZSC_ASSERT_PARANOID(chain_length>0);
         chain_length--;
         // Abcouwer ZSC - update match here instead of in conditional
         cur_match = prev[cur_match & wmask];
     } while (cur_match > limit && chain_length != 0);
 
+    if (s->adapt_chain != 0) {
+        U32 visited = chain_start - chain_length;
+        if (visited >= ADAPT_MIN_VISIT) {
+            // only the deeper half of the walk is credited with its gain
+            adapt_chain_limit(s, visited,
+                    (2 * best_depth >= visited) ? best_gain : 0);
+        }
+    }
+
     if ((U32)best_len <= s->lookahead) {
         return (U32)best_len;
     }
@@ -1519,6 +1953,52 @@ ZSC_PRIVATE U32 longest_match( deflate_state *s, U32 cur_match)
 
 // Abcouwer ZSC - removed DEBUG-only definition of check_match
 
+/* ===========================================================================
+ * Abcouwer ZSC - Account for a chain walk that visited the given number of
+ * entries and gained deep_gain bytes of match length in the deeper half of
+ * them. Once ADAPT_WALKS walks have been seen, halve the chain limit if the
+ * deeper halves found too little for their cost, or double it if they found
+ * plenty, staying within the level's min_chain and max_chain.
+ */
+ZSC_PRIVATE void adapt_chain_limit(deflate_state *s, U32 visited,
+        U32 deep_gain)
+{
+    ZSC_ASSERT(s != Z_NULL);
+    ZSC_ASSERT1(visited <= s->w_size, visited);
+    ZSC_ASSERT1(deep_gain <= MAX_MATCH, deep_gain);
+
+    s->deep_walks++;
+    s->deep_cost += visited >> 1;
+    s->deep_gain += deep_gain;
+    if (s->deep_walks < ADAPT_WALKS) {
+        return;
+    }
+    if (s->deep_gain * ADAPT_COST < s->deep_cost) {
+        s->chain_limit = ZMAX(s->chain_limit >> 1, s->min_chain_length);
+    } else if (s->deep_gain * ADAPT_COST >= s->deep_cost * ADAPT_GROW) {
+        s->chain_limit = ZMIN(s->chain_limit << 1, s->max_chain_length);
+    } else {
+        // worth about what it costs, keep the limit
+    }
+    s->deep_walks = 0;
+    s->deep_cost = 0;
+    s->deep_gain = 0;
+}
+
+/* ===========================================================================
+ * Abcouwer ZSC - Restart chain adaptation from max_chain_length, dropping
+ * the walks counted under the old limits.
+ */
+ZSC_PRIVATE void reset_chain_limit(deflate_state *s)
+{
+    ZSC_ASSERT(s != Z_NULL);
+
+    s->chain_limit = s->max_chain_length;
+    s->deep_walks = 0;
+    s->deep_cost = 0;
+    s->deep_gain = 0;
+}
+
 /* ===========================================================================
  * Fill the window when the lookahead becomes insufficient.
  * Updates strstart and lookahead.
@@ -1565,7 +2045,12 @@ ZSC_PRIVATE void fill_window(deflate_state *s)
             s->match_start -= wsize;
             s->strstart    -= wsize; /* we now have strstart >= MAX_DIST */
             s->block_start -= (I32) wsize;
-            slide_hash(s);
+            // Abcouwer ZSC - Huffman-only and RLE never search the hash
+            // table, so it is not kept up to date for them, and is cleared
+            // if deflateParams() switches to another strategy
+            if (s->strategy != Z_HUFFMAN_ONLY && s->strategy != Z_RLE) {
+                slide_hash(s);
+            }
             more += wsize;
         }
         if (s->strm->avail_in == 0) {
@@ -1933,6 +2418,7 @@ ZSC_PRIVATE block_state deflate_fast(deflate_state *s, ZlibFlush flush)
                            s->match_length - MIN_MATCH, bflush);
 
             s->lookahead -= s->match_length;
+            s->misses = 0;
 
             /* Insert new strings in the hash table only if the match length
              * is not too large. This saves time but degrades compression.
@@ -1965,6 +2451,29 @@ ZSC_PRIVATE block_state deflate_fast(deflate_state *s, ZlibFlush flush)
             _tr_tally_lit (s, s->window[s->strstart], bflush);
             s->lookahead--;
             s->strstart++;
+
+            /* Abcouwer ZSC - the longer nothing has matched, the more bytes
+             * are output as literals without being hashed or searched.
+             */
+            if (s->accel != 0) {
+                if (s->misses < MAX_MISSES) {
+                    s->misses++;
+                }
+                U32 skip = s->misses >> (MAX_ACCEL - s->accel);
+                if (skip != 0) {
+                    while (skip != 0 && s->lookahead != 0 && !bflush) {
+                        _tr_tally_lit (s, s->window[s->strstart], bflush);
+                        s->lookahead--;
+                        s->strstart++;
+                        skip--;
+                    }
+                    /* The skipped strings are not in the hash table, so
+                     * restart the rolling hash as after a long match.
+                     */
+                    s->ins_h = s->window[s->strstart];
+                    UPDATE_HASH(s, s->ins_h, s->window[s->strstart+1]);
+                }
+            }
         }
         if (bflush) {
             FLUSH_BLOCK(s, 0);
@@ -1981,6 +2490,113 @@ ZSC_PRIVATE block_state deflate_fast(deflate_state *s, ZlibFlush flush)
     return block_done;
 }
 
+/* ===========================================================================
+ * Abcouwer ZSC - Return true if the MAX_MATCH bytes at strstart all repeat
+ * the byte before strstart, so a maximal match at distance one can be emitted
+ * without searching. Used to get through long runs (such as zeroed memory)
+ * quickly.
+ */
+ZSC_PRIVATE I32 max_run_ahead(deflate_state *s)
+{
+    ZSC_ASSERT(s != Z_NULL);
+
+    const U8 *scan;   /* byte before strstart, then the run */
+    U32 prev;              /* byte to repeat */
+    U32 diff;              /* nonzero if any byte differs */
+    U32 n;
+
+    if (s->strstart == 0 || s->lookahead < MAX_MATCH) {
+        return 0;
+    }
+    scan = s->window + s->strstart - 1;
+    prev = *scan;
+    if (prev != scan[1] || prev != scan[2] || prev != scan[3]) {
+        return 0; /* quick reject, most positions are not runs */
+    }
+    /* no early exit, so the compiler may vectorize the compare */
+    diff = 0;
+    for (n = 4; n <= MAX_MATCH; n++) {
+        diff |= (U32)scan[n] ^ prev;
+    }
+    return diff == 0;
+}
+
+/* ===========================================================================
+ * Abcouwer ZSC - Tally the n literals at buf, as n calls of _tr_tally_lit()
+ * would. The bytes are copied and their distances zeroed in bulk. Many
+ * literals are counted in LIT_COUNT_WAYS interleaved tables, so that a byte
+ * repeated in noisy data does not make each count wait on the one before.
+ * The tables borrow heap[], which holds nothing between blocks.
+ * IN assertion: the n literals leave room in the block for at least one more.
+ */
+ZSC_PRIVATE void tally_lits(deflate_state *s, const U8 *buf, U32 n)
+{
+    ZSC_ASSERT(s != Z_NULL);
+    ZSC_ASSERT(buf != Z_NULL);
+    ZSC_ASSERT3(s->last_lit + n < s->lit_bufsize,
+            s->last_lit, n, s->lit_bufsize);
+    ZSC_COMPILE_ASSERT(LIT_COUNT_WAYS == 2, bad_lit_count_ways);
+    ZSC_COMPILE_ASSERT(LIT_COUNT_WAYS * LITERALS <= 2*L_CODES+1,
+            heap_too_small_for_lit_counts);
+
+    I32 *count0 = s->heap;            /* counts of even literals */
+    I32 *count1 = s->heap + LITERALS; /* counts of odd literals */
+    U32 i;
+    U32 c;
+
+    zmemcpy(s->l_buf + s->last_lit, buf, n);
+    zmemzero((U8 *)(s->d_buf + s->last_lit), n * sizeof(U16));
+    s->last_lit += n;
+    if (n < LIT_COUNT_MIN) {
+        for (i = 0; i < n; i++) {
+            s->dyn_ltree[buf[i]].Freq++;
+        }
+        return;
+    }
+    zmemzero((U8 *)s->heap, LIT_COUNT_WAYS * LITERALS * sizeof(I32));
+    for (i = 0; i + LIT_COUNT_WAYS <= n; i += LIT_COUNT_WAYS) {
+        count0[buf[i]]++;
+        count1[buf[i+1]]++;
+    }
+    if (i < n) {
+        count0[buf[i]]++;
+    }
+    /* a block holds fewer than 64K literals, so the counts fit */
+    for (c = 0; c < LITERALS; c++) {
+        s->dyn_ltree[c].Freq += (U16)(count0[c] + count1[c]);
+    }
+}
+
+/* ===========================================================================
+ * Abcouwer ZSC - For deflate_rle(), return how many bytes from strstart on
+ * would be output as literals, one at a time, before the next run of
+ * MIN_MATCH or longer, stopping where deflate_rle() would next fill the
+ * window or flush the block.
+ * IN assertion: there is no run at strstart.
+ */
+ZSC_PRIVATE U32 rle_literals(deflate_state *s)
+{
+    ZSC_ASSERT(s != Z_NULL);
+    ZSC_ASSERT(s->lookahead > 0);
+
+    const U8 *scan = s->window + s->strstart;
+    U32 max = s->lit_bufsize-1 - s->last_lit;
+    U32 n = 1;
+
+    ZSC_ASSERT2(s->last_lit < s->lit_bufsize-1, s->last_lit, s->lit_bufsize);
+    if (s->lookahead > MAX_MATCH) {
+        /* each position checked has MAX_MATCH bytes ahead, as in the loop */
+        max = ZMIN(max, s->lookahead - MAX_MATCH);
+    } else {
+        max = 1;
+    }
+    while (n < max && (scan[n-1] != scan[n] || scan[n] != scan[n+1]
+            || scan[n] != scan[n+2])) {
+        n++;
+    }
+    return n;
+}
+
 /* ===========================================================================
  * Same as above, but achieves better compression. We use a lazy
  * evaluation for matches: a match is finally adopted only if there is
@@ -2010,6 +2626,36 @@ ZSC_PRIVATE block_state deflate_slow(deflate_state *s, ZlibFlush flush)
             }
         }
 
+        /* Abcouwer ZSC - If enabled by deflateFastRuns(), in a long run
+         * emit maximal matches at distance one directly, without searching
+         * or inserting in the hash table. Only done if no match is pending;
+         * a pending literal is emitted first, as lazy evaluation would do
+         * against a maximal match.
+         */
+        if (s->fast_runs != 0
+                && !(s->match_available && s->match_length >= MIN_MATCH)
+                && max_run_ahead(s)) {
+            if (s->match_available) {
+                _tr_tally_lit(s, s->window[s->strstart-1], bflush);
+                s->match_available = 0;
+                if (bflush) {
+                    FLUSH_BLOCK(s, 0);
+                }
+            }
+            _tr_tally_dist(s, 1, MAX_MATCH - MIN_MATCH, bflush);
+            s->lookahead -= MAX_MATCH;
+            s->strstart += MAX_MATCH;
+            s->match_length = MIN_MATCH-1;
+            /* restart the rolling hash after the run, as deflate_fast() does
+             * after a match it did not insert */
+            s->ins_h = s->window[s->strstart];
+            UPDATE_HASH(s, s->ins_h, s->window[s->strstart+1]);
+            if (bflush) {
+                FLUSH_BLOCK(s, 0);
+            }
+            continue;
+        }
+
         /* Insert the string window[strstart .. strstart+2] in the
          * dictionary, and set hash_head to the head of the hash chain:
          */
@@ -2133,6 +2779,8 @@ ZSC_PRIVATE block_state deflate_rle(deflate_state *s, ZlibFlush flush)
     I32 bflush;             /* set if current block must be flushed */
     U32 prev;              /* byte at distance one to match */
     U8 *scan, *strend;   /* scan goes up to strend for length of run */
+    U32 diff;              /* nonzero if a byte in a chunk differs */
+    U32 n;                 /* bytes in a chunk, or literals at once */
 
     for (;;) {
         /* Make sure that we always have enough lookahead, except
@@ -2156,19 +2804,31 @@ ZSC_PRIVATE block_state deflate_rle(deflate_state *s, ZlibFlush flush)
             scan = s->window + s->strstart - 1;
             prev = *scan;
             if (prev == scan[1] && prev == scan[2] && prev == scan[3]) {
-                scan+=3;
+                scan+=4;
                 strend = s->window + s->strstart + MAX_MATCH;
-                // Abcouwer ZSC - Modified scan to follow MISRA 13.5
-                do {
+                // Abcouwer ZSC - compare RLE_CHUNK bytes a step, with no
+                // early exit inside, so the compiler may vectorize it, then
+                // find the end of the run in the chunk that differs
+                diff = 0;
+                while (diff == 0 && scan + RLE_CHUNK <= strend) {
+                    for (n = 0; n < RLE_CHUNK; n++) {
+                        diff |= (U32)scan[n] ^ prev;
+                    }
+                    if (diff == 0) {
+                        scan += RLE_CHUNK;
+                    }
+                }
+                while (scan < strend && prev == *scan) {
                     scan++;
-                } while (prev == *scan && scan < strend);
+                }
                 s->match_length = MAX_MATCH - (U32)(strend - scan);
                 if (s->match_length > s->lookahead) {
                     s->match_length = s->lookahead;
                 }
             }
             // Assert: "wild scan"
-            ZSC_ASSERT3(scan <= s->window+(U32)(s->window_size-1),
+            // Abcouwer ZSC - follows from fill_window()'s lookahead assert
+            ZSC_ASSERT_PARANOID3(scan <= s->window+(U32)(s->window_size-1),
                     scan, s->window, s->window_size);
         }
 
@@ -2183,10 +2843,13 @@ ZSC_PRIVATE block_state deflate_rle(deflate_state *s, ZlibFlush flush)
             s->strstart += s->match_length;
             s->match_length = 0;
         } else {
-            /* No match, output a literal byte */
-            _tr_tally_lit (s, s->window[s->strstart], bflush);
-            s->lookahead--;
-            s->strstart++;
+            /* No match, output literal bytes up to the next run */
+            // Abcouwer ZSC - all at once, rather than a byte a pass
+            n = rle_literals(s);
+            tally_lits(s, s->window + s->strstart, n);
+            s->lookahead -= n;
+            s->strstart += n;
+            bflush = (s->last_lit == s->lit_bufsize-1);
         }
         if (bflush) {
             FLUSH_BLOCK(s, 0);
@@ -2211,7 +2874,7 @@ ZSC_PRIVATE block_state deflate_huff(deflate_state *s, ZlibFlush flush)
 {
     ZSC_ASSERT(s != Z_NULL);
 
-    I32 bflush;             /* set if current block must be flushed */
+    U32 n;                  /* literals to output at once */
 
     for (;;) {
         /* Make sure that we have a literal to write. */
@@ -2224,12 +2887,16 @@ ZSC_PRIVATE block_state deflate_huff(deflate_state *s, ZlibFlush flush)
             }
         }
 
-        /* Output a literal byte */
+        /* Output literal bytes */
+        // Abcouwer ZSC - as many as the window and the block hold at once
         s->match_length = 0;
-        _tr_tally_lit (s, s->window[s->strstart], bflush);
-        s->lookahead--;
-        s->strstart++;
-        if (bflush) {
+        ZSC_ASSERT2(s->last_lit < s->lit_bufsize-1,
+                s->last_lit, s->lit_bufsize);
+        n = ZMIN(s->lookahead, s->lit_bufsize-1 - s->last_lit);
+        tally_lits(s, s->window + s->strstart, n);
+        s->lookahead -= n;
+        s->strstart += n;
+        if (s->last_lit == s->lit_bufsize-1) {
             FLUSH_BLOCK(s, 0);
         }
     }
@@ -38,6 +38,12 @@
 
 // Abcouwer ZSC - no assembly included, warnings removed
 
+/* Abcouwer ZSC - modes of inflate_fast_mode(), one decoder for all */
+#define FAST_FIXED 1U   /* fixed code tables, see inflate_fast_fixed() */
+#define FAST_COUNT 2U   /* count the output only, see inflate_fast_count() */
+
+ZSC_PRIVATE void inflate_fast_mode(z_stream * strm, U32 start, U32 mode);
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -50,13 +56,14 @@
 
         state->mode == LEN
         strm->avail_in >= 6
-        strm->avail_out >= 258
+        strm->avail_out >= 1
         start >= strm->avail_out
         state->bits < 8
 
    On return, state->mode is one of:
 
-        LEN -- ran out of enough output space or enough available input
+        LEN -- ran out of enough output space or enough available input,
+               or the next match does not fit in the output space left
         TYPE -- reached end of block code, inflate() to interpret next block
         BAD -- error in block data
 
@@ -72,10 +79,53 @@
       bytes, which is the maximum length that can be coded.  inflate_fast()
       requires strm->avail_out >= 258 for each loop to avoid checking for
       output space.
+
+    - Abcouwer ZSC - Near the end of the output, each match length is checked
+      against the output space left instead, so that small output buffers
+      are decoded here too.  A match that does not fit is put back, leaving
+      its codes for inflate() to decode and copy in part.
  */
 void inflate_fast(strm, start)
 z_stream * strm;
 U32 start;         /* inflate()'s starting value for strm->avail_out */
+{
+    inflate_fast_mode(strm, start, 0);
+}
+
+/*
+   Abcouwer ZSC - version of inflate_fast() for fixed code blocks, whose
+   tables from fixedtables() have no second level: every length code fits
+   in FIXED_LENBITS and every distance code in FIXED_DISTBITS, so the bit
+   buffer needs fewer refills.  Entry assumptions and return modes are the
+   same as inflate_fast().
+ */
+void inflate_fast_fixed(strm, start)
+z_stream * strm;
+U32 start;         /* inflate()'s starting value for strm->avail_out */
+{
+    inflate_fast_mode(strm, start, FAST_FIXED);
+}
+
+/*
+   Abcouwer ZSC - counting version of inflate_fast(), for inflateCount().
+   Decodes the same codes with the same checks, but only counts the literal
+   and match bytes against strm->avail_out, without writing them or reading
+   the window.  strm->next_out is left untouched.  Entry assumptions and
+   return modes are the same as inflate_fast(), except that
+   strm->avail_out >= 258.
+ */
+void inflate_fast_count(strm, start)
+z_stream * strm;
+U32 start;         /* inflate()'s starting value for strm->avail_out */
+{
+    inflate_fast_mode(strm, start, FAST_COUNT);
+}
+
+/*
+   Abcouwer ZSC - the decoder of inflate_fast() and its variants.  mode
+   holds FAST_ flags, and the code for each differs only where noted.
+ */
+ZSC_PRIVATE void inflate_fast_mode(z_stream * strm, U32 start, U32 mode)
 {
     inflate_state *state;
     const U8 *in;      /* local strm->next_in */
@@ -83,6 +133,12 @@ U32 start;         /* inflate()'s starting value for strm->avail_out */
     U8 *out;     /* local strm->next_out */
     U8 *beg;     /* inflate()'s initial strm->next_out */
     U8 *end;     /* while out < end, enough space available */
+    U8 *limit;   /* end of the output space */
+    U32 count;             /* true to count the output only */
+    U32 left;              /* local strm->avail_out, when counting */
+    const U8 *sym_in;  /* in at the start of the current symbol */
+    U32 sym_hold;     /* hold at the start of the current symbol */
+    U32 sym_bits;          /* bits at the start of the current symbol */
     U32 dmax;              /* maximum distance from zlib header */
     U32 wsize;             /* window size or zero if not using window */
     U32 whave;             /* valid bytes in the window */
@@ -100,14 +156,28 @@ U32 start;         /* inflate()'s starting value for strm->avail_out */
     U32 len;               /* match length, unused bytes */
     U32 dist;              /* match distance */
     U8 *from;    /* where to copy match from */
+    U32 lneed;             /* bits wanted in hold to decode a length code */
+    U32 dneed;             /* bits wanted in hold to decode a distance code */
 
     /* copy state to local variables */
     state = (inflate_state *)strm->state;
     in = strm->next_in;
     last = in + (strm->avail_in - 5);
     out = strm->next_out;
-    beg = out - (start - strm->avail_out);
-    end = out + (strm->avail_out - 257);
+    count = mode & FAST_COUNT;
+    if (count) {
+        // Abcouwer ZSC - nothing is written, so next_out may not be a buffer
+        ZSC_ASSERT1(strm->avail_out >= 258, strm->avail_out);
+        left = strm->avail_out;
+        beg = out;
+        limit = out;
+        end = out;
+    } else {
+        left = 0;
+        beg = out - (start - strm->avail_out);
+        limit = out + strm->avail_out;
+        end = strm->avail_out >= 258 ? out + (strm->avail_out - 257) : limit;
+    }
     dmax = state->dmax;
     wsize = state->wsize;
     whave = state->whave;
@@ -119,11 +189,24 @@ U32 start;         /* inflate()'s starting value for strm->avail_out */
     dcode = state->distcode;
     lmask = (1U << state->lenbits) - 1;
     dmask = (1U << state->distbits) - 1;
+    // Abcouwer ZSC - the longest codes of the tables need the most bits
+    if (mode & FAST_FIXED) {
+        ZSC_ASSERT1(state->lenbits == FIXED_LENBITS, state->lenbits);
+        ZSC_ASSERT1(state->distbits == FIXED_DISTBITS, state->distbits);
+        lneed = FIXED_LENBITS;
+        dneed = FIXED_DISTBITS;
+    } else {
+        lneed = 15;
+        dneed = 15;
+    }
 
     /* decode literals and length/distances until end-of-block or not enough
        input data or output space */
     do {
-        if (bits < 15) {
+        sym_in = in;
+        sym_hold = hold;
+        sym_bits = bits;
+        if (bits < lneed) {
             hold += (U32)(*in) << bits;
             in++;
             bits += 8;
@@ -138,7 +221,11 @@ U32 start;         /* inflate()'s starting value for strm->avail_out */
         bits -= op;
         op = (U32)(here.op);
         if (op == 0) {                          /* literal */
-            *out++ = (U8)(here.val);
+            if (count) {
+                left--;
+            } else {
+                *out++ = (U8)(here.val);
+            }
         }
         else if (op & 16) {                     /* length base */
             len = (U32)(here.val);
@@ -153,7 +240,14 @@ U32 start;         /* inflate()'s starting value for strm->avail_out */
                 hold >>= op;
                 bits -= op;
             }
-            if (bits < 15) {
+            // Abcouwer ZSC - put back a match that does not fit
+            if (len > (count ? left : (U32)(limit - out))) {
+                in = sym_in;
+                hold = sym_hold;
+                bits = sym_bits;
+                break;
+            }
+            if (bits < dneed) {
                 hold += (U32)(*in) << bits;
                 in++;
                 bits += 8;
@@ -189,6 +283,17 @@ U32 start;         /* inflate()'s starting value for strm->avail_out */
                 }
                 hold >>= op;
                 bits -= op;
+                // Abcouwer ZSC - when counting, check the match and count it
+                if (count) {
+                    op = start - left;          /* max distance in output */
+                    if (dist > op && dist - op > whave && state->sane) {
+                        strm->msg = (U8*)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    left -= len;
+                    continue;
+                }
                 op = (U32)(out - beg);     /* max distance in output */
                 if (dist > op) {                /* see if copy from window */
                     op = dist - op;             /* distance back in window */
@@ -294,7 +399,7 @@ U32 start;         /* inflate()'s starting value for strm->avail_out */
             state->mode = BAD;
             break;
         }
-    } while (in < last && out < end);
+    } while (in < last && (count ? left >= 258 : out < end));
 
     /* return unused bytes (on entry, bits < 8, so in won't go too far back) */
     len = bits >> 3;
@@ -304,10 +409,13 @@ U32 start;         /* inflate()'s starting value for strm->avail_out */
 
     /* update state and return */
     strm->next_in = in;
-    strm->next_out = out;
     strm->avail_in = (U32)(in < last ? 5 + (last - in) : 5 - (in - last));
-    strm->avail_out = (U32)(out < end ?
-                                 257 + (end - out) : 257 - (out - end));
+    if (count) {
+        strm->avail_out = left;
+    } else {
+        strm->next_out = out;
+        strm->avail_out = (U32)(limit - out);
+    }
     state->hold = hold;
     state->bits = bits;
     return;
@@ -304,6 +304,7 @@ ZlibReturn inflateResetKeep(z_stream * strm)
     state->bits = 0;
     state->lencode = state->distcode = state->next = state->codes;
     state->sane = 1;
+    state->count = 0;
     state->back = -1;
     return Z_OK;
 }
@@ -459,9 +460,9 @@ ZSC_PRIVATE void fixedtables(inflate_state *state)
     ZSC_ASSERT(state != Z_NULL);
 
     state->lencode = lenfix;
-    state->lenbits = 9;
+    state->lenbits = FIXED_LENBITS;
     state->distcode = distfix;
-    state->distbits = 5;
+    state->distbits = FIXED_DISTBITS;
 }
 
 /*
@@ -706,6 +707,7 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
     inflate_state *state;
     const U8 *next;    /* next input */
     U8 *put;     /* next output */
+    U8 *chk;     /* first output not yet included in the check value */
     U32 have, left;        /* available input and output */
     U32 hold;         /* bit buffer */
     U32 bits;              /* bits in bit buffer */
@@ -734,6 +736,7 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
     LOAD();
     in = have;
     out = left;
+    chk = put;
     ret = Z_OK;
     for (;;) {
         switch (state->mode) {
@@ -1037,11 +1040,21 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
                 if (copy == 0) {
                     goto inf_leave;
                 }
-                zmemcpy(put, next, copy);
+                if (!state->count) {
+                    zmemcpy(put, next, copy);
+                    put += copy;
+                    // Abcouwer ZSC - update the check while the stored
+                    // data is still in cache, rather than rereading all of
+                    // the output on return
+                    if (state->wrap & 4) {
+                        strm->adler = state->check =
+                            UPDATE(state->check, chk, (U32)(put - chk));
+                        chk = put;
+                    }
+                }
                 have -= copy;
                 next += copy;
                 left -= copy;
-                put += copy;
                 state->length -= copy;
                 break;
             }
@@ -1180,14 +1193,26 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
             state->mode = LEN;
             break;
         case LEN:
-            if (have >= 6 && left >= 258) {
+            // Abcouwer ZSC - inflate_fast() also takes a small output
+            // space, and stops before a match that does not fit in it
+            if (have >= 6 && left >= (state->count ? 258U : 1U)) {
                 RESTORE();
-                inflate_fast(strm, out);
+                if (state->count) {
+                    inflate_fast_count(strm, out);
+                } else if (state->lencode == lenfix) {
+                    inflate_fast_fixed(strm, out);
+                } else {
+                    inflate_fast(strm, out);
+                }
                 LOAD();
                 if (state->mode == TYPE) {
                     state->back = -1;
                 }
-                break;
+                if (state->mode != LEN || have < 6 || left == 0
+                        || left >= 258) {
+                    break;
+                }
+                /* the next match does not fit: decode it here */
             }
             state->back = 0;
             for (;;) {
@@ -1283,6 +1308,21 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
         case MATCH:
             if (left == 0) goto inf_leave;
             copy = out - left;
+            if (state->count) {                 /* count without copying */
+                if (state->offset > copy
+                        && state->offset - copy > state->whave
+                        && state->sane) {
+                    strm->msg = (U8*)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+                copy = state->length;
+                if (copy > left) copy = left;
+                left -= copy;
+                state->length -= copy;
+                if (state->length == 0) state->mode = LEN;
+                break;
+            }
             if (state->offset > copy) {         /* copy from window */
                 copy = state->offset - copy;
                 if (copy > state->whave) {
@@ -1315,7 +1355,9 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
             break;
         case LIT:
             if (left == 0) goto inf_leave;
-            *put++ = (U8)(state->length);
+            if (!state->count) {
+                *put++ = (U8)(state->length);
+            }
             left--;
             state->mode = LEN;
             break;
@@ -1325,12 +1367,13 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
                 out -= left;
                 strm->total_out += out;
                 state->total += out;
-                if ((state->wrap & 4) && out) {
+                if ((state->wrap & 4) && !state->count && put != chk) {
                     strm->adler = state->check =
-                        UPDATE(state->check, put - out, out);
+                        UPDATE(state->check, chk, (U32)(put - chk));
                 }
+                chk = put;
                 out = left;
-                if ((state->wrap & 4)
+                if ((state->wrap & 4) && !state->count
                         && (state->flags ? hold : ZSWAP32(hold)) != state->check) {
                     strm->msg = (U8*) "incorrect data check";
                     state->mode = BAD;
@@ -1377,7 +1420,12 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
      */
   inf_leave:
     RESTORE();
-    if (state->wsize || (out != strm->avail_out && state->mode < BAD &&
+    if (state->count) {
+        /* no window when counting, just track how far back distances may go */
+        copy = out - strm->avail_out;
+        len = 1U << state->wbits;
+        state->whave = (copy >= len - state->whave) ? len : state->whave + copy;
+    } else if (state->wsize || (out != strm->avail_out && state->mode < BAD &&
             (state->mode < CHECK || flush != Z_FINISH))) {
         if (updatewindow(strm, strm->next_out, out - strm->avail_out)) {
             state->mode = MEM;
@@ -1390,9 +1438,9 @@ ZlibReturn inflate(z_stream * strm, ZlibFlush flush)
     strm->total_in += in;
     strm->total_out += out;
     state->total += out;
-    if ((state->wrap & 4) && out) {
+    if ((state->wrap & 4) && !state->count && strm->next_out != chk) {
         strm->adler = state->check =
-            UPDATE(state->check, strm->next_out - out, out);
+            UPDATE(state->check, chk, (U32)(strm->next_out - chk));
     }
     strm->data_type = (I32)state->bits + (state->last ? 64 : 0) +
                       (state->mode == TYPE ? 128 : 0) +
@@ -1626,8 +1674,273 @@ ZlibReturn inflateSyncPoint(z_stream * strm)
     return state->mode == STORED && state->bits == 0;
 }
 
-// Abcouwer ZSC - remove inflateCopy()
-// copying then doing allocs will spool more memory from the work buffer
+/* Abcouwer ZSC - inflateCopy() returns as inflateCopyTo().  Rather than
+ * allocating, the copy is carved from dest's own work buffer, which the
+ * caller provides in dest->next_work and dest->avail_work.
+ */
+ZlibReturn inflateCopyTo(z_stream * dest, z_stream * source)
+{
+    inflate_state *state;
+    inflate_state *copy;
+    U8 *window;
+    U8 *next_work;
+    U32 avail_work;
+    U32 work_size = U32_MAX;
+
+    /* check input */
+    if (inflateStateCheck(source) || dest == Z_NULL || dest == source) {
+        ZSC_WARN("In inflateCopyTo(), bad stream.");
+        return Z_STREAM_ERROR;
+    }
+    ZSC_ASSERT(source != Z_NULL);
+    state = (inflate_state *)source->state;
+    ZSC_ASSERT(state != Z_NULL);
+
+    if (dest->next_work == Z_NULL
+            || inflateWorkSize2((I32)state->wbits, &work_size) != Z_OK
+            || dest->avail_work < work_size) {
+        ZSC_WARN2("In inflateCopyTo(), bad dest work buffer: %d %d.",
+                dest->next_work == Z_NULL, dest->avail_work < work_size);
+        return Z_STREAM_ERROR;
+    }
+
+    /* copy stream, keeping dest's work buffer */
+    next_work = dest->next_work;
+    avail_work = dest->avail_work;
+    zmemcpy((void *)dest, (void *)source, sizeof(z_stream));
+    dest->next_work = next_work;
+    dest->avail_work = avail_work;
+
+    /* carve state, and window if source has one yet */
+    copy = (inflate_state *)
+        inflate_get_work_mem(dest, 1, sizeof(inflate_state));
+    ZSC_ASSERT(copy != Z_NULL);
+    window = Z_NULL;
+    if (state->window != Z_NULL) {
+        window = (U8 *)
+            inflate_get_work_mem(dest, 1U << state->wbits, sizeof(U8));
+        ZSC_ASSERT(window != Z_NULL);
+    }
+
+    /* copy state */
+    zmemcpy((void *)copy, (void *)state, sizeof(inflate_state));
+    copy->strm = dest;
+    if (state->lencode >= state->codes &&
+        state->lencode <= state->codes + ENOUGH - 1) {
+        copy->lencode = copy->codes + (state->lencode - state->codes);
+        copy->distcode = copy->codes + (state->distcode - state->codes);
+    }
+    copy->next = copy->codes + (state->next - state->codes);
+    if (window != Z_NULL) {
+        zmemcpy(window, state->window, 1U << state->wbits);
+    }
+    copy->window = window;
+    dest->state = (struct internal_state *)copy;
+    return Z_OK;
+}
+
+/* Abcouwer ZSC - checkpoint and resume, as for deflateSaveState().  The
+ * image is a header of little-endian U32s, the state struct with its
+ * pointers zeroed, the valid part of the window, and a CRC-32.  The code
+ * table pointers are saved as offsets into codes[], or as a marker for the
+ * fixed tables.
+ */
+#define INFLATE_IMAGE_MAGIC 0x5a534349UL /* "ZSCI" */
+#define INFLATE_IMAGE_HEADER (11*4)
+#define INFLATE_IMAGE_FIXED U32_MAX
+
+ZlibReturn inflateStateImageBound(I32 windowBits, U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+    *size_out = U32_MAX;
+
+    // the work buffer holds the state and window
+    U32 work_size = U32_MAX;
+    ZlibReturn err = inflateWorkSize2(windowBits, &work_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    *size_out = INFLATE_IMAGE_HEADER + work_size + 4;
+    return Z_OK;
+}
+
+ZlibReturn inflateSaveState(z_stream * strm, U8 *image, U32 *image_len)
+{
+    inflate_state *state;
+
+    if (inflateStateCheck(strm) || image == Z_NULL || image_len == Z_NULL) {
+        ZSC_WARN("In inflateSaveState(), bad stream or image.");
+        return Z_STREAM_ERROR;
+    }
+    ZSC_ASSERT(strm != Z_NULL);
+    state = (inflate_state *)strm->state;
+    ZSC_ASSERT(state != Z_NULL);
+
+    // the gzip header is not saved, so it must already be read
+    if (state->head != Z_NULL && state->mode < DICTID) {
+        ZSC_WARN1("In inflateSaveState(), gzip header not yet read, "
+                "mode %d.", state->mode);
+        return Z_STREAM_ERROR;
+    }
+
+    // the window fills from the start, and only wraps once full
+    U32 window_len = (state->window != Z_NULL) ? state->whave : 0;
+    U32 len = INFLATE_IMAGE_HEADER + (U32)sizeof(inflate_state)
+            + window_len + 4;
+    if (*image_len < len) {
+        ZSC_WARN2("In inflateSaveState(), image buffer (%u B) smaller "
+                "than needed (%u B).", *image_len, len);
+        *image_len = len;
+        return Z_BUF_ERROR;
+    }
+
+    U32 lenoff = INFLATE_IMAGE_FIXED;
+    U32 distoff = INFLATE_IMAGE_FIXED;
+    if (state->lencode != lenfix) {
+        lenoff = (U32)(state->lencode - state->codes);
+        distoff = (U32)(state->distcode - state->codes);
+    }
+
+    U8 *p = image;
+    zsc_put_u32_le(p, INFLATE_IMAGE_MAGIC);
+    zsc_put_u32_le(p + 4, (U32)sizeof(inflate_state));
+    zsc_put_u32_le(p + 8, state->window != Z_NULL);
+    zsc_put_u32_le(p + 12, window_len);
+    zsc_put_u32_le(p + 16, lenoff);
+    zsc_put_u32_le(p + 20, distoff);
+    zsc_put_u32_le(p + 24, (U32)(state->next - state->codes));
+    zsc_put_u32_le(p + 28, strm->total_in);
+    zsc_put_u32_le(p + 32, strm->total_out);
+    zsc_put_u32_le(p + 36, strm->adler);
+    zsc_put_u32_le(p + 40, (U32)strm->data_type);
+    p += INFLATE_IMAGE_HEADER;
+
+    zmemcpy(p, (U8 *)state, sizeof(inflate_state));
+    IMAGE_CLEAR(p, state, strm);
+    IMAGE_CLEAR(p, state, head);
+    IMAGE_CLEAR(p, state, window);
+    IMAGE_CLEAR(p, state, lencode);
+    IMAGE_CLEAR(p, state, distcode);
+    IMAGE_CLEAR(p, state, next);
+    p += sizeof(inflate_state);
+
+    if (window_len != 0) {
+        zmemcpy(p, state->window, window_len);
+        p += window_len;
+    }
+
+    ZSC_ASSERT2((U32)(p - image) + 4 == len, (U32)(p - image), len);
+    zsc_put_u32_le(p, crc32(0L, image, len - 4));
+    *image_len = len;
+    return Z_OK;
+}
+
+ZlibReturn inflateLoadState(z_stream * strm, const U8 *image, U32 image_len)
+{
+    inflate_state *state;
+
+    if (strm == Z_NULL || image == Z_NULL || strm->next_work == Z_NULL) {
+        ZSC_WARN("In inflateLoadState(), bad stream or image.");
+        return Z_STREAM_ERROR;
+    }
+
+    // check the header and CRC before touching the stream
+    if (image_len < INFLATE_IMAGE_HEADER + sizeof(inflate_state) + 4
+            || zsc_get_u32_le(image) != INFLATE_IMAGE_MAGIC
+            || zsc_get_u32_le(image + 4) != (U32)sizeof(inflate_state)) {
+        ZSC_WARN1("In inflateLoadState(), not an image from this build "
+                "(%u B).", image_len);
+        return Z_DATA_ERROR;
+    }
+    if (crc32(0L, image, image_len - 4)
+            != zsc_get_u32_le(image + image_len - 4)) {
+        ZSC_WARN("In inflateLoadState(), image CRC mismatch.");
+        return Z_DATA_ERROR;
+    }
+    U32 has_window = zsc_get_u32_le(image + 8);
+    U32 window_len = zsc_get_u32_le(image + 12);
+    U32 lenoff = zsc_get_u32_le(image + 16);
+    U32 distoff = zsc_get_u32_le(image + 20);
+    U32 nextoff = zsc_get_u32_le(image + 24);
+
+    // carve the state as inflateInit2_() does, then fill it from the image
+    U8 *next_work = strm->next_work;
+    U32 avail_work = strm->avail_work;
+    state = (inflate_state *)
+        inflate_get_work_mem(strm, 1, sizeof(inflate_state));
+    if (state == Z_NULL) {
+        ZSC_WARN("In inflateLoadState(), could not get memory for state.");
+        return Z_STREAM_ERROR;
+    }
+    const U8 *p = image + INFLATE_IMAGE_HEADER;
+    zmemcpy((U8 *)state, p, sizeof(inflate_state));
+    p += sizeof(inflate_state);
+
+    // the struct was covered by the CRC, but check what would index memory
+    U32 wsize = 1U << state->wbits;
+    if (state->mode < HEAD || state->mode > SYNC
+            || state->wbits > MAX_WBITS || has_window > 1
+            || (has_window && (state->wbits < 8
+                || (state->wsize != 0 && state->wsize != wsize)
+                || state->whave > wsize || state->wnext >= wsize
+                || window_len != state->whave))
+            || (!has_window && window_len != 0)
+            || (lenoff == INFLATE_IMAGE_FIXED) != (distoff == INFLATE_IMAGE_FIXED)
+            || (lenoff != INFLATE_IMAGE_FIXED
+                && (lenoff >= ENOUGH || distoff >= ENOUGH))
+            || nextoff > ENOUGH
+            || state->have > 320 || state->ncode > 19
+            || state->nlen > 288 || state->ndist > 32
+            || state->bits > 32
+            || (state->bits < 32 && (state->hold >> state->bits) != 0)
+            || state->last < 0 || state->last > 1
+            || state->wrap < 0 || state->wrap > 7
+            || image_len != INFLATE_IMAGE_HEADER + sizeof(inflate_state)
+                + window_len + 4) {
+        ZSC_WARN("In inflateLoadState(), inconsistent image.");
+        strm->next_work = next_work;
+        strm->avail_work = avail_work;
+        return Z_DATA_ERROR;
+    }
+
+    // the window must fit now; a missing one is carved later, as usual
+    state->window = Z_NULL;
+    if (has_window) {
+        state->window = (U8 *)inflate_get_work_mem(strm, wsize, sizeof(U8));
+        if (state->window == Z_NULL) {
+            ZSC_WARN2("In inflateLoadState(), work buffer (%u B) smaller "
+                    "than needed (%u B).", avail_work,
+                    (U32)sizeof(inflate_state) + wsize);
+            strm->next_work = next_work;
+            strm->avail_work = avail_work;
+            return Z_STREAM_ERROR;
+        }
+        zmemcpy(state->window, p, window_len);
+    }
+
+    if (lenoff == INFLATE_IMAGE_FIXED) {
+        state->lencode = lenfix;
+        state->distcode = distfix;
+    } else {
+        state->lencode = state->codes + lenoff;
+        state->distcode = state->codes + distoff;
+    }
+    state->next = state->codes + nextoff;
+    state->head = Z_NULL;
+
+    strm->state = (struct internal_state *)state;
+    state->strm = strm;
+    strm->total_in = zsc_get_u32_le(image + 28);
+    strm->total_out = zsc_get_u32_le(image + 32);
+    strm->adler = zsc_get_u32_le(image + 36);
+    strm->data_type = (ZlibDataType)zsc_get_u32_le(image + 40);
+    strm->msg = Z_NULL;
+    strm->next_in = Z_NULL;
+    strm->avail_in = 0;
+    strm->next_out = Z_NULL;
+    strm->avail_out = 0;
+    return Z_OK;
+}
 
 ZlibReturn inflateUndermine(z_stream * strm, I32 subvert)
 {
@@ -1646,6 +1959,24 @@ ZlibReturn inflateUndermine(z_stream * strm, I32 subvert)
     return Z_DATA_ERROR;
 }
 
+ZlibReturn inflateCount(z_stream * strm, I32 count)
+{
+    inflate_state *state;
+
+    if (inflateStateCheck(strm)) {
+        ZSC_WARN("In inflateCount(), bad state.");
+        return Z_STREAM_ERROR;
+    }
+
+    ZSC_ASSERT(strm != Z_NULL);
+    state = (inflate_state *)strm->state;
+    ZSC_ASSERT(state != Z_NULL);
+    // the check value can't be computed without the data, so inflate()
+    // skips it while counting, leaving the wrap flags for inflateReset()
+    state->count = count ? 1 : 0;
+    return Z_OK;
+}
+
 ZlibReturn inflateValidate(z_stream * strm, I32 check)
 {
     inflate_state *state;
@@ -267,6 +267,7 @@ ZSC_PRIVATE void send_all_trees (deflate_state *s, I32 lcodes, I32 dcodes,
                                 I32 blcodes);
 ZSC_PRIVATE void compress_block (deflate_state *s, const ct_data *ltree,
                               const ct_data *dtree);
+ZSC_PRIVATE void compress_literals (deflate_state *s, const ct_data *ltree);
 ZSC_PRIVATE I32  detect_data_type (deflate_state *s);
 ZSC_PRIVATE U32  bi_reverse (U32 value, I32 length);
 ZSC_PRIVATE void bi_windup      (deflate_state *s);
@@ -314,6 +315,24 @@ void _tr_init(deflate_state *s)
 
     // Abcouwer ZSC - no static init needed, tables hardcoded
 
+    _tr_init_desc(s);
+
+    s->bi_buf = 0;
+    s->bi_valid = 0;
+
+    /* Initialize the first block of the first file: */
+    init_block(s);
+}
+
+/* ===========================================================================
+ * Abcouwer ZSC - Point the tree descriptors at this state's trees and the
+ * static trees, without touching the trees. Used by _tr_init() and when
+ * loading a saved state.
+ */
+void _tr_init_desc(deflate_state *s)
+{
+    ZSC_ASSERT(s != Z_NULL);
+
     s->l_desc.dyn_tree = s->dyn_ltree;
     s->l_desc.stat_desc = &static_l_desc;
 
@@ -322,12 +341,6 @@ void _tr_init(deflate_state *s)
 
     s->bl_desc.dyn_tree = s->bl_tree;
     s->bl_desc.stat_desc = &static_bl_desc;
-
-    s->bi_buf = 0;
-    s->bi_valid = 0;
-
-    /* Initialize the first block of the first file: */
-    init_block(s);
 }
 
 /* ===========================================================================
@@ -955,7 +968,11 @@ ZSC_PRIVATE void compress_block(deflate_state *s,
     U32 code;      /* the code to send */
     I32 extra;          /* number of extra bits to send */
 
-    if (s->last_lit != 0) do {
+    // Abcouwer ZSC - blocks of only literals, as from Z_HUFFMAN_ONLY or
+    // incompressible data, are sent by a simpler loop
+    if (s->last_lit != 0 && s->matches == 0) {
+        compress_literals(s, ltree);
+    } else if (s->last_lit != 0) do {
         dist = s->d_buf[lx];
         lc = s->l_buf[lx++];
         if (dist == 0) {
@@ -972,7 +989,8 @@ ZSC_PRIVATE void compress_block(deflate_state *s,
             dist--; /* dist is now the match distance - 1 */
             code = d_code(dist);
             // Assert: "bad d_code"
-            ZSC_ASSERT2(code < D_CODES, code, D_CODES);
+            // Abcouwer ZSC - _dist_code only holds codes below D_CODES
+            ZSC_ASSERT_PARANOID2(code < D_CODES, code, D_CODES);
 
             send_code(s, code, dtree);       /* send the distance code */
             extra = extra_dbits[code];
@@ -984,14 +1002,58 @@ ZSC_PRIVATE void compress_block(deflate_state *s,
 
         /* Check that the overlay between pending_buf and d_buf+l_buf is ok: */
         // Assert: "pendingBuf overflow"
-        ZSC_ASSERT3(s->pending < s->lit_bufsize + 2*lx,
+        ZSC_ASSERT_PARANOID3(s->pending < s->lit_bufsize + 2*lx,
                 s->pending, s->lit_bufsize, lx);
 
     } while (lx < s->last_lit);
 
+    // Abcouwer ZSC - check the overlay once per block, not once per symbol
+    // Assert: "pendingBuf overflow"
+    ZSC_ASSERT3(s->last_lit == 0
+            || s->pending < s->lit_bufsize + 2*s->last_lit,
+            s->pending, s->lit_bufsize, s->last_lit);
+
     send_code(s, END_BLOCK, ltree);
 }
 
+/* ===========================================================================
+ * Abcouwer ZSC - Send the literals of a block that has no matches, with the
+ * same bits as compress_block(). The bit buffer is widened to 32 bits and
+ * kept, with the pending count, in locals, so each code is one shift and or,
+ * and two bytes are written out once 16 bits are ready.
+ */
+ZSC_PRIVATE void compress_literals(deflate_state *s, const ct_data *ltree)
+{
+    ZSC_ASSERT(s != Z_NULL);
+    ZSC_ASSERT(ltree != Z_NULL);
+    ZSC_ASSERT2(s->bi_valid >= 0 && s->bi_valid <= Buf_size,
+            s->bi_valid, Buf_size);
+
+    U8 *out = s->pending_buf;
+    U32 pending = s->pending;
+    U32 bits = s->bi_buf;       /* bits not yet written out */
+    U32 valid = (U32)s->bi_valid; /* number of them, below 16 between codes */
+    U32 lx;
+    U32 lc;
+
+    for (lx = 0; lx < s->last_lit; lx++) {
+        ZSC_ASSERT_PARANOID1(s->d_buf[lx] == 0, s->d_buf[lx]);
+        lc = s->l_buf[lx];
+        /* codes are at most 15 bits, so no bits are lost */
+        bits |= (U32)ltree[lc].Code << valid;
+        valid += ltree[lc].Len;
+        if (valid >= Buf_size) {
+            out[pending++] = (U8)(bits & 0xff);
+            out[pending++] = (U8)((bits >> 8) & 0xff);
+            bits >>= Buf_size;
+            valid -= Buf_size;
+        }
+    }
+    s->pending = pending;
+    s->bi_buf = (U16)bits;
+    s->bi_valid = (I32)valid;
+}
+
 /* ===========================================================================
  * Check if the data type is TEXT or BINARY, using the following algorithm:
  * - TEXT if the two conditions below are satisfied:
@@ -29,69 +29,243 @@
 #include "zsc/zutil.h"
 #include "zsc/zsc_conf_private.h"
 
+// size of the scratch buffer that verification inflates into
+#define ZSC_VERIFY_CHUNK 4096U
+
+ZSC_PRIVATE ZlibReturn zsc_compress_gzip_common(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header, I32 write_info, U32 *bad_block,
+        const zsc_filter *filter, const zsc_dict *dict, const char *caller);
+ZSC_PRIVATE ZlibReturn zsc_compress_gzip_buf(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header, I32 write_info, U32 *bad_block,
+        const zsc_filter *filter, const zsc_dict *dict, const char *caller);
+ZSC_PRIVATE ZlibReturn zsc_verify_output(z_stream *check, U8 *check_out,
+        const U8 *comp, U32 comp_len, const U8 *source, U32 source_len,
+        U32 *bad_pos);
+ZSC_PRIVATE void zsc_put_info(U8 *buf, const zsc_info *info);
+ZSC_PRIVATE ZlibReturn zsc_race_sizes(U32 max_block_len, I32 window_bits,
+        I32 mem_level, U32 *state_len, U32 *scratch_len);
+
 /* ===========================================================================
-     Compresses the source buffer into the destination buffer,
+     Compresses the source segments into the destination segments,
    using memory from the work buffer.  The level
-   parameter has the same meaning as in deflateInit.  source_len is the byte
-   length of the source buffer. Upon entry, dest_len is the total size of the
-   destination buffer, which must be at least 0.1% larger than source_len plus
-   12 bytes. Upon exit, dest_len is the actual size of the compressed buffer.
-   work_len is the size of the work buffer.
+   parameter has the same meaning as in deflateInit.  The source is the
+   concatenation of its source_cnt segments, and output is written across
+   the dest_cnt dest segments in order; the single buffer entry points pass
+   one of each. The total dest length must be at least 0.1% larger than the
+   source length plus 12 bytes. Upon exit, dest_len is the actual size of the
+   compressed output. work_len is the size of the work buffer.
 
      If gz_header is not null, will use that as the gzip header,
    if window_bits set appropriately for gzip header.
 
+     If write_info is set, a zsc info subfield (see zsc_pub.h) is added to the
+   front of the gzip extra field, ahead of any extra field in gz_header.
+
+     If bad_block is not null, the output is inflated as it is produced, using
+   the end of the work buffer, and compared against the source.  On a mismatch,
+   *bad_block gets the index of the first max_block_len block that differs,
+   and Z_DATA_ERROR is returned.
+
+     If filter is not null, the filter header is written first, and each
+   max_block_len section of the source is filtered into the end of the work
+   buffer before it is deflated.  Not combined with bad_block.  Filtering
+   and verification take a single source and dest segment.
+
+     If dict is not null, it is preset with deflateSetDictionary() before
+   the first block, and its id goes in the zlib header.  Not combined with
+   bad_block.
+
+     caller is the name of the public entry point, for warnings.
+
      compress_safe returns Z_OK if success, Z_MEM_ERROR if there was not enough
    memory, Z_BUF_ERROR if there was not enough room in the output buffer,
    Z_STREAM_ERROR if the level parameter is invalid.
 */
 
 // compress using a work buffer instead of dynamic memory
-ZlibReturn zsc_compress_gzip2(
-        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+ZSC_PRIVATE ZlibReturn zsc_compress_gzip_common(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt,
         U32 max_block_len, U8 *work, U32 work_len, I32 level,
         I32 window_bits, I32 mem_level, ZlibStrategy strategy,
-        gz_header * gz_header)
+        gz_header * gz_header, I32 write_info, U32 *bad_block,
+        const zsc_filter *filter, const zsc_dict *dict, const char *caller)
 {
-    ZSC_ASSERT(source != Z_NULL);
-    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(source != Z_NULL || source_cnt == 0);
+    ZSC_ASSERT(dest != Z_NULL || dest_cnt == 0);
     ZSC_ASSERT(dest_len != Z_NULL);
     ZSC_ASSERT(work != Z_NULL);
+    ZSC_ASSERT(caller != Z_NULL);
     // gz_header can be null
+    // bad_block can be null
+    // filter can be null
+    // dict can be null
+    ZSC_ASSERT(bad_block == Z_NULL || filter == Z_NULL);
+    ZSC_ASSERT(bad_block == Z_NULL || dict == Z_NULL);
+    // filtering and verification work on whole buffers
+    ZSC_ASSERT(filter == Z_NULL || (source_cnt == 1 && dest_cnt == 1));
+    ZSC_ASSERT(bad_block == Z_NULL || (source_cnt == 1 && dest_cnt == 1));
 
-    U32 dest_len_in = *dest_len;
     *dest_len = 0; // nothing yet written to output
 
-    z_stream stream;
-    zmemzero((U8*)&stream, sizeof(stream));
-    stream.next_work = work;
-    stream.avail_work = work_len;
-    stream.next_out = dest;
-    stream.avail_out = 0;
-    stream.next_in = (const U8 *)source;
-    stream.avail_in = 0;
+    // total up the segments, rejecting lists that would overflow a U32
+    U32 source_len = 0;
+    U32 dest_len_in = 0;
+    U32 seg;
+    for (seg = 0; seg < source_cnt; seg++) {
+        ZSC_ASSERT(source[seg].base != Z_NULL || source[seg].len == 0);
+        if (source[seg].len > U32_MAX - source_len) {
+            ZSC_WARN2("In %s, source segments overflow at segment %u.",
+                    caller, seg);
+            return Z_STREAM_ERROR;
+        }
+        source_len += source[seg].len;
+    }
+    for (seg = 0; seg < dest_cnt; seg++) {
+        ZSC_ASSERT(dest[seg].base != Z_NULL || dest[seg].len == 0);
+        // more output space than a U32 can count is never needed
+        dest_len_in += ZMIN(dest[seg].len, U32_MAX - dest_len_in);
+    }
+
+    // header with the info subfield, must outlive the deflate loop
+    struct gz_header_s info_header;
+    U8 info_extra[ZSC_INFO_EXTRA_MAX];
+    if (write_info) {
+        if (window_bits <= MAX_WBITS) {
+            ZSC_WARN2("In %s, info requested without "
+                    "gzip wrapper, window_bits %d.", caller, window_bits);
+            return Z_STREAM_ERROR;
+        }
+        ZSC_ASSERT(max_block_len != 0);
+        U32 caller_extra_len = 0;
+        if (gz_header != Z_NULL) {
+            info_header = *gz_header;
+            if (gz_header->extra != Z_NULL) {
+                caller_extra_len = gz_header->extra_len;
+            }
+        } else {
+            zmemzero((U8*)&info_header, sizeof(info_header));
+            info_header.os = OS_CODE;
+        }
+        if (caller_extra_len > ZSC_INFO_EXTRA_MAX - ZSC_INFO_SUBFIELD_LEN) {
+            ZSC_WARN3("In %s, extra field (%u B) too long "
+                    "to add info, max %u B.", caller, caller_extra_len,
+                    ZSC_INFO_EXTRA_MAX - ZSC_INFO_SUBFIELD_LEN);
+            return Z_STREAM_ERROR;
+        }
+        zsc_info info;
+        info.source_len = source_len;
+        info.num_blocks = source_len / max_block_len
+                + ((source_len % max_block_len != 0) ? 1 : 0);
+        info.max_block_len = max_block_len;
+        zsc_put_info(info_extra, &info);
+        if (caller_extra_len > 0) {
+            zmemcpy(info_extra + ZSC_INFO_SUBFIELD_LEN, gz_header->extra,
+                    caller_extra_len);
+        }
+        info_header.extra = info_extra;
+        info_header.extra_len = ZSC_INFO_SUBFIELD_LEN + caller_extra_len;
+        gz_header = &info_header;
+    }
 
     // check if work buffer is large enough
     U32 min_work_buf_size = U32_MAX;
-    ZlibReturn err = zsc_compress_get_min_work_buf_size2(window_bits, mem_level,
-            &min_work_buf_size);
+    ZlibReturn err = (bad_block == Z_NULL)
+            ? zsc_compress_get_min_work_buf_size2(window_bits, mem_level,
+                    &min_work_buf_size)
+            : zsc_compress_verify_get_min_work_buf_size2(window_bits,
+                    mem_level, &min_work_buf_size);
     if (err != Z_OK) {
-        ZSC_WARN1("In zsc_compress_gzip2(), could not get min work buf size, "
-                 "error %d.", err);
+        ZSC_WARN2("In %s, could not get min work buf size, "
+                 "error %d.", caller, err);
         return err;
     }
     if (work_len < min_work_buf_size) {
-        ZSC_WARN2("In zsc_compress_gzip2(), working memory (%u B) "
-                "was smaller than required (%u B).",
+        ZSC_WARN3("In %s, working memory (%u B) "
+                "was smaller than required (%u B).", caller,
                 work_len, min_work_buf_size);
         return Z_MEM_ERROR;
     }
 
+    // filtering takes a block at the end of the work buffer,
+    // and writes its header ahead of the deflate stream
+    U8 *filter_buf = Z_NULL;
+    U32 header_len = 0;
+    if (filter != Z_NULL) {
+        U32 filter_buf_len = U32_MAX;
+        err = zsc_filter_get_encoded_len(filter, max_block_len,
+                &filter_buf_len);
+        if (err != Z_OK) {
+            return err;
+        }
+        if (filter_buf_len > work_len - min_work_buf_size) {
+            ZSC_WARN3("In %s, working memory (%u B) "
+                    "has no room for a filter block (%u B).", caller,
+                    work_len, filter_buf_len);
+            return Z_MEM_ERROR;
+        }
+        if (dest_len_in < ZSC_FILTER_HEADER_LEN) {
+            ZSC_WARN2("In %s, output buffer (%u B) "
+                    "has no room for the filter header.", caller, dest_len_in);
+            return Z_BUF_ERROR;
+        }
+        work_len -= filter_buf_len;
+        filter_buf = work + work_len;
+        U8 *header = dest[0].base;
+        header[0] = ZSC_FILTER_ID1;
+        header[1] = ZSC_FILTER_ID2;
+        header[2] = ZSC_FILTER_VERSION;
+        header[3] = (U8)filter->type;
+        zsc_put_u32_le(header + 4, filter->width);
+        zsc_put_u32_le(header + 8, max_block_len);
+        zsc_put_u32_le(header + 12, filter->stride);
+        header_len = ZSC_FILTER_HEADER_LEN;
+    }
+
+    // verification takes the end of the work buffer: inflate, then output
+    z_stream check;
+    U8 *check_out = Z_NULL;
+    if (bad_block != Z_NULL) {
+        *bad_block = U32_MAX;
+        U32 check_work_len = U32_MAX;
+        // deflate raises a zlib window of 8 to 9, and says so in the header
+        I32 check_bits = (window_bits == 8) ? 9 : window_bits;
+        err = inflateWorkSize2(check_bits, &check_work_len);
+        ZSC_ASSERT1(err == Z_OK, err); // checked by the size above
+        work_len -= check_work_len + ZSC_VERIFY_CHUNK;
+        zmemzero((U8*)&check, sizeof(check));
+        check.next_work = work + work_len;
+        check.avail_work = check_work_len;
+        check_out = check.next_work + check_work_len;
+        err = inflateInit2(&check, check_bits);
+        if (err != Z_OK) {
+            ZSC_WARN2("In %s, could not inflateInit for "
+                    "verification, error %d.", caller, err);
+            return err;
+        }
+    }
+
+    z_stream stream;
+    zmemzero((U8*)&stream, sizeof(stream));
+    stream.next_work = work;
+    stream.avail_work = work_len;
+    stream.next_out = Z_NULL;
+    stream.avail_out = 0;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+
     // init the stream
     err = deflateInit2(&stream, level, Z_DEFLATED, window_bits, mem_level,
             strategy);
     if (err != Z_OK) {
-        ZSC_WARN1("In zsc_compress_gzip2, could not deflateInit, error %d.", err);
+        ZSC_WARN2("In %s, could not deflateInit, error %d.", caller, err);
         return err;
     }
 
@@ -99,53 +273,131 @@ ZlibReturn zsc_compress_gzip2(
     if (gz_header != Z_NULL) {
         err = deflateSetHeader(&stream, gz_header);
         if (err != Z_OK) {
-            ZSC_WARN1("In zsc_compress_gzip2(), could not set deflate header, "
-                    "error %d.", err);
+            ZSC_WARN2("In %s, could not set deflate header, "
+                    "error %d.", caller, err);
             return err;
         }
     }
 
+    // preset dictionary, if provided
+    if (dict != Z_NULL) {
+        err = deflateSetDictionary(&stream, dict->data, dict->len);
+        if (err != Z_OK) {
+            ZSC_WARN2("In %s, could not set dictionary, "
+                    "error %d.", caller, err);
+            (void)deflateEnd(&stream); // clean up
+            return err;
+        }
+        ZSC_ASSERT2(stream.adler == dict->id, stream.adler, dict->id);
+    }
+
     // check output buffer size, warn if small (but still might succeed)
     U32 bound1 = deflateBound(&stream, source_len);
     U32 bound2 = U32_MAX;
     err = zsc_compress_get_max_output_size_gzip2(source_len, max_block_len,
             level, window_bits, mem_level, gz_header, &bound2);
     if(err != Z_OK) {
-        ZSC_WARN1("In, zsc_compress_gzip2(), could not get deflate output bound, "
-                "error %d.", err);
+        ZSC_WARN2("In %s, could not get deflate output bound, "
+                "error %d.", caller, err);
         return err;
     }
+    // a dictionary adds its id to the zlib header
+    if (dict != Z_NULL) {
+        bound2 = (bound2 > U32_MAX - 4) ? U32_MAX : bound2 + 4;
+    }
     U32 small_output = (dest_len_in < bound1) || (dest_len_in < bound2);
     // don't warn yet. If there is a failure, and the output was small, then inform
 
-    U32 bytes_left_dest = dest_len_in;
+    U32 source_left = source_len; // bytes of no block yet
+    U32 block_left = 0; // bytes of the current block not yet given to deflate
+    U32 seg_in = 0;     // current source segment
+    U32 seg_in_off = 0; // bytes of current source segment given to deflate
+    U32 seg_out = 0;    // current dest segment
+    U32 seg_out_off = header_len; // bytes of current dest segment used
 
     U32 loops = 0;
     ZSC_ASSERT(max_block_len != 0);
-    U32 loop_limit = dest_len_in / max_block_len + source_len / max_block_len + 10;
+    U32 loop_limit = dest_len_in / max_block_len + dest_cnt
+            + source_len / max_block_len + source_cnt + 10;
+    // set when output ran out, so the last flush may not be complete.
+    // new input then would merge blocks and lose the sync point between them
+    U32 flush_pending = 0;
     while (err == Z_OK && loops < loop_limit) {
         loops++;
         if (stream.avail_out == 0) { // provide more output
-            stream.avail_out = ZMIN(bytes_left_dest, max_block_len);
-            bytes_left_dest -= stream.avail_out;
+            while (seg_out < dest_cnt && seg_out_off == dest[seg_out].len) {
+                seg_out++;
+                seg_out_off = 0;
+            }
+            if (seg_out < dest_cnt) {
+                stream.next_out = dest[seg_out].base + seg_out_off;
+                stream.avail_out = ZMIN(dest[seg_out].len - seg_out_off,
+                        max_block_len);
+                seg_out_off += stream.avail_out;
+            }
         }
-        if (stream.avail_in == 0) { // provide more input
-            stream.avail_in = ZMIN(source_len, max_block_len);
-            source_len -= stream.avail_in;
+        if (stream.avail_in == 0 && block_left == 0
+                && !flush_pending) { // start the next block
+            block_left = ZMIN(source_left, max_block_len);
+            source_left -= block_left;
+            if (filter_buf != Z_NULL) {
+                // filter the whole block, deflate reads it from filter_buf
+                const U8 *block = source[0].base
+                        + (source_len - source_left - block_left);
+                err = zsc_filter_encode(filter, filter_buf, block, block_left);
+                ZSC_ASSERT1(err == Z_OK, err); // filter checked above
+                err = zsc_filter_get_encoded_len(filter, block_left,
+                        &stream.avail_in);
+                ZSC_ASSERT1(err == Z_OK, err); // no larger than a full block
+                stream.next_in = filter_buf;
+                block_left = 0;
+            }
         }
-        ZlibFlush flush = (source_len > 0) ? Z_FULL_FLUSH : Z_FINISH;
+        if (stream.avail_in == 0 && block_left > 0) { // provide more input
+            while (seg_in_off == source[seg_in].len) {
+                seg_in++;
+                seg_in_off = 0;
+                ZSC_ASSERT2(seg_in < source_cnt, seg_in, source_cnt);
+            }
+            stream.next_in = source[seg_in].base + seg_in_off;
+            stream.avail_in = ZMIN(source[seg_in].len - seg_in_off, block_left);
+            seg_in_off += stream.avail_in;
+            block_left -= stream.avail_in;
+        }
+        // only flush once all of the block has been given to deflate
+        ZlibFlush flush = (block_left > 0) ? Z_NO_FLUSH :
+                (source_left > 0) ? Z_FULL_FLUSH : Z_FINISH;
         err = deflate(&stream, flush);
+        flush_pending = (stream.avail_out == 0);
+        if (bad_block != Z_NULL && (err == Z_OK || err == Z_STREAM_END)) {
+            // check what was just produced, while it is still in cache
+            U32 bad_pos = U32_MAX;
+            ZlibReturn check_err = zsc_verify_output(&check, check_out,
+                    dest[0].base, stream.total_out, source[0].base,
+                    source_len, &bad_pos);
+            if (check_err == Z_DATA_ERROR
+                    || (err == Z_STREAM_END && (check_err != Z_STREAM_END
+                    || check.total_out != source_len))) {
+                if (bad_pos == U32_MAX) {
+                    bad_pos = check.total_out;
+                }
+                *bad_block = bad_pos / max_block_len;
+                ZSC_WARN3("In %s, verification failed "
+                        "at byte %u, block %u.", caller, bad_pos, *bad_block);
+                err = Z_DATA_ERROR;
+            }
+        }
     }
     ZSC_ASSERT2(loops < loop_limit, loops, loop_limit);
-    *dest_len = stream.total_out;
+    *dest_len = header_len + stream.total_out;
 
     if(err != Z_STREAM_END) {
-        ZSC_WARN1("In zsc_compress_gzip2(), deflate loop ended "
-                "with error code %d.", err);
+        ZSC_WARN2("In %s, deflate loop ended "
+                "with error code %d.", caller, err);
         if (small_output) {
-            ZSC_WARN3("In zsc_compress_gzip2(), output buffer (%u bytes) "
+            ZSC_WARN4("In %s, output buffer (%u bytes) "
                     "was smaller than bounds (%u/%u bytes). "
-                    "Output may not have fit in the buffer.",
+                    "Output may not have fit in the buffer.", caller,
                     dest_len_in, bound1, bound2);
         }
         (void)deflateEnd(&stream); // clean up
@@ -154,12 +406,221 @@ ZlibReturn zsc_compress_gzip2(
 
     err = deflateEnd(&stream);
     if (err != Z_OK) {
-        ZSC_WARN1("In zsc_compress_gzip2(), deflate ended with error code %d.", err);
+        ZSC_WARN2("In %s, deflate ended with error code %d.", caller, err);
     }
     return err;
 }
 
+// compress single buffers, as one segment each
+ZSC_PRIVATE ZlibReturn zsc_compress_gzip_buf(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header, I32 write_info, U32 *bad_block,
+        const zsc_filter *filter, const zsc_dict *dict, const char *caller)
+{
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+
+    zsc_iovec dest_seg;
+    dest_seg.base = dest;
+    dest_seg.len = *dest_len;
+    zsc_const_iovec source_seg;
+    source_seg.base = source;
+    source_seg.len = source_len;
+    return zsc_compress_gzip_common(&dest_seg, 1, dest_len, &source_seg, 1,
+            max_block_len, work, work_len, level, window_bits, mem_level,
+            strategy, gz_header, write_info, bad_block, filter, dict, caller);
+}
+
+/* ===========================================================================
+     Inflates the compressed bytes in comp[check->total_in..comp_len) into
+   check_out, ZSC_VERIFY_CHUNK bytes at a time, and compares each piece
+   with source at the same offset.
+
+     Returns Z_OK if all was consumed and matched, Z_STREAM_END if the
+   stream ended and matched, or Z_DATA_ERROR on a mismatch or inflate error,
+   with the offset of the first bad byte in *bad_pos (U32_MAX if inflate
+   failed before producing it).
+*/
+ZSC_PRIVATE ZlibReturn zsc_verify_output(z_stream *check, U8 *check_out,
+        const U8 *comp, U32 comp_len, const U8 *source, U32 source_len,
+        U32 *bad_pos)
+{
+    ZSC_ASSERT(check != Z_NULL);
+    ZSC_ASSERT(check_out != Z_NULL);
+    ZSC_ASSERT(comp != Z_NULL);
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(bad_pos != Z_NULL);
+    ZSC_ASSERT2(check->total_in <= comp_len, check->total_in, comp_len);
+
+    check->next_in = comp + check->total_in;
+    check->avail_in = comp_len - check->total_in;
+
+    ZlibReturn err = Z_OK;
+    U32 loops = 0;
+    // each full loop produces a chunk, and output past source_len stops it
+    U32 loop_limit = source_len / ZSC_VERIFY_CHUNK + 3;
+    while (err == Z_OK && loops < loop_limit) {
+        loops++;
+        U32 pos = check->total_out;
+        check->next_out = check_out;
+        check->avail_out = ZSC_VERIFY_CHUNK;
+        err = inflate(check, Z_NO_FLUSH);
+        if (err == Z_BUF_ERROR) {
+            err = Z_OK; // no progress possible, wait for more output
+        }
+        if (err != Z_OK && err != Z_STREAM_END) {
+            ZSC_WARN1("In zsc_verify_output(), inflate failed "
+                    "with error %d.", err);
+            return Z_DATA_ERROR;
+        }
+        U32 have = ZSC_VERIFY_CHUNK - check->avail_out;
+        ZSC_ASSERT2(pos <= source_len, pos, source_len);
+        U32 cmp_len = ZMIN(have, source_len - pos);
+        if (zmemcmp(check_out, source + pos, cmp_len) != 0) {
+            U32 i = 0;
+            while (i < cmp_len && check_out[i] == source[pos + i]) {
+                i++;
+            }
+            *bad_pos = pos + i;
+            return Z_DATA_ERROR;
+        }
+        if (cmp_len != have) {
+            *bad_pos = source_len; // more output than there was input
+            return Z_DATA_ERROR;
+        }
+        if (check->avail_out != 0) {
+            break; // all input consumed
+        }
+    }
+    ZSC_ASSERT2(loops < loop_limit || err != Z_OK, loops, loop_limit);
+    return err;
+}
+
+ZlibReturn zsc_compress_gzip2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header)
+{
+    return zsc_compress_gzip_buf(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, window_bits, mem_level,
+            strategy, gz_header, 0, Z_NULL, Z_NULL, Z_NULL,
+            "zsc_compress_gzip2()");
+}
+
+ZlibReturn zsc_compress_gzip_info2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header)
+{
+    return zsc_compress_gzip_buf(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, window_bits, mem_level,
+            strategy, gz_header, 1, Z_NULL, Z_NULL, Z_NULL,
+            "zsc_compress_gzip_info2()");
+}
+
+ZlibReturn zsc_compress_gzip_info(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        gz_header * gz_header)
+{
+    return zsc_compress_gzip_info2(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, DEF_WBITS + GZIP_CODE,
+            DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, gz_header);
+}
+
+// compress, inflating the output as it is produced to check it
+ZlibReturn zsc_compress_verify2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header, U32 *bad_block)
+{
+    ZSC_ASSERT(bad_block != Z_NULL);
+    return zsc_compress_gzip_buf(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, window_bits, mem_level,
+            strategy, gz_header, 0, bad_block, Z_NULL, Z_NULL,
+            "zsc_compress_verify2()");
+}
+
+ZlibReturn zsc_compress_verify(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        U32 *bad_block)
+{
+    return zsc_compress_verify2(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, DEF_WBITS,
+            DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, Z_NULL, bad_block);
+}
+
+// compress, filtering each block first
+ZlibReturn zsc_compress_filter2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        const zsc_filter *filter)
+{
+    ZSC_ASSERT(filter != Z_NULL);
+    return zsc_compress_gzip_buf(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, window_bits, mem_level,
+            strategy, Z_NULL, 0, Z_NULL, filter, Z_NULL,
+            "zsc_compress_filter2()");
+}
+
+ZlibReturn zsc_compress_filter(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        const zsc_filter *filter)
+{
+    return zsc_compress_filter2(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, DEF_WBITS,
+            DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, filter);
+}
+
 // compress using a work buffer instead of dynamic memory
+ZlibReturn zsc_compress_dict2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        const zsc_dict_registry *reg, U32 dict_id)
+{
+    ZSC_ASSERT(reg != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+
+    // only the zlib wrapper carries a dictionary id
+    if (window_bits < 8 || window_bits > MAX_WBITS) {
+        ZSC_WARN1("In zsc_compress_dict2(), window_bits %d has no zlib "
+                "wrapper for the dictionary id.", window_bits);
+        *dest_len = 0;
+        return Z_STREAM_ERROR;
+    }
+    const zsc_dict *dict = zsc_dict_find(reg, dict_id);
+    if (dict == Z_NULL) {
+        ZSC_WARN1("In zsc_compress_dict2(), no dictionary with id 0x%08x.",
+                dict_id);
+        *dest_len = 0;
+        return Z_STREAM_ERROR;
+    }
+    return zsc_compress_gzip_buf(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, window_bits, mem_level,
+            strategy, Z_NULL, 0, Z_NULL, Z_NULL, dict,
+            "zsc_compress_dict2()");
+}
+
+ZlibReturn zsc_compress_dict(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        const zsc_dict_registry *reg, U32 dict_id)
+{
+    return zsc_compress_dict2(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, DEF_WBITS, DEF_MEM_LEVEL,
+            Z_DEFAULT_STRATEGY, reg, dict_id);
+}
+
 ZlibReturn zsc_compress2(
         U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
         U32 max_block_len, U8 *work, U32 work_len, I32 level,
@@ -189,6 +650,347 @@ ZlibReturn zsc_compress(
             DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
 }
 
+// compress a scatter/gather list of buffers,
+// using a work buffer instead of dynamic memory
+ZlibReturn zsc_compress_iov_gzip2(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        gz_header * gz_header)
+{
+    return zsc_compress_gzip_common(dest, dest_cnt, dest_len,
+            source, source_cnt, max_block_len, work, work_len, level,
+            window_bits, mem_level, strategy, gz_header, 0, Z_NULL, Z_NULL,
+            Z_NULL, "zsc_compress_iov_gzip2()");
+}
+
+ZlibReturn zsc_compress_iov(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level)
+{
+    return zsc_compress_iov_gzip2(dest, dest_cnt, dest_len, source, source_cnt,
+            max_block_len, work, work_len, level, DEF_WBITS,
+            DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, Z_NULL);
+}
+
+// configurations raced by zsc_compress_race() when the caller gives none
+ZSC_PRIVATE const zsc_race_entry zsc_race_default[] = {
+    {6, Z_DEFAULT_STRATEGY},
+    {6, Z_FILTERED},
+    {6, Z_RLE},
+    {6, Z_HUFFMAN_ONLY}
+};
+
+// the race needs three deflate states (base, best so far, trial) and
+// two block outputs (best so far, trial)
+ZSC_PRIVATE ZlibReturn zsc_race_sizes(U32 max_block_len, I32 window_bits,
+        I32 mem_level, U32 *state_len, U32 *scratch_len)
+{
+    ZSC_ASSERT(state_len != Z_NULL);
+    ZSC_ASSERT(scratch_len != Z_NULL);
+
+    ZlibReturn err = deflateWorkSize2(window_bits, mem_level, state_len);
+    if (err != Z_OK) {
+        return err;
+    }
+    // stored blocks give the most conservative bound for any entry
+    err = zsc_compress_get_max_output_size2(max_block_len, max_block_len,
+            Z_NO_COMPRESSION, window_bits, mem_level, scratch_len);
+    if (err != Z_OK) {
+        return err;
+    }
+    if (*state_len > U32_MAX / 5 || *scratch_len > U32_MAX / 5) {
+        ZSC_WARN2("In zsc_compress_race(), work (%u B per state, %u B per "
+                "block) too large.", *state_len, *scratch_len);
+        return Z_STREAM_ERROR;
+    }
+    return Z_OK;
+}
+
+ZlibReturn zsc_compress_race_get_min_work_buf_size(
+        U32 max_block_len, I32 window_bits, I32 mem_level, U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+    *size_out = U32_MAX;
+    if (max_block_len == 0) {
+        return Z_STREAM_ERROR;
+    }
+    U32 state_len = U32_MAX;
+    U32 scratch_len = U32_MAX;
+    ZlibReturn err = zsc_race_sizes(max_block_len, window_bits, mem_level,
+            &state_len, &scratch_len);
+    if (err == Z_OK) {
+        *size_out = 3 * state_len + 2 * scratch_len;
+    }
+    return err;
+}
+
+// compress each block with every entry, from copies of the same state,
+// and keep the smallest
+ZlibReturn zsc_compress_race(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len,
+        I32 window_bits, I32 mem_level,
+        const zsc_race_entry *entries, U32 num_entries)
+{
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+    ZSC_ASSERT(work != Z_NULL);
+    // entries can be null
+
+    U32 dest_len_in = *dest_len;
+    *dest_len = 0; // nothing yet written to output
+
+    if (entries == Z_NULL) {
+        entries = zsc_race_default;
+        num_entries = sizeof(zsc_race_default) / sizeof(zsc_race_default[0]);
+    }
+    U32 i;
+    for (i = 0; i < num_entries; i++) {
+        if (entries[i].level < Z_DEFAULT_COMPRESSION || entries[i].level > 9
+                || entries[i].strategy < Z_DEFAULT_STRATEGY
+                || entries[i].strategy > Z_FIXED) {
+            ZSC_WARN3("In zsc_compress_race(), bad entry %u: level %d, "
+                    "strategy %d.", i, entries[i].level, entries[i].strategy);
+            return Z_STREAM_ERROR;
+        }
+    }
+    if (num_entries == 0 || max_block_len == 0) {
+        ZSC_WARN2("In zsc_compress_race(), bad num_entries (%u) or "
+                "max_block_len (%u).", num_entries, max_block_len);
+        return Z_STREAM_ERROR;
+    }
+
+    // check if work buffer is large enough
+    U32 state_len = U32_MAX;
+    U32 scratch_len = U32_MAX;
+    ZlibReturn err = zsc_race_sizes(max_block_len, window_bits, mem_level,
+            &state_len, &scratch_len);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_compress_race(), could not get work sizes, "
+                "error %d.", err);
+        return err;
+    }
+    if (work_len < 3 * state_len + 2 * scratch_len) {
+        ZSC_WARN2("In zsc_compress_race(), working memory (%u B) "
+                "was smaller than required (%u B).",
+                work_len, 3 * state_len + 2 * scratch_len);
+        return Z_MEM_ERROR;
+    }
+
+    // stream i always owns state slot i; the roles rotate between them
+    z_stream streams[3];
+    zmemzero((U8*)streams, sizeof(streams));
+    z_stream *base = &streams[0];
+    z_stream *best = &streams[1];
+    z_stream *trial = &streams[2];
+    U8 *best_out = work + 3 * state_len;
+    U8 *trial_out = best_out + scratch_len;
+
+    base->next_work = work;
+    base->avail_work = state_len;
+    err = deflateInit2(base, entries[0].level, Z_DEFLATED, window_bits,
+            mem_level, entries[0].strategy);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_compress_race(), could not deflateInit, error %d.",
+                err);
+        return err;
+    }
+
+    U32 out_len = 0;
+    U32 in_pos = 0;
+    ZlibFlush flush = Z_FULL_FLUSH;
+    while (err == Z_OK && flush != Z_FINISH) {
+        U32 chunk = ZMIN(source_len - in_pos, max_block_len);
+        flush = (source_len - in_pos > chunk) ? Z_FULL_FLUSH : Z_FINISH;
+
+        U32 best_len = U32_MAX;
+        for (i = 0; i < num_entries; i++) {
+            trial->next_work = work + (U32)(trial - streams) * state_len;
+            trial->avail_work = state_len;
+            ZlibReturn trial_err = deflateCopyTo(trial, base);
+            if (trial_err == Z_OK) {
+                trial->next_out = trial_out;
+                trial->avail_out = scratch_len;
+                trial_err = deflateParams(trial, entries[i].level,
+                        entries[i].strategy);
+            }
+            if (trial_err == Z_OK) {
+                trial->next_in = source + in_pos;
+                trial->avail_in = chunk;
+                trial_err = deflate(trial, flush);
+                // the block must be complete: all input taken and flushed
+                if (trial_err == Z_OK && (flush == Z_FINISH
+                        || trial->avail_in != 0 || trial->avail_out == 0)) {
+                    trial_err = Z_BUF_ERROR;
+                } else if (trial_err == Z_STREAM_END) {
+                    trial_err = Z_OK;
+                } else {
+                    // error stands
+                }
+            }
+            U32 trial_len = scratch_len - trial->avail_out;
+            if (trial_err == Z_OK && trial_len < best_len) {
+                z_stream *tmp = best;
+                best = trial;
+                trial = tmp;
+                U8 *tmp_out = best_out;
+                best_out = trial_out;
+                trial_out = tmp_out;
+                best_len = trial_len;
+            }
+        }
+
+        if (best_len == U32_MAX) {
+            ZSC_WARN1("In zsc_compress_race(), no entry completed the block "
+                    "at %u.", in_pos);
+            err = Z_BUF_ERROR;
+        } else if (best_len > dest_len_in - out_len) {
+            ZSC_WARN2("In zsc_compress_race(), output buffer (%u B) full "
+                    "at input %u.", dest_len_in, in_pos);
+            err = Z_BUF_ERROR;
+        } else {
+            zmemcpy(dest + out_len, best_out, best_len);
+            out_len += best_len;
+            in_pos += chunk;
+            // continue every entry from the winner
+            z_stream *tmp = base;
+            base = best;
+            best = tmp;
+        }
+    }
+    *dest_len = out_len;
+
+    // the state slots are not freed, but end the streams for symmetry
+    for (i = 0; i < 3; i++) {
+        if (streams[i].state != Z_NULL) {
+            (void)deflateEnd(&streams[i]);
+        }
+    }
+    return err;
+}
+
+// the reference is the window, then the deflate state
+ZlibReturn zsc_compress_frame_get_min_work_buf_size2(I32 window_bits,
+        I32 mem_level, U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    if (window_bits < 9 || window_bits > MAX_WBITS) {
+        ZSC_WARN1("In zsc_compress_frame_get_min_work_buf_size2(), "
+                "bad window_bits %d.", window_bits);
+        return Z_STREAM_ERROR;
+    }
+    U32 deflate_size = U32_MAX;
+    ZlibReturn err = deflateWorkSize2(window_bits, mem_level, &deflate_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    *size_out = (1U << window_bits) + deflate_size;
+    return Z_OK;
+}
+
+ZlibReturn zsc_compress_frame_init(zsc_frame *frame, U8 *work, U32 work_len,
+        I32 level, I32 window_bits, I32 mem_level, ZlibStrategy strategy,
+        U32 keyframe_interval)
+{
+    ZSC_ASSERT(frame != Z_NULL);
+    ZSC_ASSERT(work != Z_NULL);
+
+    zmemzero((U8*)frame, sizeof(*frame));
+    U32 min_work_buf_size = U32_MAX;
+    ZlibReturn err = zsc_compress_frame_get_min_work_buf_size2(window_bits,
+            mem_level, &min_work_buf_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    if (work_len < min_work_buf_size) {
+        ZSC_WARN2("In zsc_compress_frame_init(), working memory (%u B) "
+                "was smaller than required (%u B).",
+                work_len, min_work_buf_size);
+        return Z_MEM_ERROR;
+    }
+    frame->ref = work;
+    frame->ref_len = 0;
+    frame->ref_max = 1U << window_bits;
+    frame->work = work + frame->ref_max;
+    frame->work_len = work_len - frame->ref_max;
+    frame->level = level;
+    frame->window_bits = window_bits;
+    frame->mem_level = mem_level;
+    frame->strategy = strategy;
+    frame->keyframe_interval = keyframe_interval;
+    frame->frames = 0;
+    return Z_OK;
+}
+
+ZlibReturn zsc_compress_frame(zsc_frame *frame,
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len)
+{
+    ZSC_ASSERT(frame != Z_NULL);
+    ZSC_ASSERT(frame->ref != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+    ZSC_ASSERT(source != Z_NULL);
+
+    U32 dest_len_in = *dest_len;
+    *dest_len = 0; // nothing yet written to output
+
+    // a keyframe stands alone, so a receiver that lost the reference
+    // can start again from it
+    if (frame->keyframe_interval != 0
+            && frame->frames >= frame->keyframe_interval) {
+        frame->ref_len = 0;
+    }
+    if (frame->ref_len == 0) {
+        frame->frames = 0;
+    }
+
+    z_stream stream;
+    zmemzero((U8*)&stream, sizeof(stream));
+    stream.next_work = frame->work;
+    stream.avail_work = frame->work_len;
+    stream.next_in = source;
+    stream.avail_in = source_len;
+    stream.next_out = dest;
+    stream.avail_out = dest_len_in;
+
+    ZlibReturn err = deflateInit2(&stream, frame->level, Z_DEFLATED,
+            frame->window_bits, frame->mem_level, frame->strategy);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_compress_frame(), could not deflateInit, "
+                "error %d.", err);
+        frame->ref_len = 0;
+        return err;
+    }
+    if (frame->ref_len > 0) {
+        err = deflateSetDictionary(&stream, frame->ref, frame->ref_len);
+        ZSC_ASSERT1(err == Z_OK, err); // nothing deflated yet
+    }
+
+    // one call, with all of the input and output, finishes the frame
+    err = deflate(&stream, Z_FINISH);
+    *dest_len = stream.total_out;
+    (void)deflateEnd(&stream);
+    if (err != Z_STREAM_END) {
+        ZSC_WARN2("In zsc_compress_frame(), frame did not fit in the "
+                "output buffer (%u B), error %d.", dest_len_in, err);
+        // the receiver won't have this frame to refer to
+        frame->ref_len = 0;
+        return (err == Z_OK) ? Z_BUF_ERROR : err;
+    }
+
+    // the tail of this frame is the reference for the next
+    frame->ref_len = ZMIN(source_len, frame->ref_max);
+    zmemcpy(frame->ref, source + (source_len - frame->ref_len),
+            frame->ref_len);
+    frame->frames++;
+    return Z_OK;
+}
+
 // given window_bits and mem_level,
 // calculate the minimum size of the work buffer required for deflation
 // return as output param
@@ -199,6 +1001,58 @@ ZlibReturn zsc_compress_get_min_work_buf_size2(I32 window_bits,
     return deflateWorkSize2(window_bits, mem_level, size_out);
 }
 
+// given window_bits and mem_level,
+// calculate the minimum size of the work buffer required for
+// deflation with verification: deflate, inflate, and a scratch chunk
+ZlibReturn zsc_compress_verify_get_min_work_buf_size2(I32 window_bits,
+        I32 mem_level, U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    U32 deflate_size = U32_MAX;
+    ZlibReturn err = deflateWorkSize2(window_bits, mem_level, &deflate_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    U32 inflate_size = U32_MAX;
+    err = inflateWorkSize2((window_bits == 8) ? 9 : window_bits,
+            &inflate_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    *size_out = deflate_size + inflate_size + ZSC_VERIFY_CHUNK;
+    return Z_OK;
+}
+
+// given max_block_len, window_bits, mem_level and filter,
+// calculate the minimum size of the work buffer required for
+// deflation with a filter: deflate, and a block of filtered input
+ZlibReturn zsc_compress_filter_get_min_work_buf_size2(U32 max_block_len,
+        I32 window_bits, I32 mem_level, const zsc_filter *filter,
+        U32 *size_out)
+{
+    ZSC_ASSERT(filter != Z_NULL);
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    U32 deflate_size = U32_MAX;
+    ZlibReturn err = deflateWorkSize2(window_bits, mem_level, &deflate_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    U32 filter_size = U32_MAX;
+    err = zsc_filter_get_encoded_len(filter, max_block_len, &filter_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    if (max_block_len == 0 || filter_size > U32_MAX - deflate_size) {
+        ZSC_WARN1("In zsc_compress_filter_get_min_work_buf_size2(), "
+                "bad max_block_len %u.", max_block_len);
+        return Z_STREAM_ERROR;
+    }
+    *size_out = deflate_size + filter_size;
+    return Z_OK;
+}
+
 ZlibReturn zsc_compress_get_min_work_buf_size(U32* size_out)
 {
     return deflateWorkSize(size_out);
@@ -258,3 +1112,16 @@ ZlibReturn zsc_compress_get_max_output_size(
             level, DEF_WBITS, DEF_MEM_LEVEL, size_out);
 }
 
+// write the info as a gzip extra subfield, ZSC_INFO_SUBFIELD_LEN bytes
+ZSC_PRIVATE void zsc_put_info(U8 *buf, const zsc_info *info)
+{
+    ZSC_ASSERT(buf != Z_NULL);
+    ZSC_ASSERT(info != Z_NULL);
+    buf[0] = ZSC_INFO_SI1;
+    buf[1] = ZSC_INFO_SI2;
+    buf[2] = (U8)(ZSC_INFO_DATA_LEN & 0xff);
+    buf[3] = (U8)((ZSC_INFO_DATA_LEN >> 8) & 0xff);
+    zsc_put_u32_le(buf + 4, info->source_len);
+    zsc_put_u32_le(buf + 8, info->num_blocks);
+    zsc_put_u32_le(buf + 12, info->max_block_len);
+}
@@ -0,0 +1,567 @@
+/***********************************************************************
+ * Copyright 2020, by the California Institute of Technology.
+ * ALL RIGHTS RESERVED. United States Government Sponsorship acknowledged.
+ * Any commercial use must be negotiated with the Office of Technology
+ * Transfer at the California Institute of Technology.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file        zsc_dedup.c
+ * @date        2020-07-01
+ * @author      Neil Abcouwer
+ * @brief       Function definitions for deduplicated compression.
+ *
+ * Content-defined chunking finds regions that repeat further back than
+ * the deflate window. Each repeat is stored once, and later copies become
+ * references in a chunk table ahead of the deflate stream.
+ */
+
+#include "zsc/zsc_pub.h"
+#include "zsc/zutil.h"
+#include "zsc/zsc_conf_private.h"
+
+// top log2(ZSC_DEDUP_AVG_CHUNK) bits of the gear hash, zero at a cut
+#define ZSC_DEDUP_CUT_MASK 0xFFF80000U
+// bytes of history in the gear hash, one per bit
+#define ZSC_DEDUP_GEAR_SPAN 32U
+// U32 words per hash table slot: fingerprint, offset, length
+#define ZSC_DEDUP_SLOT_WORDS 3U
+
+ZSC_PRIVATE U32 zsc_dedup_cut(const U8 *buf, U32 len);
+ZSC_PRIVATE U32 zsc_dedup_slots(U32 source_len);
+ZSC_PRIVATE U32 zsc_dedup_find(U32 *table, U32 slots, const U8 *source,
+        U32 off, U32 len);
+
+// random values mixed into the rolling hash, one per byte value
+ZSC_PRIVATE const U32 zsc_dedup_gear[256] = {
+    0x6b6d0b87U, 0xa5dcf00bU, 0x7995c892U, 0x54b6cf81U,
+    0xf176ce23U, 0x257a9709U, 0x5b7f053dU, 0xe89646ebU,
+    0xb6733fa5U, 0x666cd335U, 0x00bc779cU, 0x456eacbdU,
+    0x2007eb77U, 0xf908ceebU, 0x2a75c377U, 0xec1ab971U,
+    0x78a07b3fU, 0x05427d1bU, 0x8837ae50U, 0x40f3893fU,
+    0xfae0f35fU, 0x9c7c0968U, 0xf01d7d04U, 0xc75a19edU,
+    0x34f15c29U, 0x1a873b72U, 0x8dc3e040U, 0xd8875912U,
+    0x49154618U, 0xa8bd776cU, 0xa28c6dfcU, 0xdbc3f3ecU,
+    0x0e7418caU, 0x121c0557U, 0xd30f821cU, 0x0ce806d3U,
+    0x5ca2ad4fU, 0xf69e8582U, 0xad3a689fU, 0xdb963602U,
+    0xd58c181dU, 0xcaff9b91U, 0x57612a94U, 0xee67d6a3U,
+    0xc5635d69U, 0x55888b90U, 0x0406a159U, 0x26e2f042U,
+    0x395601f8U, 0xd256b79bU, 0xe47d2b65U, 0x2b7ee744U,
+    0x36a75dabU, 0x4012dd94U, 0xe9d500c2U, 0x6f815cf2U,
+    0x38cdbecaU, 0x235426eeU, 0x6738c546U, 0xeac64393U,
+    0x446f4116U, 0xe64e180dU, 0xc9481999U, 0xeaecd439U,
+    0xa9e91a74U, 0x79b29780U, 0x41049e09U, 0x574291dfU,
+    0xd65c27eaU, 0xfb214555U, 0x265a7f2aU, 0xa575bf31U,
+    0xe8b99f09U, 0x22132351U, 0x004e35e7U, 0x900f24dcU,
+    0x889f0b90U, 0x5f24faa8U, 0x6ef73c82U, 0x778d38a2U,
+    0x88fbe05fU, 0xdc4de995U, 0x29dd067bU, 0x2ea3b79bU,
+    0xaf1f11cfU, 0xc2bdb689U, 0x65ae5652U, 0x1edb9942U,
+    0xcd89de9dU, 0xc83c0920U, 0x6f483ab0U, 0x45a32a9dU,
+    0xf2f60191U, 0x7d46fe5eU, 0x6aea7710U, 0x3a0c271fU,
+    0xc31b1868U, 0x0cfdcec4U, 0xc4bf85feU, 0x6bc5375aU,
+    0x8ecd470fU, 0xbf98e24bU, 0xa5d93964U, 0x5bf62b4aU,
+    0xea65a8d1U, 0x64520610U, 0x1e309ed6U, 0x101a7e8cU,
+    0xacd66ee5U, 0xcc4b9381U, 0x2f47401aU, 0x97c383deU,
+    0x582068e5U, 0xc972b9ffU, 0x40ba28f5U, 0x30ffd822U,
+    0x6ba1a85eU, 0xa17aaba5U, 0xba15d80bU, 0xebdee408U,
+    0x58c63ee3U, 0x59aefd4bU, 0x513c9b2aU, 0x4443ca1eU,
+    0xffdc0964U, 0x3ddd460dU, 0x6ccbfb70U, 0xd20dadcfU,
+    0xb5e0f259U, 0xdbbb1cb8U, 0xfd087550U, 0x1323777fU,
+    0x771bc4f9U, 0xd4da8990U, 0x87054dd0U, 0x3d03920aU,
+    0x03017bbcU, 0xe22ffa86U, 0x5b233b28U, 0x9c7dd09fU,
+    0x51af5db5U, 0x6465c436U, 0x405131f1U, 0x805b88c4U,
+    0x2f7edc0eU, 0x6ed2906bU, 0xa33a5087U, 0xdd81132eU,
+    0xc781cb95U, 0xe5b64705U, 0x2d643cb9U, 0x17b33e1aU,
+    0x3d11da5fU, 0xe59da9e8U, 0x88ac39f6U, 0x8a7b47eeU,
+    0xf150bf9dU, 0x083dad99U, 0x025c3695U, 0xfaee02faU,
+    0x25cb71b3U, 0x5b626bc5U, 0x274b552dU, 0x5ab9048bU,
+    0xb916042eU, 0x5a994198U, 0xd175f5d4U, 0xaa71095eU,
+    0x5a97ed11U, 0xf40818c7U, 0xab667cceU, 0x83b8dd74U,
+    0xc3430f3fU, 0x4dbeb67eU, 0xb580ec8bU, 0xd0f07b5cU,
+    0x6f13a28cU, 0x1c2717d4U, 0xda4f8ad0U, 0x89987d2aU,
+    0x526a3508U, 0x3b0c734bU, 0xca6816cbU, 0x7b59e84eU,
+    0xd3445d88U, 0xc6a48fbdU, 0x78b1d90eU, 0x4aee17eeU,
+    0xdcad2ffcU, 0x9e7cf617U, 0x61e5530dU, 0xa38e3dd6U,
+    0x7de77639U, 0x0d48030bU, 0xcc9d7daaU, 0xef38acf0U,
+    0xd72d623dU, 0xd94a61ccU, 0x7e2b4034U, 0x044354d7U,
+    0x837787dbU, 0x3f83ec0aU, 0xfffab50eU, 0x7783daecU,
+    0x31620b38U, 0x341641f9U, 0x40d211afU, 0xc04940aaU,
+    0x6c43c1cdU, 0x771d119cU, 0x9720fd1dU, 0x0461b4d2U,
+    0x0cf5e7c8U, 0x489989e6U, 0xd1bf1f99U, 0x7b532730U,
+    0x549a22f9U, 0xdf8ad5dfU, 0xca3984aeU, 0x138f13cfU,
+    0x936bf15bU, 0x93105191U, 0xb7e96763U, 0x3eda8b80U,
+    0x67578b30U, 0xa0bf2f53U, 0xcd97e3a1U, 0x7eedfd18U,
+    0x0c987024U, 0x6c07058fU, 0x80d59b89U, 0x95caff68U,
+    0x7e90a1abU, 0x4dde757eU, 0xc3d3edd2U, 0xcc54fca4U,
+    0x37ce17a5U, 0xfcbeb82cU, 0x7340f8d6U, 0xa4e45e71U,
+    0xa77e366dU, 0xf19f129cU, 0x95b492c0U, 0x12917127U,
+    0x41ee1045U, 0x5e2ce91eU, 0x27068d88U, 0xfe67451aU,
+    0x6de74a60U, 0xc5c2ed1dU, 0x984fa23dU, 0xf423a62bU,
+    0x50a0b617U, 0xbcd48b2bU, 0x02739f28U, 0x1948175fU
+};
+
+/* ===========================================================================
+     Returns the length of the chunk at the start of buf. The gear hash only
+   remembers the last ZSC_DEDUP_GEAR_SPAN bytes, so the cut points depend on
+   the content around them, not on where the chunk started.
+*/
+ZSC_PRIVATE U32 zsc_dedup_cut(const U8 *buf, U32 len)
+{
+    ZSC_ASSERT(buf != Z_NULL);
+
+    if (len <= ZSC_DEDUP_MIN_CHUNK) {
+        return len;
+    }
+    U32 end = ZMIN(len, ZSC_DEDUP_MAX_CHUNK);
+    U32 hash = 0;
+    U32 i;
+    // no cut is allowed before the minimum, so only the bytes that
+    // are still in the hash there need to be fed in
+    for (i = ZSC_DEDUP_MIN_CHUNK - ZSC_DEDUP_GEAR_SPAN;
+            i < ZSC_DEDUP_MIN_CHUNK; i++) {
+        hash = (hash << 1) + zsc_dedup_gear[buf[i]];
+    }
+    for (; i < end; i++) {
+        hash = (hash << 1) + zsc_dedup_gear[buf[i]];
+        if ((hash & ZSC_DEDUP_CUT_MASK) == 0) {
+            return i + 1;
+        }
+    }
+    return end;
+}
+
+// hash table slots for a source: a power of two, at least twice the
+// most chunks it can have
+ZSC_PRIVATE U32 zsc_dedup_slots(U32 source_len)
+{
+    U32 max_chunks = source_len / ZSC_DEDUP_MIN_CHUNK + 1;
+    U32 slots = 2;
+    while (slots < 2 * max_chunks) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+/* ===========================================================================
+     Looks up the chunk source[off..off+len) in the table. Returns the offset
+   of an earlier equal chunk, or adds this one and returns off.
+   Fingerprints only pick the candidates, the bytes are always compared.
+*/
+ZSC_PRIVATE U32 zsc_dedup_find(U32 *table, U32 slots, const U8 *source,
+        U32 off, U32 len)
+{
+    ZSC_ASSERT(table != Z_NULL);
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(len != 0);
+
+    U32 fingerprint = crc32(0, source + off, len);
+    U32 slot = fingerprint & (slots - 1);
+    U32 probes;
+    for (probes = 0; probes < slots; probes++) {
+        U32 *entry = table + ZSC_DEDUP_SLOT_WORDS * slot;
+        if (entry[2] == 0) {
+            entry[0] = fingerprint;
+            entry[1] = off;
+            entry[2] = len;
+            return off;
+        }
+        if (entry[0] == fingerprint && entry[2] == len
+                && zmemcmp(source + entry[1], source + off, len) == 0) {
+            return entry[1];
+        }
+        slot = (slot + 1) & (slots - 1);
+    }
+    // table is never more than half full
+    ZSC_ASSERT1(probes < slots, probes);
+    return off;
+}
+
+ZlibReturn zsc_compress_dedup_get_min_work_buf_size2(U32 source_len,
+        I32 window_bits, I32 mem_level, U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    U32 deflate_size = U32_MAX;
+    ZlibReturn err = zsc_compress_get_min_work_buf_size2(window_bits,
+            mem_level, &deflate_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    // at most 2^23 slots of 12 bytes, no overflow
+    U32 table_size = zsc_dedup_slots(source_len)
+            * ZSC_DEDUP_SLOT_WORDS * (U32)sizeof(U32);
+    if (table_size > U32_MAX - deflate_size) {
+        ZSC_WARN1("In zsc_compress_dedup_get_min_work_buf_size2(), "
+                "source_len %u too long.", source_len);
+        return Z_STREAM_ERROR;
+    }
+    *size_out = table_size + deflate_size;
+    return Z_OK;
+}
+
+ZlibReturn zsc_compress_dedup_get_max_output_size2(U32 source_len,
+        U32 max_block_len, I32 level, I32 window_bits, I32 mem_level,
+        U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    U32 deflate_bound = U32_MAX;
+    ZlibReturn err = zsc_compress_get_max_output_size_gzip2(source_len,
+            max_block_len, level, window_bits, mem_level, Z_NULL,
+            &deflate_bound);
+    if (err != Z_OK) {
+        return err;
+    }
+    U32 table_len = (source_len / ZSC_DEDUP_MIN_CHUNK + 1)
+            * ZSC_DEDUP_ENTRY_LEN + ZSC_DEDUP_HEADER_LEN;
+    if (table_len > U32_MAX - deflate_bound) {
+        ZSC_WARN1("In zsc_compress_dedup_get_max_output_size2(), "
+                "source_len %u too long.", source_len);
+        return Z_STREAM_ERROR;
+    }
+    *size_out = table_len + deflate_bound;
+    return Z_OK;
+}
+
+ZlibReturn zsc_compress_dedup2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level,
+        I32 window_bits, I32 mem_level, ZlibStrategy strategy)
+{
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+    ZSC_ASSERT(work != Z_NULL);
+    ZSC_ASSERT(max_block_len != 0);
+
+    U32 dest_len_in = *dest_len;
+    *dest_len = 0; // nothing yet written to output
+
+    // check if work buffer is large enough: hash table, then deflate state
+    U32 min_work_buf_size = U32_MAX;
+    ZlibReturn err = zsc_compress_dedup_get_min_work_buf_size2(source_len,
+            window_bits, mem_level, &min_work_buf_size);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_compress_dedup2(), could not get min work buf "
+                "size, error %d.", err);
+        return err;
+    }
+    if (work_len < min_work_buf_size) {
+        ZSC_WARN2("In zsc_compress_dedup2(), working memory (%u B) "
+                "was smaller than required (%u B).",
+                work_len, min_work_buf_size);
+        return Z_MEM_ERROR;
+    }
+    if (dest_len_in < ZSC_DEDUP_HEADER_LEN) {
+        ZSC_WARN1("In zsc_compress_dedup2(), output buffer (%u B) "
+                "has no room for the header.", dest_len_in);
+        return Z_BUF_ERROR;
+    }
+    U32 slots = zsc_dedup_slots(source_len);
+    U32 table_size = slots * ZSC_DEDUP_SLOT_WORDS * (U32)sizeof(U32);
+    U32 *table = (U32 *)work;
+    zmemzero(work, table_size);
+
+    // chunk the source, writing an entry per chunk
+    U32 out_len = ZSC_DEDUP_HEADER_LEN;
+    U32 num_chunks = 0;
+    U32 stored_len = 0;
+    U32 off = 0;
+    while (off < source_len) {
+        U32 len = zsc_dedup_cut(source + off, source_len - off);
+        ZSC_ASSERT2(len != 0 && len <= source_len - off, len, off);
+        if (dest_len_in - out_len < ZSC_DEDUP_ENTRY_LEN) {
+            ZSC_WARN2("In zsc_compress_dedup2(), output buffer (%u B) "
+                    "has no room for chunk %u.", dest_len_in, num_chunks);
+            return Z_BUF_ERROR;
+        }
+        U32 ref = zsc_dedup_find(table, slots, source, off, len);
+        zsc_put_u32_le(dest + out_len, len);
+        zsc_put_u32_le(dest + out_len + 4, ref);
+        out_len += ZSC_DEDUP_ENTRY_LEN;
+        num_chunks++;
+        if (ref == off) {
+            stored_len += len;
+        }
+        off += len;
+    }
+    dest[0] = ZSC_DEDUP_ID1;
+    dest[1] = ZSC_DEDUP_ID2;
+    dest[2] = ZSC_DEDUP_VERSION;
+    dest[3] = 0;
+    zsc_put_u32_le(dest + 4, source_len);
+    zsc_put_u32_le(dest + 8, num_chunks);
+    zsc_put_u32_le(dest + 12, stored_len);
+    zsc_put_u32_le(dest + 16, max_block_len);
+    const U8 *entries = dest + ZSC_DEDUP_HEADER_LEN;
+
+    z_stream stream;
+    zmemzero((U8*)&stream, sizeof(stream));
+    stream.next_work = work + table_size;
+    stream.avail_work = work_len - table_size;
+    stream.next_out = dest + out_len;
+    stream.avail_out = 0;
+    stream.next_in = source;
+    stream.avail_in = 0;
+
+    err = deflateInit2(&stream, level, Z_DEFLATED, window_bits, mem_level,
+            strategy);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_compress_dedup2(), could not deflateInit, "
+                "error %d.", err);
+        return err;
+    }
+
+    // deflate the stored chunks as one input, a block per max_block_len
+    U32 bytes_left_dest = dest_len_in - out_len;
+    U32 stored_left = stored_len; // stored bytes not yet in a block
+    U32 block_left = 0; // bytes of the current block not yet given to deflate
+    U32 chunk = 0;      // current table entry
+    U32 chunk_off = 0;  // source offset of the current entry
+    U32 chunk_used = 0; // bytes of the current entry given to deflate
+    U32 loops = 0;
+    U32 loop_limit = dest_len_in / max_block_len
+            + stored_len / max_block_len + num_chunks + 10;
+    U32 flush_pending = 0; // output ran out, finish the flush before the next block
+    while (err == Z_OK && loops < loop_limit) {
+        loops++;
+        if (stream.avail_out == 0) { // provide more output
+            stream.avail_out = ZMIN(bytes_left_dest, max_block_len);
+            bytes_left_dest -= stream.avail_out;
+        }
+        if (stream.avail_in == 0 && block_left == 0
+                && !flush_pending) { // start the next block
+            block_left = ZMIN(stored_left, max_block_len);
+            stored_left -= block_left;
+        }
+        if (stream.avail_in == 0 && block_left > 0) { // provide more input
+            // skip used up entries and references
+            U32 len = zsc_get_u32_le(entries + chunk * ZSC_DEDUP_ENTRY_LEN);
+            while (chunk_used == len || chunk_off != zsc_get_u32_le(
+                    entries + chunk * ZSC_DEDUP_ENTRY_LEN + 4)) {
+                chunk_off += len;
+                chunk++;
+                chunk_used = 0;
+                ZSC_ASSERT2(chunk < num_chunks, chunk, num_chunks);
+                len = zsc_get_u32_le(entries + chunk * ZSC_DEDUP_ENTRY_LEN);
+            }
+            stream.next_in = source + chunk_off + chunk_used;
+            stream.avail_in = ZMIN(len - chunk_used, block_left);
+            chunk_used += stream.avail_in;
+            block_left -= stream.avail_in;
+        }
+        // only flush once all of the block has been given to deflate
+        ZlibFlush flush = (block_left > 0) ? Z_NO_FLUSH :
+                (stored_left > 0) ? Z_FULL_FLUSH : Z_FINISH;
+        err = deflate(&stream, flush);
+        flush_pending = (stream.avail_out == 0);
+    }
+    ZSC_ASSERT2(loops < loop_limit, loops, loop_limit);
+    *dest_len = out_len + stream.total_out;
+
+    if (err != Z_STREAM_END) {
+        ZSC_WARN2("In zsc_compress_dedup2(), deflate loop ended "
+                "with error code %d, output buffer %u B.", err, dest_len_in);
+        (void)deflateEnd(&stream); // clean up
+        return (err == Z_OK) ? Z_STREAM_ERROR : err;
+    }
+
+    err = deflateEnd(&stream);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_compress_dedup2(), deflate ended with error "
+                "code %d.", err);
+    }
+    return err;
+}
+
+ZlibReturn zsc_compress_dedup(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 source_len,
+        U32 max_block_len, U8 *work, U32 work_len, I32 level)
+{
+    return zsc_compress_dedup2(dest, dest_len, source, source_len,
+            max_block_len, work, work_len, level, DEF_WBITS, DEF_MEM_LEVEL,
+            Z_DEFAULT_STRATEGY);
+}
+
+ZlibReturn zsc_uncompress_dedup2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits)
+{
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+    ZSC_ASSERT(source_len != Z_NULL);
+    ZSC_ASSERT(work != Z_NULL);
+
+    U32 dest_len_in = *dest_len;
+    U32 source_len_in = *source_len;
+    *dest_len = 0;
+    *source_len = 0;
+
+    if (source_len_in < ZSC_DEDUP_HEADER_LEN
+            || source[0] != ZSC_DEDUP_ID1 || source[1] != ZSC_DEDUP_ID2
+            || source[2] != ZSC_DEDUP_VERSION) {
+        ZSC_WARN("In zsc_uncompress_dedup2(), missing or unknown header.");
+        return Z_DATA_ERROR;
+    }
+    U32 orig_len = zsc_get_u32_le(source + 4);
+    U32 num_chunks = zsc_get_u32_le(source + 8);
+    U32 stored_len = zsc_get_u32_le(source + 12);
+    U32 block_len = zsc_get_u32_le(source + 16);
+    if (num_chunks > (source_len_in - ZSC_DEDUP_HEADER_LEN)
+            / ZSC_DEDUP_ENTRY_LEN || stored_len > orig_len
+            || block_len == 0) {
+        ZSC_WARN2("In zsc_uncompress_dedup2(), bad header, %u chunks "
+                "in %u B.", num_chunks, source_len_in);
+        return Z_DATA_ERROR;
+    }
+    if (orig_len > dest_len_in) {
+        ZSC_WARN2("In zsc_uncompress_dedup2(), output buffer (%u B) "
+                "too small for output (%u B).", dest_len_in, orig_len);
+        return Z_BUF_ERROR;
+    }
+    const U8 *entries = source + ZSC_DEDUP_HEADER_LEN;
+    U32 table_end = ZSC_DEDUP_HEADER_LEN + num_chunks * ZSC_DEDUP_ENTRY_LEN;
+
+    // check if work buffer is large enough
+    U32 min_work_buf_size = U32_MAX;
+    ZlibReturn err = zsc_uncompress_get_min_work_buf_size2(window_bits,
+            &min_work_buf_size);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_dedup2(), could not get min work buf "
+                "size, error %d.", err);
+        return err;
+    }
+    if (work_len < min_work_buf_size) {
+        ZSC_WARN2("In zsc_uncompress_dedup2(), work buffer (%u B) is "
+                "smaller than required (%u B).", work_len, min_work_buf_size);
+        return Z_MEM_ERROR;
+    }
+
+    z_stream stream;
+    zmemzero((U8*)&stream, sizeof(stream));
+    stream.next_work = work;
+    stream.avail_work = work_len;
+    stream.next_in = source + table_end;
+    stream.avail_in = source_len_in - table_end;
+    stream.next_out = dest;
+    stream.avail_out = 0;
+
+    err = inflateInit2(&stream, window_bits);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_dedup2(), could not inflateInit, "
+                "error %d.", err);
+        return err;
+    }
+
+    // each chunk is inflated into place, or copied from where it was
+    U32 off = 0;
+    U32 stored = 0; // bytes of stored chunks placed, inflated or lost
+    U32 lost = 0;   // bytes to zero until the block inflation resumes at
+    I32 data_errors = 0;
+    U32 chunk;
+    for (chunk = 0; chunk < num_chunks
+            && (err == Z_OK || err == Z_STREAM_END); chunk++) {
+        U32 len = zsc_get_u32_le(entries + chunk * ZSC_DEDUP_ENTRY_LEN);
+        U32 ref = zsc_get_u32_le(entries + chunk * ZSC_DEDUP_ENTRY_LEN + 4);
+        if (len == 0 || len > orig_len - off
+                || (ref != off && (ref > off || len > off - ref))) {
+            ZSC_WARN3("In zsc_uncompress_dedup2(), bad chunk %u, "
+                    "length %u, offset %u.", chunk, len, ref);
+            err = Z_DATA_ERROR;
+        } else if (ref != off) {
+            zmemcpy(dest + off, dest + ref, len);
+            off += len;
+        } else if (err == Z_STREAM_END || len > stored_len - stored) {
+            ZSC_WARN1("In zsc_uncompress_dedup2(), stream too short "
+                    "for chunk %u.", chunk);
+            err = Z_DATA_ERROR;
+        } else {
+            U32 end = off + len;
+            while (err == Z_OK && off < end) {
+                U32 n;
+                if (lost > 0) {
+                    n = ZMIN(lost, end - off);
+                    zmemzero(dest + off, n);
+                    lost -= n;
+                } else {
+                    // all input is available, so one call fills the chunk
+                    // unless the stream is short or corrupt
+                    stream.next_out = dest + off;
+                    stream.avail_out = end - off;
+                    err = inflate(&stream, Z_NO_FLUSH);
+                    n = (end - off) - stream.avail_out;
+                    if ((err == Z_OK || err == Z_STREAM_END)
+                            && stream.avail_out != 0) {
+                        err = Z_DATA_ERROR;
+                    }
+                }
+                off += n;
+                stored += n;
+                if (err == Z_DATA_ERROR && stored < stored_len) {
+                    // there was probably some corruption in the stream.
+                    // Find the next full flush, and zero what is left of
+                    // the block before it
+                    data_errors++;
+                    err = inflateSync(&stream);
+                    if (err == Z_OK) {
+                        lost = ZMIN(block_len - stored % block_len,
+                                stored_len - stored);
+                        ZSC_WARN2("In zsc_uncompress_dedup2(), data error "
+                                "in inflate stream, instance %d, resuming "
+                                "after %u lost bytes.", data_errors, lost);
+                    } else {
+                        ZSC_WARN2("In zsc_uncompress_dedup2(), data error "
+                                "in inflate stream, instance %d, "
+                                "inflateSync() returned %d.",
+                                data_errors, err);
+                    }
+                }
+            }
+        }
+    }
+    if (err == Z_OK) {
+        // the end of the stream takes no output
+        stream.next_out = dest + off;
+        stream.avail_out = 0;
+        err = inflate(&stream, Z_FINISH);
+    }
+    if (err == Z_STREAM_END && (off != orig_len || stored != stored_len)) {
+        ZSC_WARN2("In zsc_uncompress_dedup2(), output %u B, header "
+                "says %u B.", off, orig_len);
+        err = Z_DATA_ERROR;
+    }
+    // if we got a data error, overwrite any later success
+    if (err == Z_STREAM_END && data_errors > 0) {
+        err = Z_DATA_ERROR;
+    }
+    *dest_len = off;
+    *source_len = table_end + stream.total_in;
+    (void)inflateEnd(&stream);
+
+    if (err != Z_STREAM_END) {
+        ZSC_WARN1("In zsc_uncompress_dedup2(), inflate ended with error %d.",
+                err);
+        return (err == Z_NEED_DICT || err == Z_BUF_ERROR || err == Z_OK)
+                ? Z_DATA_ERROR : err;
+    }
+    return Z_OK;
+}
+
+ZlibReturn zsc_uncompress_dedup(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len)
+{
+    return zsc_uncompress_dedup2(dest, dest_len, source, source_len,
+            work, work_len, DEF_WBITS);
+}
@@ -0,0 +1,124 @@
+/***********************************************************************
+ * Copyright 2020, by the California Institute of Technology.
+ * ALL RIGHTS RESERVED. United States Government Sponsorship acknowledged.
+ * Any commercial use must be negotiated with the Office of Technology
+ * Transfer at the California Institute of Technology.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file        zsc_dict.c
+ * @date        2020-07-01
+ * @author      Neil Abcouwer
+ * @brief       Function definitions for the preset dictionary registry.
+ *
+ * Dictionaries are hashed once, when registered, and found again by the
+ * DICTID a zlib header carries, so that neither side routes them by hand.
+ */
+
+#include "zsc/zsc_pub.h"
+#include "zsc/zutil.h"
+#include "zsc/zsc_conf_private.h"
+
+ZSC_PRIVATE U32 zsc_dict_slot(U32 id);
+
+// first slot to probe for an id
+ZSC_PRIVATE U32 zsc_dict_slot(U32 id)
+{
+    // adler32 keeps its sum of sums in the high half, so fold it in
+    return (id ^ (id >> 16)) & (ZSC_DICT_SLOTS - 1);
+}
+
+ZlibReturn zsc_dict_registry_init(zsc_dict_registry *reg)
+{
+    ZSC_ASSERT(reg != Z_NULL);
+
+    zmemzero((U8*)reg, sizeof(*reg));
+    return Z_OK;
+}
+
+ZlibReturn zsc_dict_register(zsc_dict_registry *reg,
+        const U8 *data, U32 len, U32 *id_out)
+{
+    ZSC_ASSERT(reg != Z_NULL);
+    ZSC_ASSERT(data != Z_NULL);
+    ZSC_ASSERT(id_out != Z_NULL);
+    ZSC_ASSERT1(reg->num_dicts <= ZSC_DICT_MAX, reg->num_dicts);
+
+    if (len == 0) {
+        ZSC_WARN("In zsc_dict_register(), empty dictionary.");
+        return Z_STREAM_ERROR;
+    }
+    // no window reaches further back than the last ZSC_DICT_MAX_LEN bytes
+    if (len > ZSC_DICT_MAX_LEN) {
+        data += len - ZSC_DICT_MAX_LEN;
+        len = ZSC_DICT_MAX_LEN;
+    }
+    // the id deflateSetDictionary() will put in the zlib header
+    U32 id = adler32(adler32(0, Z_NULL, 0), data, len);
+
+    U32 slot = zsc_dict_slot(id);
+    U32 probes;
+    for (probes = 0; probes < ZSC_DICT_SLOTS; probes++) {
+        U32 index = reg->slots[slot];
+        if (index == 0) {
+            break;
+        }
+        const zsc_dict *dict = &reg->dicts[index - 1];
+        if (dict->id == id) {
+            if (dict->len != len || zmemcmp(dict->data, data, len) != 0) {
+                ZSC_WARN1("In zsc_dict_register(), a different dictionary "
+                        "has id 0x%08x.", id);
+                return Z_STREAM_ERROR;
+            }
+            *id_out = id;
+            return Z_OK;
+        }
+        slot = (slot + 1) & (ZSC_DICT_SLOTS - 1);
+    }
+    if (reg->num_dicts == ZSC_DICT_MAX) {
+        ZSC_WARN1("In zsc_dict_register(), registry full, %u dictionaries.",
+                reg->num_dicts);
+        return Z_STREAM_ERROR;
+    }
+    // never more than half full, so an empty slot was found
+    ZSC_ASSERT1(probes < ZSC_DICT_SLOTS, probes);
+
+    zsc_dict *dict = &reg->dicts[reg->num_dicts];
+    dict->data = data;
+    dict->len = len;
+    dict->id = id;
+    reg->num_dicts++;
+    reg->slots[slot] = (U8)reg->num_dicts;
+    *id_out = id;
+    return Z_OK;
+}
+
+const zsc_dict *zsc_dict_find(const zsc_dict_registry *reg, U32 id)
+{
+    ZSC_ASSERT(reg != Z_NULL);
+
+    U32 slot = zsc_dict_slot(id);
+    U32 probes;
+    for (probes = 0; probes < ZSC_DICT_SLOTS; probes++) {
+        U32 index = reg->slots[slot];
+        if (index == 0) {
+            return Z_NULL;
+        }
+        ZSC_ASSERT2(index <= reg->num_dicts, index, reg->num_dicts);
+        if (reg->dicts[index - 1].id == id) {
+            return &reg->dicts[index - 1];
+        }
+        slot = (slot + 1) & (ZSC_DICT_SLOTS - 1);
+    }
+    return Z_NULL;
+}
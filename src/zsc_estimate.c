@@ -0,0 +1,330 @@
+/***********************************************************************
+ * Copyright 2020, by the California Institute of Technology.
+ * ALL RIGHTS RESERVED. United States Government Sponsorship acknowledged.
+ * Any commercial use must be negotiated with the Office of Technology
+ * Transfer at the California Institute of Technology.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file        zsc_estimate.c
+ * @date        2020-07-01
+ * @author      Neil Abcouwer
+ * @brief       Function definitions for estimating compressed size.
+ *
+ * Windows spread evenly over the input are parsed for matches, using
+ * deflate's hash, and the literal/length and distance codes it would emit
+ * are costed by their entropy. The cost of the sample is scaled up to the
+ * whole input.
+ * Integer arithmetic only, with base two logarithms in Q8 fixed point.
+ */
+
+#include "zsc/zsc_pub.h"
+#include "zsc/zutil.h"
+#include "zsc/zsc_conf_private.h"
+#include "zsc/deflate.h"
+
+// length of each sampled segment, a full window
+#define ZSC_EST_SEG_LEN 32768U
+// number of segments sampled from a long input
+#define ZSC_EST_SEGS 4U
+// hash as in deflate, sized for a segment
+#define ZSC_EST_HASH_BITS 15U
+#define ZSC_EST_HASH_SIZE (1U << ZSC_EST_HASH_BITS)
+#define ZSC_EST_HASH_SHIFT ((ZSC_EST_HASH_BITS + MIN_MATCH - 1) / MIN_MATCH)
+// longest stored block
+#define ZSC_EST_MAX_STORED 65535U
+// symbols per deflate block, and the bytes of its dynamic code description
+#define ZSC_EST_BLOCK_SYMS 16384U
+#define ZSC_EST_BLOCK_HEADER 64U
+
+// histograms and hash chains of the probe, laid out in the work buffer
+typedef struct zsc_est_probe_s {
+    U32 litlen[L_CODES];      // literal/length code counts
+    U32 dist[D_CODES];        // distance code counts
+    U32 extra_bits;           // length and distance extra bits
+    U32 syms;                 // symbols emitted
+    U16 head[ZSC_EST_HASH_SIZE]; // last position plus one, per hash
+    U16 prev[ZSC_EST_SEG_LEN];   // previous position plus one, per position
+} zsc_est_probe;
+
+// matches searched per position, by level, a fraction of deflate's
+ZSC_PRIVATE const U8 zsc_est_chain[10] = {0, 2, 2, 4, 4, 8, 16, 16, 16, 16};
+
+ZSC_PRIVATE U32 zsc_log2_q8(U32 x);
+ZSC_PRIVATE U32 zsc_est_entropy_q8(const U32 *hist, U32 num);
+ZSC_PRIVATE U32 zsc_est_longest(const U8 *seg, U32 len, U32 p,
+        const zsc_est_probe *probe, U32 chain, U32 *dist);
+ZSC_PRIVATE void zsc_est_insert(const U8 *seg, U32 p, zsc_est_probe *probe);
+ZSC_PRIVATE void zsc_estimate_probe(const U8 *seg, U32 len, I32 level,
+        zsc_est_probe *probe);
+
+// fraction of log2(1 + i/256), in Q8
+ZSC_PRIVATE const U8 zsc_log2_frac[256] = {
+      0,   1,   3,   4,   6,   7,   9,  10,  11,  13,  14,  16,
+     17,  18,  20,  21,  22,  24,  25,  26,  28,  29,  30,  32,
+     33,  34,  36,  37,  38,  40,  41,  42,  44,  45,  46,  47,
+     49,  50,  51,  52,  54,  55,  56,  57,  59,  60,  61,  62,
+     63,  65,  66,  67,  68,  69,  71,  72,  73,  74,  75,  77,
+     78,  79,  80,  81,  82,  84,  85,  86,  87,  88,  89,  90,
+     92,  93,  94,  95,  96,  97,  98,  99, 100, 102, 103, 104,
+    105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 116, 117,
+    118, 119, 120, 121, 122, 123, 124, 125, 126, 127, 128, 129,
+    130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141,
+    142, 143, 144, 145, 146, 147, 148, 149, 150, 151, 152, 153,
+    154, 155, 155, 156, 157, 158, 159, 160, 161, 162, 163, 164,
+    165, 166, 167, 168, 169, 169, 170, 171, 172, 173, 174, 175,
+    176, 177, 178, 178, 179, 180, 181, 182, 183, 184, 185, 185,
+    186, 187, 188, 189, 190, 191, 192, 192, 193, 194, 195, 196,
+    197, 198, 198, 199, 200, 201, 202, 203, 203, 204, 205, 206,
+    207, 208, 208, 209, 210, 211, 212, 212, 213, 214, 215, 216,
+    216, 217, 218, 219, 220, 220, 221, 222, 223, 224, 224, 225,
+    226, 227, 228, 228, 229, 230, 231, 231, 232, 233, 234, 234,
+    235, 236, 237, 238, 238, 239, 240, 241, 241, 242, 243, 244,
+    244, 245, 246, 247, 247, 248, 249, 249, 250, 251, 252, 252,
+    253, 254, 255, 255
+};
+
+// base two logarithm of x > 0, in Q8
+ZSC_PRIVATE U32 zsc_log2_q8(U32 x)
+{
+    ZSC_ASSERT(x != 0);
+
+    U32 k = 0;
+    while ((x >> k) > 1) {
+        k++;
+    }
+    U32 m = (k >= 8) ? (x >> (k - 8)) : (x << (8 - k));
+    return (k << 8) + zsc_log2_frac[m & 0xff];
+}
+
+// entropy of a histogram, in bits, in Q8: sum of c * log2(total / c)
+ZSC_PRIVATE U32 zsc_est_entropy_q8(const U32 *hist, U32 num)
+{
+    ZSC_ASSERT(hist != Z_NULL);
+
+    U32 total = 0;
+    U32 i;
+    for (i = 0; i < num; i++) {
+        total += hist[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    U32 log_total = zsc_log2_q8(total);
+    U32 bits_q8 = 0;
+    for (i = 0; i < num; i++) {
+        if (hist[i] != 0) {
+            // a code is never shorter than a bit
+            bits_q8 += hist[i]
+                    * ZMAX(log_total - zsc_log2_q8(hist[i]), 1U << 8);
+        }
+    }
+    return bits_q8;
+}
+
+// add position p to the hash chains
+ZSC_PRIVATE void zsc_est_insert(const U8 *seg, U32 p, zsc_est_probe *probe)
+{
+    U32 h = (((U32)seg[p] << (2 * ZSC_EST_HASH_SHIFT))
+            ^ ((U32)seg[p + 1] << ZSC_EST_HASH_SHIFT)
+            ^ (U32)seg[p + 2]) & (ZSC_EST_HASH_SIZE - 1);
+    probe->prev[p] = probe->head[h];
+    probe->head[h] = (U16)(p + 1);
+}
+
+// longest match for position p, already inserted, up to chain candidates
+ZSC_PRIVATE U32 zsc_est_longest(const U8 *seg, U32 len, U32 p,
+        const zsc_est_probe *probe, U32 chain, U32 *dist)
+{
+    U32 best = 0;
+    U32 max = ZMIN(len - p, MAX_MATCH);
+    U32 cand = probe->prev[p];
+    while (cand != 0 && chain > 0) {
+        const U8 *prev = seg + (cand - 1);
+        // check the byte that would make it longer first, as deflate does
+        if (prev[best] == seg[p + best]) {
+            U32 n = 0;
+            while (n < max && prev[n] == seg[p + n]) {
+                n++;
+            }
+            if (n > best) {
+                best = n;
+                *dist = p + 1 - cand;
+                if (n == max) {
+                    break;
+                }
+            }
+        }
+        cand = probe->prev[cand - 1];
+        chain--;
+    }
+    return best;
+}
+
+/* ===========================================================================
+     Parses one segment as deflate would within it, counting the codes it
+   would emit: greedy for levels 1 to 3, lazy by one byte above that, with
+   a shorter chain search than deflate's. A match of three is only taken if
+   it is close, as deflate drops those over TOO_FAR.
+*/
+ZSC_PRIVATE void zsc_estimate_probe(const U8 *seg, U32 len, I32 level,
+        zsc_est_probe *probe)
+{
+    ZSC_ASSERT(seg != Z_NULL);
+    ZSC_ASSERT(probe != Z_NULL);
+    ZSC_ASSERT1(len <= ZSC_EST_SEG_LEN, len);
+    ZSC_ASSERT1(level >= 1 && level <= 9, level);
+
+    zmemzero((U8*)probe->head, sizeof(probe->head));
+    U32 chain = zsc_est_chain[level];
+    U32 lazy = (level >= 4);
+    U32 p = 0;
+    U32 n = 0;
+    U32 dist = 0;
+    if (len >= MIN_MATCH) {
+        zsc_est_insert(seg, 0, probe);
+        n = zsc_est_longest(seg, len, 0, probe, chain, &dist);
+    }
+    while (p + MIN_MATCH <= len) {
+        if (n == MIN_MATCH && dist > 4096) {
+            n = 0;
+        }
+        U32 next_n = 0;
+        U32 next_dist = 0;
+        if (p + 1 + MIN_MATCH <= len) {
+            zsc_est_insert(seg, p + 1, probe);
+            if (lazy || n < MIN_MATCH) {
+                next_n = zsc_est_longest(seg, len, p + 1, probe, chain,
+                        &next_dist);
+            }
+        }
+        if (n >= MIN_MATCH && !(lazy && next_n > n)) {
+            U32 lc = _length_code[n - MIN_MATCH];
+            U32 dc = d_code(dist - 1);
+            probe->litlen[lc + LITERALS + 1]++;
+            probe->dist[dc]++;
+            probe->extra_bits += ((lc < 8 || lc == 28) ? 0 : (lc - 4) / 4)
+                    + ((dc < 4) ? 0 : (dc - 2) / 2);
+            // positions inside the match still go in the chains
+            U32 end = ZMIN(p + n, len - MIN_MATCH + 1);
+            U32 q;
+            for (q = p + 2; q < end; q++) {
+                zsc_est_insert(seg, q, probe);
+            }
+            p += n;
+            n = 0;
+            if (p + MIN_MATCH <= len) {
+                zsc_est_insert(seg, p, probe);
+                n = zsc_est_longest(seg, len, p, probe, chain, &dist);
+            }
+        } else {
+            probe->litlen[seg[p]]++;
+            p++;
+            n = next_n;
+            dist = next_dist;
+        }
+        probe->syms++;
+    }
+    for (; p < len; p++) {
+        probe->litlen[seg[p]]++;
+        probe->syms++;
+    }
+}
+
+ZlibReturn zsc_estimate_get_min_work_buf_size(U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    *size_out = (U32)sizeof(zsc_est_probe);
+    return Z_OK;
+}
+
+ZlibReturn zsc_estimate_ratio(const U8 *source, U32 source_len, I32 level,
+        U8 *work, U32 work_len, U32 *size_out)
+{
+    ZSC_ASSERT(source != Z_NULL || source_len == 0);
+    ZSC_ASSERT(work != Z_NULL);
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    *size_out = U32_MAX;
+    if (level == Z_DEFAULT_COMPRESSION) {
+        level = 6;
+    }
+    if (level < 0 || level > 9) {
+        ZSC_WARN1("In zsc_estimate_ratio(), bad level %d.", level);
+        return Z_STREAM_ERROR;
+    }
+    U32 min_work_buf_size = U32_MAX;
+    ZlibReturn err = zsc_estimate_get_min_work_buf_size(&min_work_buf_size);
+    ZSC_ASSERT1(err == Z_OK, err);
+    if (work_len < min_work_buf_size) {
+        ZSC_WARN2("In zsc_estimate_ratio(), working memory (%u B) "
+                "was smaller than required (%u B).",
+                work_len, min_work_buf_size);
+        return Z_MEM_ERROR;
+    }
+
+    // zlib wrapper, plus stored block headers, the most deflate will give
+    U32 stored_blocks = source_len / ZSC_EST_MAX_STORED + 1;
+    U32 wrapper = 2 + 4;
+    U32 stored_len = U32_MAX;
+    if (source_len <= U32_MAX - wrapper - 5 * stored_blocks) {
+        stored_len = source_len + wrapper + 5 * stored_blocks;
+    }
+    if (level == 0 || source_len == 0) {
+        *size_out = stored_len;
+        return Z_OK;
+    }
+
+    zsc_est_probe *probe = (zsc_est_probe *)work;
+    zmemzero(work, sizeof(zsc_est_probe));
+    U32 sampled = 0;
+    if (source_len <= ZSC_EST_SEGS * ZSC_EST_SEG_LEN) {
+        // short inputs are parsed in full, a window at a time
+        U32 off;
+        for (off = 0; off < source_len; off += ZSC_EST_SEG_LEN) {
+            zsc_estimate_probe(source + off,
+                    ZMIN(source_len - off, ZSC_EST_SEG_LEN), level, probe);
+        }
+        sampled = source_len;
+    } else {
+        // evenly spaced, the first at the start and the last at the end
+        U32 spacing = (source_len - ZSC_EST_SEG_LEN) / (ZSC_EST_SEGS - 1);
+        U32 seg;
+        for (seg = 0; seg < ZSC_EST_SEGS; seg++) {
+            zsc_estimate_probe(source + seg * spacing, ZSC_EST_SEG_LEN,
+                    level, probe);
+        }
+        sampled = ZSC_EST_SEGS * ZSC_EST_SEG_LEN;
+    }
+
+    // codes cost their entropy, as a Huffman code nearly does, plus the
+    // end of block and the code descriptions of each block
+    U32 blocks = probe->syms / ZSC_EST_BLOCK_SYMS + 1;
+    probe->litlen[LITERALS] += blocks;
+    // at most 128 KiB sampled, 17 bits a symbol, in Q8: no overflow
+    U32 sample_len = (zsc_est_entropy_q8(probe->litlen, L_CODES) >> 11)
+            + (zsc_est_entropy_q8(probe->dist, D_CODES) >> 11)
+            + (probe->extra_bits >> 3) + blocks * ZSC_EST_BLOCK_HEADER + 1;
+
+    // scale the sample's ratio, in Q12, to the whole input
+    U32 ratio_q12 = (sample_len << 12) / sampled;
+    U32 whole = source_len >> 12;
+    U32 part = source_len & 0xfff;
+    U32 estimate = stored_len;
+    if (ratio_q12 == 0 || whole <= (U32_MAX >> 1) / ratio_q12) {
+        estimate = whole * ratio_q12 + ((part * ratio_q12) >> 12) + wrapper;
+    }
+    *size_out = ZMIN(estimate, stored_len);
+    return Z_OK;
+}
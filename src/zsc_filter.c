@@ -0,0 +1,460 @@
+/***********************************************************************
+ * Copyright 2020, by the California Institute of Technology.
+ * ALL RIGHTS RESERVED. United States Government Sponsorship acknowledged.
+ * Any commercial use must be negotiated with the Office of Technology
+ * Transfer at the California Institute of Technology.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file        zsc_filter.c
+ * @date        2020-07-01
+ * @author      Neil Abcouwer
+ * @brief       Function definitions for reversible pre-compression filters.
+ *
+ * Filters rearrange or difference fixed-width samples so that deflate sees
+ * long runs of small values. Each call filters one buffer independently,
+ * so filtered blocks keep the independence given by full flushes.
+ */
+
+#include "zsc/zsc_pub.h"
+#include "zsc/zutil.h"
+#include "zsc/zsc_conf_private.h"
+
+ZSC_PRIVATE void zsc_filter_delta_encode(U8 *dest, const U8 *source,
+        U32 len, U32 width);
+ZSC_PRIVATE void zsc_filter_delta_decode(U8 *dest, const U8 *source,
+        U32 len, U32 width);
+ZSC_PRIVATE void zsc_filter_xor_encode(U8 *dest, const U8 *source,
+        U32 len, U32 width);
+ZSC_PRIVATE void zsc_filter_xor_decode(U8 *dest, const U8 *source,
+        U32 len, U32 width);
+ZSC_PRIVATE void zsc_filter_transpose(U8 *dest, const U8 *source,
+        U32 len, U32 width, I32 inverse);
+ZSC_PRIVATE void zsc_filter_png_encode(U8 *dest, const U8 *source,
+        U32 len, U32 width, U32 stride);
+ZSC_PRIVATE ZlibReturn zsc_filter_png_decode(U8 *dest, const U8 *source,
+        U32 len, U32 width, U32 stride);
+ZSC_PRIVATE U8 zsc_png_paeth(U8 a, U8 b, U8 c);
+
+// check that a filter is one this library knows how to apply
+ZlibReturn zsc_filter_check(const zsc_filter *filter)
+{
+    ZSC_ASSERT(filter != Z_NULL);
+
+    if (filter->type == ZSC_FILTER_NONE) {
+        return Z_OK;
+    }
+    if (filter->type != ZSC_FILTER_DELTA && filter->type != ZSC_FILTER_XOR
+            && filter->type != ZSC_FILTER_TRANSPOSE
+            && filter->type != ZSC_FILTER_PNG) {
+        ZSC_WARN1("In zsc_filter_check(), unknown filter type %d.",
+                filter->type);
+        return Z_STREAM_ERROR;
+    }
+    if (filter->width == 0 || filter->width > ZSC_FILTER_MAX_WIDTH) {
+        ZSC_WARN1("In zsc_filter_check(), bad filter width %u.",
+                filter->width);
+        return Z_STREAM_ERROR;
+    }
+    if (filter->type == ZSC_FILTER_PNG && filter->stride < filter->width) {
+        ZSC_WARN2("In zsc_filter_check(), stride %u shorter than pixel "
+                "width %u.", filter->stride, filter->width);
+        return Z_STREAM_ERROR;
+    }
+    // bounded so that a row and its type byte can't overflow
+    if (filter->type == ZSC_FILTER_PNG
+            && filter->stride > ZSC_FILTER_MAX_STRIDE) {
+        ZSC_WARN1("In zsc_filter_check(), bad stride %u.", filter->stride);
+        return Z_STREAM_ERROR;
+    }
+    return Z_OK;
+}
+
+ZlibReturn zsc_filter_get_encoded_len(const zsc_filter *filter, U32 len,
+        U32 *size_out)
+{
+    ZSC_ASSERT(filter != Z_NULL);
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    ZlibReturn err = zsc_filter_check(filter);
+    if (err != Z_OK) {
+        return err;
+    }
+    U32 extra = (filter->type == ZSC_FILTER_PNG) ? len / filter->stride : 0;
+    if (extra > U32_MAX - len) {
+        ZSC_WARN1("In zsc_filter_get_encoded_len(), length %u overflows "
+                "once filtered.", len);
+        return Z_STREAM_ERROR;
+    }
+    *size_out = len + extra;
+    return Z_OK;
+}
+
+ZlibReturn zsc_filter_get_decoded_len(const zsc_filter *filter,
+        U32 encoded_len, U32 *size_out)
+{
+    ZSC_ASSERT(filter != Z_NULL);
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    ZlibReturn err = zsc_filter_check(filter);
+    if (err != Z_OK) {
+        return err;
+    }
+    if (filter->type != ZSC_FILTER_PNG) {
+        *size_out = encoded_len;
+        return Z_OK;
+    }
+    // whole rows gain a byte, a partial row is shorter than a stride
+    U32 rows = encoded_len / (filter->stride + 1U);
+    U32 rest = encoded_len - rows * (filter->stride + 1U);
+    if (rest >= filter->stride) {
+        ZSC_WARN1("In zsc_filter_get_decoded_len(), no buffer filters "
+                "to %u bytes.", encoded_len);
+        return Z_DATA_ERROR;
+    }
+    *size_out = rows * filter->stride + rest;
+    return Z_OK;
+}
+
+ZlibReturn zsc_filter_encode(const zsc_filter *filter,
+        U8 *dest, const U8 *source, U32 len)
+{
+    ZSC_ASSERT(filter != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(dest != source);
+
+    ZlibReturn err = zsc_filter_check(filter);
+    if (err != Z_OK) {
+        return err;
+    }
+    switch (filter->type) {
+    case ZSC_FILTER_DELTA:
+        zsc_filter_delta_encode(dest, source, len, filter->width);
+        break;
+    case ZSC_FILTER_XOR:
+        zsc_filter_xor_encode(dest, source, len, filter->width);
+        break;
+    case ZSC_FILTER_TRANSPOSE:
+        zsc_filter_transpose(dest, source, len, filter->width, 0);
+        break;
+    case ZSC_FILTER_PNG:
+        zsc_filter_png_encode(dest, source, len, filter->width,
+                filter->stride);
+        break;
+    default: // ZSC_FILTER_NONE
+        zmemcpy(dest, source, len);
+        break;
+    }
+    return Z_OK;
+}
+
+ZlibReturn zsc_filter_decode(const zsc_filter *filter,
+        U8 *dest, const U8 *source, U32 len)
+{
+    ZSC_ASSERT(filter != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(dest != source);
+
+    ZlibReturn err = zsc_filter_check(filter);
+    if (err != Z_OK) {
+        return err;
+    }
+    switch (filter->type) {
+    case ZSC_FILTER_DELTA:
+        zsc_filter_delta_decode(dest, source, len, filter->width);
+        break;
+    case ZSC_FILTER_XOR:
+        zsc_filter_xor_decode(dest, source, len, filter->width);
+        break;
+    case ZSC_FILTER_TRANSPOSE:
+        zsc_filter_transpose(dest, source, len, filter->width, 1);
+        break;
+    case ZSC_FILTER_PNG:
+        err = zsc_filter_png_decode(dest, source, len, filter->width,
+                filter->stride);
+        break;
+    default: // ZSC_FILTER_NONE
+        zmemcpy(dest, source, len);
+        break;
+    }
+    return err;
+}
+
+// difference of each byte from the byte width back, first width kept
+ZSC_PRIVATE void zsc_filter_delta_encode(U8 *dest, const U8 *source,
+        U32 len, U32 width)
+{
+    U32 head = ZMIN(len, width);
+    U32 i;
+    for (i = 0; i < head; i++) {
+        dest[i] = source[i];
+    }
+    for (i = head; i < len; i++) {
+        dest[i] = (U8)(source[i] - source[i - width]);
+    }
+}
+
+ZSC_PRIVATE void zsc_filter_delta_decode(U8 *dest, const U8 *source,
+        U32 len, U32 width)
+{
+    U32 head = ZMIN(len, width);
+    U32 i;
+    for (i = 0; i < head; i++) {
+        dest[i] = source[i];
+    }
+    for (i = head; i < len; i++) {
+        dest[i] = (U8)(source[i] + dest[i - width]);
+    }
+}
+
+// xor of each sample with the one before: equal sign, exponent and
+// high mantissa bits of slowly changing floats become zero bytes
+ZSC_PRIVATE void zsc_filter_xor_encode(U8 *dest, const U8 *source,
+        U32 len, U32 width)
+{
+    U32 head = ZMIN(len, width);
+    U32 i;
+    for (i = 0; i < head; i++) {
+        dest[i] = source[i];
+    }
+    for (i = head; i < len; i++) {
+        dest[i] = (U8)(source[i] ^ source[i - width]);
+    }
+}
+
+ZSC_PRIVATE void zsc_filter_xor_decode(U8 *dest, const U8 *source,
+        U32 len, U32 width)
+{
+    U32 head = ZMIN(len, width);
+    U32 i;
+    for (i = 0; i < head; i++) {
+        dest[i] = source[i];
+    }
+    for (i = head; i < len; i++) {
+        dest[i] = (U8)(source[i] ^ dest[i - width]);
+    }
+}
+
+// gather byte b of every width byte record into plane b, or scatter back.
+// this is the byte shuffle of arrays of width byte elements.
+// a partial record at the end is copied as is.
+// each pass over the records handles four planes, then two, then one,
+// which reads (or writes) each record a quarter as often as a pass per plane
+ZSC_PRIVATE void zsc_filter_transpose(U8 *dest, const U8 *source,
+        U32 len, U32 width, I32 inverse)
+{
+    U32 records = len / width;
+    U32 body = records * width;
+    U32 b = 0;
+    U32 r;
+    while (b < width) {
+        U32 planes = (width - b >= 4) ? 4 : (width - b >= 2) ? 2 : 1;
+        if (inverse) {
+            const U8 *p0 = source + b * records;
+            U32 off = b; // offset of byte b of record r
+            if (planes == 4) {
+                const U8 *p1 = p0 + records;
+                const U8 *p2 = p1 + records;
+                const U8 *p3 = p2 + records;
+                for (r = 0; r < records; r++) {
+                    dest[off] = p0[r];
+                    dest[off + 1] = p1[r];
+                    dest[off + 2] = p2[r];
+                    dest[off + 3] = p3[r];
+                    off += width;
+                }
+            } else if (planes == 2) {
+                const U8 *p1 = p0 + records;
+                for (r = 0; r < records; r++) {
+                    dest[off] = p0[r];
+                    dest[off + 1] = p1[r];
+                    off += width;
+                }
+            } else {
+                for (r = 0; r < records; r++) {
+                    dest[off] = p0[r];
+                    off += width;
+                }
+            }
+        } else {
+            U8 *p0 = dest + b * records;
+            U32 off = b; // offset of byte b of record r
+            if (planes == 4) {
+                U8 *p1 = p0 + records;
+                U8 *p2 = p1 + records;
+                U8 *p3 = p2 + records;
+                for (r = 0; r < records; r++) {
+                    p0[r] = source[off];
+                    p1[r] = source[off + 1];
+                    p2[r] = source[off + 2];
+                    p3[r] = source[off + 3];
+                    off += width;
+                }
+            } else if (planes == 2) {
+                U8 *p1 = p0 + records;
+                for (r = 0; r < records; r++) {
+                    p0[r] = source[off];
+                    p1[r] = source[off + 1];
+                    off += width;
+                }
+            } else {
+                for (r = 0; r < records; r++) {
+                    p0[r] = source[off];
+                    off += width;
+                }
+            }
+        }
+        b += planes;
+    }
+    zmemcpy(dest + body, source + body, len - body);
+}
+
+// the PNG Paeth predictor: whichever of left, above, and upper left
+// is closest to left + above - upper left
+ZSC_PRIVATE U8 zsc_png_paeth(U8 a, U8 b, U8 c)
+{
+    I32 p = (I32)a + (I32)b - (I32)c;
+    I32 pa = (p > (I32)a) ? p - (I32)a : (I32)a - p;
+    I32 pb = (p > (I32)b) ? p - (I32)b : (I32)b - p;
+    I32 pc = (p > (I32)c) ? p - (I32)c : (I32)c - p;
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+}
+
+// magnitude of a filtered byte, taken as signed, for choosing predictors
+#define PNG_COST(x) ((U32)(((x) < 128U) ? (x) : 256U - (x)))
+
+// for each whole row, try the five predictors, keep the one with the
+// smallest sum of magnitudes, and write its type then the filtered row.
+// the row above the first row of a buffer, and pixels left of each row,
+// are taken as zero. a partial row at the end is copied as is.
+ZSC_PRIVATE void zsc_filter_png_encode(U8 *dest, const U8 *source,
+        U32 len, U32 width, U32 stride)
+{
+    U32 rows = len / stride;
+    U32 row;
+    U32 i;
+    for (row = 0; row < rows; row++) {
+        const U8 *cur = source + row * stride;
+        const U8 *up = (row > 0) ? cur - stride : Z_NULL;
+        U8 *out = dest + row * (stride + 1U);
+
+        // cost of each predictor
+        U32 cost[ZSC_PNG_PAETH + 1] = {0, 0, 0, 0, 0};
+        for (i = 0; i < stride; i++) {
+            U8 x = cur[i];
+            U8 a = (i >= width) ? cur[i - width] : 0;
+            U8 b = (up != Z_NULL) ? up[i] : 0;
+            U8 c = (up != Z_NULL && i >= width) ? up[i - width] : 0;
+            cost[ZSC_PNG_NONE] += PNG_COST(x);
+            cost[ZSC_PNG_SUB] += PNG_COST((U8)(x - a));
+            cost[ZSC_PNG_UP] += PNG_COST((U8)(x - b));
+            cost[ZSC_PNG_AVERAGE] += PNG_COST((U8)(x - (U8)((a + b) >> 1)));
+            cost[ZSC_PNG_PAETH] += PNG_COST((U8)(x - zsc_png_paeth(a, b, c)));
+        }
+        U32 type = ZSC_PNG_NONE;
+        U32 t;
+        for (t = ZSC_PNG_SUB; t <= ZSC_PNG_PAETH; t++) {
+            if (cost[t] < cost[type]) {
+                type = t;
+            }
+        }
+
+        out[0] = (U8)type;
+        out++;
+        for (i = 0; i < stride; i++) {
+            U8 a = (i >= width) ? cur[i - width] : 0;
+            U8 b = (up != Z_NULL) ? up[i] : 0;
+            U8 c = (up != Z_NULL && i >= width) ? up[i - width] : 0;
+            U8 pred = (type == ZSC_PNG_SUB) ? a
+                    : (type == ZSC_PNG_UP) ? b
+                    : (type == ZSC_PNG_AVERAGE) ? (U8)((a + b) >> 1)
+                    : (type == ZSC_PNG_PAETH) ? zsc_png_paeth(a, b, c)
+                    : 0;
+            out[i] = (U8)(cur[i] - pred);
+        }
+    }
+    U32 body = rows * stride;
+    zmemcpy(dest + rows * (stride + 1U), source + body, len - body);
+}
+
+// undo each row's predictor, one loop per type so each is a simple pass
+ZSC_PRIVATE ZlibReturn zsc_filter_png_decode(U8 *dest, const U8 *source,
+        U32 len, U32 width, U32 stride)
+{
+    ZlibReturn err = Z_OK;
+    U32 rows = len / stride;
+    U32 row;
+    U32 i;
+    for (row = 0; row < rows; row++) {
+        const U8 *in = source + row * (stride + 1U);
+        U8 type = in[0];
+        in++;
+        U8 *cur = dest + row * stride;
+        const U8 *up = (row > 0) ? cur - stride : Z_NULL;
+        U32 head = ZMIN(width, stride);
+
+        if (type == ZSC_PNG_SUB) {
+            for (i = 0; i < head; i++) {
+                cur[i] = in[i];
+            }
+            for (i = head; i < stride; i++) {
+                cur[i] = (U8)(in[i] + cur[i - width]);
+            }
+        } else if (type == ZSC_PNG_UP && up != Z_NULL) {
+            for (i = 0; i < stride; i++) {
+                cur[i] = (U8)(in[i] + up[i]);
+            }
+        } else if (type == ZSC_PNG_AVERAGE) {
+            for (i = 0; i < head; i++) {
+                U8 b = (up != Z_NULL) ? up[i] : 0;
+                cur[i] = (U8)(in[i] + (b >> 1));
+            }
+            for (i = head; i < stride; i++) {
+                U8 b = (up != Z_NULL) ? up[i] : 0;
+                cur[i] = (U8)(in[i] + (U8)((cur[i - width] + b) >> 1));
+            }
+        } else if (type == ZSC_PNG_PAETH && up != Z_NULL) {
+            for (i = 0; i < head; i++) {
+                cur[i] = (U8)(in[i] + up[i]); // Paeth of (0, b, 0) is b
+            }
+            for (i = head; i < stride; i++) {
+                cur[i] = (U8)(in[i] + zsc_png_paeth(cur[i - width], up[i],
+                        up[i - width]));
+            }
+        } else if (type == ZSC_PNG_PAETH) {
+            // first row: Paeth of (a, 0, 0) is a
+            for (i = 0; i < head; i++) {
+                cur[i] = in[i];
+            }
+            for (i = head; i < stride; i++) {
+                cur[i] = (U8)(in[i] + cur[i - width]);
+            }
+        } else {
+            // ZSC_PNG_NONE, up on the first row (adds zero), or corrupt
+            if (type > ZSC_PNG_PAETH) {
+                err = Z_DATA_ERROR;
+            }
+            for (i = 0; i < stride; i++) {
+                cur[i] = in[i];
+            }
+        }
+    }
+    U32 body = rows * stride;
+    zmemcpy(dest + body, source + rows * (stride + 1U), len - body);
+    if (err != Z_OK) {
+        ZSC_WARN("In zsc_filter_png_decode(), unknown row predictor.");
+    }
+    return err;
+}
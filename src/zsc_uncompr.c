@@ -29,6 +29,23 @@
 #include "zsc/zsc_conf_private.h"
 #include "zsc/zutil.h"
 
+ZSC_PRIVATE ZlibReturn zsc_uncompress_gzip_common(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head,
+        const zsc_dict_registry *reg, const char *caller);
+ZSC_PRIVATE ZlibReturn zsc_uncompress_gzip_buf(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head,
+        const zsc_dict_registry *reg, const char *caller);
+ZSC_PRIVATE ZlibReturn zsc_unfilter_block(const zsc_filter *filter,
+        U8 *dest, U32 dest_left, const U8 *block, U32 block_len,
+        U32 *out_len);
+ZSC_PRIVATE void zsc_iov_next_in(z_stream *strm,
+        const zsc_const_iovec *source, U32 source_cnt, U32 *seg);
+ZSC_PRIVATE void zsc_iov_next_out(z_stream *strm,
+        const zsc_iovec *dest, U32 dest_cnt, U32 *seg);
+
 ZlibReturn zsc_uncompress_get_min_work_buf_size2(
         I32 window_bits, U32 *size_out)
 {
@@ -41,43 +58,88 @@ ZlibReturn zsc_uncompress_get_min_work_buf_size(U32 *size_out)
     return inflateWorkSize(size_out);
 }
 
-ZlibReturn zsc_uncompress_gzip2(
-        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
-        U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head)
+/* ===========================================================================
+     Decompresses the source segments into the destination segments, using
+   memory from the work buffer.  The source is the concatenation of its
+   source_cnt segments, and output is written across the dest_cnt dest
+   segments in order; the single buffer entry points pass one of each.  Upon
+   exit, dest_len is the total size of the output and source_len the number
+   of source bytes used.
+
+     If the first source segment holds a gzip header with a zsc info
+   subfield covered by the header crc, the output is checked to fit before
+   inflating.
+
+     If gz_head is not null, the gzip header is saved there.  If reg is not
+   null, a dictionary the stream asks for is looked up in it by id.
+
+     A corrupt stream is resynchronized at the next full flush point, across
+   segments, and Z_DATA_ERROR is returned with what could be recovered.
+
+     caller is the name of the public entry point, for warnings.
+*/
+ZSC_PRIVATE ZlibReturn zsc_uncompress_gzip_common(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head,
+        const zsc_dict_registry *reg, const char *caller)
 {
-    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(source != Z_NULL || source_cnt == 0);
     ZSC_ASSERT(source_len != Z_NULL);
-    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL || dest_cnt == 0);
     ZSC_ASSERT(dest_len != Z_NULL);
     ZSC_ASSERT(work != Z_NULL);
+    ZSC_ASSERT(caller != Z_NULL);
     // gz_head can be null
+    // reg can be null
 
     z_stream stream;
     zmemzero((U8*)&stream, sizeof(stream));
     stream.next_work = work;
     stream.avail_work = work_len;
-    stream.next_in = (const U8 *)source;
-    stream.avail_in = *source_len;
-    stream.next_out = dest;
-    stream.avail_out = *dest_len;
-    U32 dest_len_in = *dest_len;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    stream.next_out = Z_NULL;
+    stream.avail_out = 0;
+
+    U32 dest_len_in = 0;
+    U32 seg;
+    for (seg = 0; seg < dest_cnt; seg++) {
+        dest_len_in += ZMIN(dest[seg].len, U32_MAX - dest_len_in);
+    }
 
     // buffers not yet touched
     *dest_len = 0;
     *source_len = 0;
 
+    // if there may be a gzip header with info, check the output will fit.
+    // Only trust the info if the header crc covers it, else a flipped bit
+    // could reject a stream that inflate would mostly recover
+    zsc_info info;
+    if (window_bits > MAX_WBITS && source_cnt > 0 && source[0].len > 3
+            && (source[0].base[3] & 0x02) != 0 // FHCRC
+            && zsc_uncompress_get_info(source[0].base, source[0].len,
+                    &info) == Z_OK
+            && info.source_len > dest_len_in) {
+        ZSC_WARN3("In %s, output buffer (%u B) "
+                "is smaller than size in header info (%u B).",
+                caller, dest_len_in, info.source_len);
+        return Z_BUF_ERROR;
+    }
+
     // check if workbuffer is large enough
     U32 min_work_buf_size = U32_MAX;
     ZlibReturn err = zsc_uncompress_get_min_work_buf_size2(
             window_bits, &min_work_buf_size);
     if (err != Z_OK) {
-        ZSC_WARN1("In zsc_uncompress_safe_gzip2(), could not get work buffer size, "
-                "error %d.", err);
+        ZSC_WARN2("In %s, could not get work buffer size, "
+                "error %d.", caller, err);
         return err;
     }
     if (work_len < min_work_buf_size) {
-        ZSC_WARN2("In zsc_uncompress_safe_gzip2(), work buffer (%u B) "
-                "is smaller than required (%u B).", work_len, min_work_buf_size);
+        ZSC_WARN3("In %s, work buffer (%u B) "
+                "is smaller than required (%u B).",
+                caller, work_len, min_work_buf_size);
         return Z_MEM_ERROR;
     }
 
@@ -85,8 +147,8 @@ ZlibReturn zsc_uncompress_gzip2(
     err = inflateInit2(&stream, window_bits);
     if (err != Z_OK) {
         // might be unreachable, as windowbits is checked above
-        ZSC_WARN1("In zsc_uncompress_safe_gzip2(), could not inflateInit, "
-                "error %d.", err);
+        ZSC_WARN2("In %s, could not inflateInit, "
+                "error %d.", caller, err);
         return err;
     }
 
@@ -94,55 +156,334 @@ ZlibReturn zsc_uncompress_gzip2(
     if(gz_head != Z_NULL) {
         err = inflateGetHeader(&stream, gz_head);
         if (err != Z_OK) {
-            ZSC_WARN1("In zsc_uncompress_safe_gzip2(), could not get header, "
-                    "error %d.", err);
+            ZSC_WARN2("In %s, could not get header, "
+                    "error %d.", caller, err);
+            (void)inflateEnd(&stream); // clean up
             return err;
         }
     }
 
+    U32 seg_in = 0;  // next source segment
+    U32 seg_out = 0; // next dest segment
     I32 data_errors = 0;
-    U32 loop_limit = ZMAX(dest_len_in, 10);
+    U32 loop_limit = ZMAX(dest_len_in, 10) + dest_cnt + 2 * source_cnt;
     U32 loops = 0;
     while (err == Z_OK && loops < loop_limit) {
         loops++;
-        err = inflate(&stream, Z_FINISH);
+        zsc_iov_next_in(&stream, source, source_cnt, &seg_in);
+        zsc_iov_next_out(&stream, dest, dest_cnt, &seg_out);
+        // once the last segments are in use, no more will be given,
+        // so Z_FINISH can let inflate() skip saving the window
+        ZlibFlush flush = (seg_in == source_cnt && seg_out == dest_cnt)
+                ? Z_FINISH : Z_NO_FLUSH;
+        err = inflate(&stream, flush);
+        if (err == Z_NEED_DICT && reg != Z_NULL) {
+            // the stream gives the id of the dictionary it wants
+            const zsc_dict *dict = zsc_dict_find(reg, stream.adler);
+            if (dict != Z_NULL) {
+                err = inflateSetDictionary(&stream, dict->data, dict->len);
+            } else {
+                ZSC_WARN2("In %s, no dictionary "
+                        "registered with id 0x%08x.", caller, stream.adler);
+            }
+        }
         if (err == Z_DATA_ERROR) {
             // there was probably some corruption in the buffer
             data_errors++;
-            // try to find a new flush point to recover some partial data
+            // try to find a new flush point to recover some partial data,
+            // searching across segments
             err = inflateSync(&stream);
+            while (err == Z_DATA_ERROR && seg_in < source_cnt
+                    && loops < loop_limit) {
+                loops++;
+                zsc_iov_next_in(&stream, source, source_cnt, &seg_in);
+                err = inflateSync(&stream);
+            }
             if (err == Z_OK) {
-                ZSC_WARN1("In zsc_uncompress_safe_gzip2(), data error "
+                ZSC_WARN2("In %s, data error "
                         "in inflate stream, instance %d, "
                         "new flush point found, continuing inflation.",
-                        data_errors);
+                        caller, data_errors);
             } else {
-                ZSC_WARN2("In zsc_uncompress_safe_gzip2(), data error "
+                ZSC_WARN3("In %s, data error "
                         "in inflate stream, instance %d, inflateSync() returned %d, "
                         "could not find a new flush point.",
-                        data_errors, err);
+                        caller, data_errors, err);
             }
         }
     }
     ZSC_ASSERT2(loops < loop_limit, loops, loop_limit);
 
     *dest_len = stream.total_out;
-    *source_len = stream.total_in;
+    // inflate() leaves total_in short by the header when it asks for
+    // a dictionary, so count what was given less what is left instead
+    U32 given_in = 0;
+    for (seg = 0; seg < seg_in; seg++) {
+        given_in += source[seg].len;
+    }
+    *source_len = given_in - stream.avail_in;
 
     if(err != Z_STREAM_END) {
-        ZSC_WARN1("In zsc_uncompress_safe_gzip2(), inflate loop failed "
-                "with error %d.", err);
+        ZSC_WARN2("In %s, inflate loop failed "
+                "with error %d.", caller, err);
 
-        // when uncompressing with inflate(Z_FINISH),
-        // Z_STREAM_END is expected, not Z_OK
-        // Z_OK may indicate there wasn't enough output space
+        // when uncompressing to the end, Z_STREAM_END is expected, not Z_OK.
+        // Z_BUF_ERROR indicates input ran out or
+        // there wasn't enough output space
         (void)inflateEnd(&stream); // clean up
         return (err == Z_OK) ? Z_STREAM_ERROR : err;
     }
 
     err = inflateEnd(&stream);
     if (err != Z_OK) {
-        ZSC_WARN1("In zsc_uncompress_safe_gzip2(), could not inflateEnd, "
+        ZSC_WARN2("In %s, could not inflateEnd, "
+                "returned error %d.", caller, err);
+    }
+
+    // if we got a data error, overwrite any inflateEnd success
+    if (err == Z_OK && data_errors > 0) {
+        err = Z_DATA_ERROR;
+    }
+    return err;
+}
+
+// decompress single buffers, as one segment each
+ZSC_PRIVATE ZlibReturn zsc_uncompress_gzip_buf(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head,
+        const zsc_dict_registry *reg, const char *caller)
+{
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(source_len != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+
+    zsc_iovec dest_seg;
+    dest_seg.base = dest;
+    dest_seg.len = *dest_len;
+    zsc_const_iovec source_seg;
+    source_seg.base = source;
+    source_seg.len = *source_len;
+    return zsc_uncompress_gzip_common(&dest_seg, 1, dest_len,
+            &source_seg, 1, source_len, work, work_len, window_bits,
+            gz_head, reg, caller);
+}
+
+ZlibReturn zsc_uncompress_gzip2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head)
+{
+    return zsc_uncompress_gzip_buf(dest, dest_len, source, source_len,
+            work, work_len, window_bits, gz_head, Z_NULL,
+            "zsc_uncompress_gzip2()");
+}
+
+ZlibReturn zsc_uncompress_dict2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits,
+        const zsc_dict_registry *reg)
+{
+    ZSC_ASSERT(reg != Z_NULL);
+    return zsc_uncompress_gzip_buf(dest, dest_len, source, source_len,
+            work, work_len, window_bits, Z_NULL, reg,
+            "zsc_uncompress_dict2()");
+}
+
+ZlibReturn zsc_uncompress_dict(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, const zsc_dict_registry *reg)
+{
+    return zsc_uncompress_dict2(dest, dest_len, source, source_len,
+            work, work_len, DEF_WBITS, reg);
+}
+
+ZlibReturn zsc_uncompress_filter_get_min_work_buf_size2(U32 max_block_len,
+        I32 window_bits, const zsc_filter *filter, U32 *size_out)
+{
+    ZSC_ASSERT(filter != Z_NULL);
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    U32 inflate_size = U32_MAX;
+    ZlibReturn err = inflateWorkSize2(window_bits, &inflate_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    U32 filter_size = U32_MAX;
+    err = zsc_filter_get_encoded_len(filter, max_block_len, &filter_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    if (max_block_len == 0 || filter_size > U32_MAX - inflate_size) {
+        ZSC_WARN1("In zsc_uncompress_filter_get_min_work_buf_size2(), "
+                "bad max_block_len %u.", max_block_len);
+        return Z_STREAM_ERROR;
+    }
+    *size_out = inflate_size + filter_size;
+    return Z_OK;
+}
+
+// invert the filter on one inflated block, into the output
+ZSC_PRIVATE ZlibReturn zsc_unfilter_block(const zsc_filter *filter,
+        U8 *dest, U32 dest_left, const U8 *block, U32 block_len,
+        U32 *out_len)
+{
+    ZSC_ASSERT(out_len != Z_NULL);
+
+    *out_len = 0;
+    U32 len = U32_MAX;
+    ZlibReturn err = zsc_filter_get_decoded_len(filter, block_len, &len);
+    if (err != Z_OK) {
+        return Z_DATA_ERROR;
+    }
+    if (len > dest_left) {
+        ZSC_WARN2("In zsc_uncompress_filter2(), output buffer (%u B left) "
+                "too small for next block (%u B).", dest_left, len);
+        return Z_BUF_ERROR;
+    }
+    *out_len = len;
+    return zsc_filter_decode(filter, dest, block, len);
+}
+
+// decompress a filtered buffer, inverting the filter a block at a time
+ZlibReturn zsc_uncompress_filter2(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits)
+{
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(source_len != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+    ZSC_ASSERT(work != Z_NULL);
+
+    U32 dest_len_in = *dest_len;
+    U32 source_len_in = *source_len;
+
+    // buffers not yet touched
+    *dest_len = 0;
+    *source_len = 0;
+
+    // read the filter header
+    if (source_len_in < ZSC_FILTER_HEADER_LEN
+            || source[0] != ZSC_FILTER_ID1 || source[1] != ZSC_FILTER_ID2
+            || source[2] != ZSC_FILTER_VERSION) {
+        ZSC_WARN("In zsc_uncompress_filter2(), missing or unknown "
+                "filter header.");
+        return Z_DATA_ERROR;
+    }
+    zsc_filter filter;
+    filter.type = (zsc_filter_type)source[3];
+    filter.width = zsc_get_u32_le(source + 4);
+    U32 block_len = zsc_get_u32_le(source + 8);
+    filter.stride = zsc_get_u32_le(source + 12);
+    U32 enc_len = U32_MAX; // length of a full block, filtered
+    if (block_len == 0
+            || zsc_filter_get_encoded_len(&filter, block_len, &enc_len) != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_filter2(), bad filter header, "
+                "block length %u.", block_len);
+        return Z_DATA_ERROR;
+    }
+
+    // check if workbuffer is large enough: inflate state, then a block
+    U32 min_work_buf_size = U32_MAX;
+    ZlibReturn err = zsc_uncompress_filter_get_min_work_buf_size2(
+            block_len, window_bits, &filter, &min_work_buf_size);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_filter2(), could not get work buffer size, "
+                "error %d.", err);
+        return err;
+    }
+    if (work_len < min_work_buf_size) {
+        ZSC_WARN2("In zsc_uncompress_filter2(), work buffer (%u B) "
+                "is smaller than required (%u B).", work_len, min_work_buf_size);
+        return Z_MEM_ERROR;
+    }
+    U8 *block = work + (min_work_buf_size - enc_len);
+
+    z_stream stream;
+    zmemzero((U8*)&stream, sizeof(stream));
+    stream.next_work = work;
+    stream.avail_work = min_work_buf_size - enc_len;
+    stream.next_in = source + ZSC_FILTER_HEADER_LEN;
+    stream.avail_in = source_len_in - ZSC_FILTER_HEADER_LEN;
+
+    err = inflateInit2(&stream, window_bits);
+    if (err != Z_OK) {
+        // might be unreachable, as windowbits is checked above
+        ZSC_WARN1("In zsc_uncompress_filter2(), could not inflateInit, "
+                "error %d.", err);
+        return err;
+    }
+
+    U32 have = 0; // filtered bytes of the current block inflated so far
+    U32 out_len = 0;
+    I32 data_errors = 0;
+    U32 loop_limit = ZMAX(ZMAX(dest_len_in, source_len_in), 10);
+    U32 loops = 0;
+    while (err == Z_OK && loops < loop_limit) {
+        loops++;
+        stream.next_out = block + have;
+        stream.avail_out = enc_len - have;
+        err = inflate(&stream, Z_NO_FLUSH);
+        have = enc_len - stream.avail_out;
+        if (err == Z_DATA_ERROR) {
+            // a full block was decoded before the error, which came after
+            // its last byte. a partial block can't be unfiltered, drop it.
+            // then resume at the next flush point, which starts a new block
+            data_errors++;
+            if (have == enc_len) {
+                U32 added = 0;
+                (void)zsc_unfilter_block(&filter, dest + out_len,
+                        dest_len_in - out_len, block, have, &added);
+                out_len += added;
+            }
+            have = 0;
+            err = inflateSync(&stream);
+            if (err == Z_OK) {
+                ZSC_WARN1("In zsc_uncompress_filter2(), data error "
+                        "in inflate stream, instance %d, "
+                        "new flush point found, continuing inflation.",
+                        data_errors);
+            } else {
+                ZSC_WARN2("In zsc_uncompress_filter2(), data error "
+                        "in inflate stream, instance %d, inflateSync() returned %d, "
+                        "could not find a new flush point.",
+                        data_errors, err);
+            }
+        } else if (have == enc_len || (err == Z_STREAM_END && have != 0)) {
+            // block done, unfilter it into the output while it is hot
+            U32 added = 0;
+            ZlibReturn filter_err = zsc_unfilter_block(&filter,
+                    dest + out_len, dest_len_in - out_len, block, have, &added);
+            out_len += added;
+            have = 0;
+            if (filter_err == Z_BUF_ERROR) {
+                err = Z_BUF_ERROR;
+            } else if (filter_err != Z_OK) {
+                data_errors++;
+                ZSC_WARN1("In zsc_uncompress_filter2(), block could not be "
+                        "unfiltered, instance %d.", data_errors);
+            } else {
+                // block written
+            }
+        } else {
+            // more to inflate into this block
+        }
+    }
+    ZSC_ASSERT2(loops < loop_limit, loops, loop_limit);
+
+    *dest_len = out_len;
+    *source_len = ZSC_FILTER_HEADER_LEN + stream.total_in;
+
+    if (err != Z_STREAM_END) {
+        ZSC_WARN1("In zsc_uncompress_filter2(), inflate loop failed "
+                "with error %d.", err);
+        (void)inflateEnd(&stream); // clean up
+        return (err == Z_OK) ? Z_STREAM_ERROR : err;
+    }
+
+    err = inflateEnd(&stream);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_filter2(), could not inflateEnd, "
                 "returned error %d.", err);
     }
 
@@ -153,6 +494,244 @@ ZlibReturn zsc_uncompress_gzip2(
     return err;
 }
 
+ZlibReturn zsc_uncompress_filter(
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
+        U8 *work, U32 work_len)
+{
+    return zsc_uncompress_filter2(dest, dest_len, source, source_len,
+            work, work_len, DEF_WBITS);
+}
+
+// decompress many messages, re-using one inflate state
+ZlibReturn zsc_uncompress_batch(
+        zsc_batch_item *items, U32 num_items, U8 *work, U32 work_len,
+        I32 window_bits, const U8 *dictionary, U32 dict_len)
+{
+    ZSC_ASSERT(items != Z_NULL);
+    ZSC_ASSERT(work != Z_NULL);
+    // dictionary can be null
+
+    z_stream stream;
+    zmemzero((U8*)&stream, sizeof(stream));
+    stream.next_work = work;
+    stream.avail_work = work_len;
+
+    // check if workbuffer is large enough, and init the stream, once
+    U32 min_work_buf_size = U32_MAX;
+    ZlibReturn err = zsc_uncompress_get_min_work_buf_size2(
+            window_bits, &min_work_buf_size);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_batch(), could not get work buffer size, "
+                "error %d.", err);
+    } else if (work_len < min_work_buf_size) {
+        ZSC_WARN2("In zsc_uncompress_batch(), work buffer (%u B) "
+                "is smaller than required (%u B).", work_len, min_work_buf_size);
+        err = Z_MEM_ERROR;
+    } else {
+        err = inflateInit2(&stream, window_bits);
+        if (err != Z_OK) {
+            // might be unreachable, as windowbits is checked above
+            ZSC_WARN1("In zsc_uncompress_batch(), could not inflateInit, "
+                    "error %d.", err);
+        }
+    }
+
+    U32 i;
+    if (err != Z_OK) {
+        for (i = 0; i < num_items; i++) {
+            items[i].source_len = 0;
+            items[i].dest_len = 0;
+            items[i].err = err;
+        }
+        return err;
+    }
+
+    ZlibReturn batch_err = Z_OK;
+    for (i = 0; i < num_items; i++) {
+        zsc_batch_item *item = &items[i];
+        ZSC_ASSERT1(item->source != Z_NULL, i);
+        ZSC_ASSERT1(item->dest != Z_NULL, i);
+
+        // sizes are taken from what is left, as total_in and total_out
+        // don't count the input consumed before a Z_NEED_DICT return
+        U32 source_len_in = item->source_len;
+        U32 dest_len_in = item->dest_len;
+        err = inflateReset(&stream);
+        stream.next_in = item->source;
+        stream.avail_in = item->source_len;
+        stream.next_out = item->dest;
+        stream.avail_out = item->dest_len;
+
+        // a raw stream can't ask for its dictionary
+        if (err == Z_OK && window_bits < 0 && dictionary != Z_NULL) {
+            err = inflateSetDictionary(&stream, dictionary, dict_len);
+        }
+        if (err == Z_OK) {
+            // with Z_FINISH, inflate() runs until done or out of space
+            err = inflate(&stream, Z_FINISH);
+        }
+        if (err == Z_NEED_DICT && dictionary != Z_NULL) {
+            err = inflateSetDictionary(&stream, dictionary, dict_len);
+            if (err == Z_OK) {
+                err = inflate(&stream, Z_FINISH);
+            }
+        }
+
+        item->source_len = source_len_in - stream.avail_in;
+        item->dest_len = dest_len_in - stream.avail_out;
+        if (err == Z_STREAM_END) {
+            item->err = Z_OK;
+        } else {
+            ZSC_WARN2("In zsc_uncompress_batch(), item %u failed "
+                    "with error %d.", i, err);
+            item->err = (err == Z_OK) ? Z_STREAM_ERROR : err;
+            if (batch_err == Z_OK) {
+                batch_err = item->err;
+            }
+        }
+    }
+
+    err = inflateEnd(&stream);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_batch(), could not inflateEnd, "
+                "returned error %d.", err);
+    }
+
+    // an item error overrides any inflateEnd success
+    if (batch_err != Z_OK) {
+        err = batch_err;
+    }
+    return err;
+}
+
+// parse the gzip header for a zsc info subfield, without inflating
+ZlibReturn zsc_uncompress_get_info(
+        const U8 *source, U32 source_len, zsc_info *info)
+{
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(info != Z_NULL);
+
+    // fixed part of the header, then the extra field length
+    if (source_len < 12) {
+        return Z_BUF_ERROR;
+    }
+    if (source[0] != 0x1f || source[1] != 0x8b || source[2] != Z_DEFLATED
+            || (source[3] & 0x04) == 0) { // gzip, with FEXTRA set
+        return Z_DATA_ERROR;
+    }
+    U32 extra_end = 12 + ((U32)source[10] | ((U32)source[11] << 8));
+    if (extra_end > source_len) {
+        return Z_BUF_ERROR;
+    }
+
+    // if the header has a crc, check it covers what is read here
+    if ((source[3] & 0x02) != 0) { // FHCRC
+        U32 hcrc_pos = extra_end;
+        U32 field;
+        for (field = 0x08; field <= 0x10; field <<= 1) { // FNAME, FCOMMENT
+            if ((source[3] & field) != 0) {
+                while (hcrc_pos < source_len && source[hcrc_pos] != 0) {
+                    hcrc_pos++;
+                }
+                hcrc_pos++; // past the terminating zero
+            }
+        }
+        if (hcrc_pos > source_len || source_len - hcrc_pos < 2) {
+            return Z_BUF_ERROR;
+        }
+        U32 hcrc = (U32)source[hcrc_pos] | ((U32)source[hcrc_pos + 1] << 8);
+        if (hcrc != (crc32(0, source, hcrc_pos) & 0xffffU)) {
+            return Z_DATA_ERROR; // header corrupted
+        }
+    }
+
+    // walk the subfields
+    U32 pos = 12;
+    while (pos + 4 <= extra_end) {
+        U32 len = (U32)source[pos + 2] | ((U32)source[pos + 3] << 8);
+        if (pos + 4 + len > extra_end) {
+            return Z_DATA_ERROR; // malformed extra field
+        }
+        if (source[pos] == ZSC_INFO_SI1 && source[pos + 1] == ZSC_INFO_SI2
+                && len == ZSC_INFO_DATA_LEN) {
+            info->source_len = zsc_get_u32_le(source + pos + 4);
+            info->num_blocks = zsc_get_u32_le(source + pos + 8);
+            info->max_block_len = zsc_get_u32_le(source + pos + 12);
+            return Z_OK;
+        }
+        pos += 4 + len;
+    }
+    return Z_DATA_ERROR;
+}
+
+// decode the stream in counting mode to find its uncompressed size
+ZlibReturn zsc_uncompress_get_size2(
+        const U8 *source, U32 source_len, U8 *work, U32 work_len,
+        I32 window_bits, U32 *size_out)
+{
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(work != Z_NULL);
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    U8 dummy_out = 0; // inflate requires non-null output, but won't write it
+
+    z_stream stream;
+    zmemzero((U8*)&stream, sizeof(stream));
+    stream.next_work = work;
+    stream.avail_work = work_len;
+    stream.next_in = source;
+    stream.avail_in = source_len;
+    stream.next_out = &dummy_out;
+    stream.avail_out = U32_MAX;
+
+    *size_out = 0;
+
+    // check if workbuffer is large enough
+    U32 min_work_buf_size = U32_MAX;
+    ZlibReturn err = zsc_uncompress_get_min_work_buf_size2(
+            window_bits, &min_work_buf_size);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_get_size2(), could not get work buffer size, "
+                "error %d.", err);
+        return err;
+    }
+    if (work_len < min_work_buf_size) {
+        ZSC_WARN2("In zsc_uncompress_get_size2(), work buffer (%u B) "
+                "is smaller than required (%u B).", work_len, min_work_buf_size);
+        return Z_MEM_ERROR;
+    }
+
+    err = inflateInit2(&stream, window_bits);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_get_size2(), could not inflateInit, "
+                "error %d.", err);
+        return err;
+    }
+    err = inflateCount(&stream, 1);
+    ZSC_ASSERT1(err == Z_OK, err);
+
+    // all input and (virtual) output is available, so one call suffices
+    err = inflate(&stream, Z_FINISH);
+    *size_out = stream.total_out;
+    (void)inflateEnd(&stream);
+
+    if (err != Z_STREAM_END) {
+        ZSC_WARN1("In zsc_uncompress_get_size2(), inflate failed "
+                "with error %d.", err);
+        // Z_BUF_ERROR means the input was truncated
+        return (err == Z_OK) ? Z_STREAM_ERROR : err;
+    }
+    return Z_OK;
+}
+
+ZlibReturn zsc_uncompress_get_size(
+        const U8 *source, U32 source_len, U8 *work, U32 work_len,
+        U32 *size_out)
+{
+    return zsc_uncompress_get_size2(source, source_len, work, work_len,
+            DEF_WBITS, size_out);
+}
+
 ZlibReturn zsc_uncompress2(
         U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len,
         U8 *work, U32 work_len, I32 window_bits)
@@ -177,4 +756,175 @@ ZlibReturn zsc_uncompress_gzip(
             work, work_len, DEF_WBITS + GZIP_CODE, gz_head);
 }
 
+// if the stream has consumed its input, point it at the next
+// nonempty source segment, if any
+ZSC_PRIVATE void zsc_iov_next_in(z_stream *strm,
+        const zsc_const_iovec *source, U32 source_cnt, U32 *seg)
+{
+    ZSC_ASSERT(strm != Z_NULL);
+    ZSC_ASSERT(seg != Z_NULL);
+    while (strm->avail_in == 0 && *seg < source_cnt) {
+        ZSC_ASSERT(source[*seg].base != Z_NULL || source[*seg].len == 0);
+        strm->next_in = source[*seg].base;
+        strm->avail_in = source[*seg].len;
+        (*seg)++;
+    }
+}
+
+// if the stream has filled its output, point it at the next
+// nonempty dest segment, if any
+ZSC_PRIVATE void zsc_iov_next_out(z_stream *strm,
+        const zsc_iovec *dest, U32 dest_cnt, U32 *seg)
+{
+    ZSC_ASSERT(strm != Z_NULL);
+    ZSC_ASSERT(seg != Z_NULL);
+    while (strm->avail_out == 0 && *seg < dest_cnt) {
+        ZSC_ASSERT(dest[*seg].base != Z_NULL || dest[*seg].len == 0);
+        strm->next_out = dest[*seg].base;
+        strm->avail_out = dest[*seg].len;
+        (*seg)++;
+    }
+}
+
+ZlibReturn zsc_uncompress_iov_gzip2(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt, U32 *source_len,
+        U8 *work, U32 work_len, I32 window_bits, gz_header * gz_head)
+{
+    return zsc_uncompress_gzip_common(dest, dest_cnt, dest_len,
+            source, source_cnt, source_len, work, work_len, window_bits,
+            gz_head, Z_NULL, "zsc_uncompress_iov_gzip2()");
+}
+
+ZlibReturn zsc_uncompress_iov(
+        const zsc_iovec *dest, U32 dest_cnt, U32 *dest_len,
+        const zsc_const_iovec *source, U32 source_cnt, U32 *source_len,
+        U8 *work, U32 work_len)
+{
+    return zsc_uncompress_iov_gzip2(dest, dest_cnt, dest_len,
+            source, source_cnt, source_len, work, work_len, DEF_WBITS, Z_NULL);
+}
+
+// the reference is the window, then the inflate state
+ZlibReturn zsc_uncompress_frame_get_min_work_buf_size2(I32 window_bits,
+        U32 *size_out)
+{
+    ZSC_ASSERT(size_out != Z_NULL);
+
+    if (window_bits < 9 || window_bits > MAX_WBITS) {
+        ZSC_WARN1("In zsc_uncompress_frame_get_min_work_buf_size2(), "
+                "bad window_bits %d.", window_bits);
+        return Z_STREAM_ERROR;
+    }
+    U32 inflate_size = U32_MAX;
+    ZlibReturn err = inflateWorkSize2(window_bits, &inflate_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    *size_out = (1U << window_bits) + inflate_size;
+    return Z_OK;
+}
+
+ZlibReturn zsc_uncompress_frame_init(zsc_frame *frame, U8 *work,
+        U32 work_len, I32 window_bits)
+{
+    ZSC_ASSERT(frame != Z_NULL);
+    ZSC_ASSERT(work != Z_NULL);
+
+    zmemzero((U8*)frame, sizeof(*frame));
+    U32 min_work_buf_size = U32_MAX;
+    ZlibReturn err = zsc_uncompress_frame_get_min_work_buf_size2(window_bits,
+            &min_work_buf_size);
+    if (err != Z_OK) {
+        return err;
+    }
+    if (work_len < min_work_buf_size) {
+        ZSC_WARN2("In zsc_uncompress_frame_init(), work buffer (%u B) "
+                "is smaller than required (%u B).",
+                work_len, min_work_buf_size);
+        return Z_MEM_ERROR;
+    }
+    frame->ref = work;
+    frame->ref_len = 0;
+    frame->ref_max = 1U << window_bits;
+    frame->work = work + frame->ref_max;
+    frame->work_len = work_len - frame->ref_max;
+    frame->window_bits = window_bits;
+    return Z_OK;
+}
+
+ZlibReturn zsc_uncompress_frame(zsc_frame *frame,
+        U8 *dest, U32 *dest_len, const U8 *source, U32 *source_len)
+{
+    ZSC_ASSERT(frame != Z_NULL);
+    ZSC_ASSERT(frame->ref != Z_NULL);
+    ZSC_ASSERT(dest != Z_NULL);
+    ZSC_ASSERT(dest_len != Z_NULL);
+    ZSC_ASSERT(source != Z_NULL);
+    ZSC_ASSERT(source_len != Z_NULL);
+
+    U32 dest_len_in = *dest_len;
+    U32 source_len_in = *source_len;
+    *dest_len = 0;
+
+    z_stream stream;
+    zmemzero((U8*)&stream, sizeof(stream));
+    stream.next_work = frame->work;
+    stream.avail_work = frame->work_len;
+    stream.next_in = source;
+    stream.avail_in = source_len_in;
+    stream.next_out = dest;
+    stream.avail_out = dest_len_in;
+    *source_len = 0;
+
+    ZlibReturn err = inflateInit2(&stream, frame->window_bits);
+    if (err != Z_OK) {
+        ZSC_WARN1("In zsc_uncompress_frame(), could not inflateInit, "
+                "error %d.", err);
+        frame->ref_len = 0;
+        return err;
+    }
+
+    // with Z_FINISH, inflate() runs until done or out of space
+    err = inflate(&stream, Z_FINISH);
+    U32 keyframe = (err != Z_NEED_DICT);
+    if (err == Z_NEED_DICT) {
+        if (frame->ref_len == 0) {
+            ZSC_WARN("In zsc_uncompress_frame(), frame needs a reference, "
+                    "none held. Waiting for a keyframe.");
+            err = Z_DATA_ERROR;
+        } else {
+            // fails if the frame was made against some other reference
+            err = inflateSetDictionary(&stream, frame->ref, frame->ref_len);
+            if (err == Z_OK) {
+                err = inflate(&stream, Z_FINISH);
+            } else {
+                ZSC_WARN("In zsc_uncompress_frame(), frame was compressed "
+                        "against a different reference.");
+            }
+        }
+    }
+    *dest_len = stream.total_out;
+    // inflate() leaves total_in short by the header when it asks for
+    // the dictionary, so count what is left instead
+    *source_len = source_len_in - stream.avail_in;
+    (void)inflateEnd(&stream);
+
+    if (err != Z_STREAM_END) {
+        ZSC_WARN1("In zsc_uncompress_frame(), inflate ended with error %d.",
+                err);
+        // the sender will refer to this frame, which is lost
+        frame->ref_len = 0;
+        return (err == Z_NEED_DICT || err == Z_OK) ? Z_DATA_ERROR : err;
+    }
 
+    // the tail of this frame is the reference for the next
+    frame->ref_len = ZMIN(stream.total_out, frame->ref_max);
+    zmemcpy(frame->ref, dest + (stream.total_out - frame->ref_len),
+            frame->ref_len);
+    if (keyframe) {
+        frame->frames = 0;
+    }
+    frame->frames++;
+    return Z_OK;
+}
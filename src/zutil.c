@@ -156,4 +156,22 @@ const U8 * zError(err)
 
 // Abcouwer ZSC - removed solo memcpy and related functions
 
+// write a little-endian U32
+void zsc_put_u32_le(U8 *buf, U32 val)
+{
+    ZSC_ASSERT(buf != Z_NULL);
+    buf[0] = (U8)(val & 0xff);
+    buf[1] = (U8)((val >> 8) & 0xff);
+    buf[2] = (U8)((val >> 16) & 0xff);
+    buf[3] = (U8)((val >> 24) & 0xff);
+}
+
+// read a little-endian U32
+U32 zsc_get_u32_le(const U8 *buf)
+{
+    ZSC_ASSERT(buf != Z_NULL);
+    return (U32)buf[0] | ((U32)buf[1] << 8)
+            | ((U32)buf[2] << 16) | ((U32)buf[3] << 24);
+}
+
 // Abcouwer ZSC - removed dynamic memory allocation functions
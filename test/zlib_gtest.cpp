@@ -1321,6 +1321,447 @@ TEST_F(ZlibTest, TinyOutputInflateBlock) {
     zlib_test_alice(WRAP_GZIP_BUFFERS, SCENARIO_TINY | SCENARIO_INFLATE_BLOCK);
 }
 
+TEST_F(ZlibTest, SmallOutputChunks) {
+    printf("test inflating into small output chunks\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    int source_buf_len = CORPUS_MAX_SIZE;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_TRUE(nread <= source_buf_len);
+    source_buf_len = nread;
+
+    ZlibReturn err;
+    int max_block_size = 1000000;
+
+    U32 compressed_buf_len;
+    err = zsc_compress_get_max_output_size(source_buf_len, max_block_size,
+            Z_DEFAULT_COMPRESSION, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+
+    U32 c_work_buf_len;
+    err = zsc_compress_get_min_work_buf_size(&c_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_buf_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+
+    U32 uc_work_buf_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_buf_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+
+    err = zsc_compress(compressed_buf, &compressed_buf_len,
+            source_buf, source_buf_len, max_block_size,
+            c_work_buf, c_work_buf_len, Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_OK);
+
+    // sizes below, at, and above the longest match
+    U32 chunks[6] = {1, 7, 128, 200, 258, 1000};
+    for (int i = 0; i < 6; i++) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        stream.next_work = uc_work_buf;
+        stream.avail_work = uc_work_buf_len;
+        err = inflateInit(&stream);
+        EXPECT_EQ(err, Z_OK);
+
+        stream.next_in = compressed_buf;
+        stream.avail_in = compressed_buf_len;
+        U32 total = 0;
+        while (err == Z_OK && total < (U32)source_buf_len) {
+            stream.next_out = uncompressed_buf + total;
+            stream.avail_out = (U32)source_buf_len - total;
+            if (stream.avail_out > chunks[i]) {
+                stream.avail_out = chunks[i];
+            }
+            U32 avail_out = stream.avail_out;
+            err = inflate(&stream, Z_NO_FLUSH);
+            total += avail_out - stream.avail_out;
+        }
+        EXPECT_EQ(err, Z_STREAM_END);
+        EXPECT_EQ(total, (U32)source_buf_len);
+        EXPECT_EQ(memcmp(uncompressed_buf, source_buf, source_buf_len), 0);
+        err = inflateEnd(&stream);
+        EXPECT_EQ(err, Z_OK);
+    }
+
+    free(source_buf);
+    free(compressed_buf);
+    free(uncompressed_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+}
+
+TEST_F(ZlibTest, CopyTo) {
+    printf("test forking primed streams with deflateCopyTo/inflateCopyTo\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    int source_buf_len = CORPUS_MAX_SIZE;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_TRUE(nread <= source_buf_len);
+    source_buf_len = nread;
+
+    ZlibReturn err;
+    const int NUM_FORKS = 2;
+    const U32 prefix_len = 100000;
+    const U32 suffix_len = 20000;
+    const U8 * suffixes[NUM_FORKS] = {source_buf + prefix_len,
+            source_buf + prefix_len + suffix_len};
+    const U32 dict_len = strlen((const char *)alice_dictionary);
+
+    U32 c_work_len;
+    err = deflateWorkSize(&c_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U32 uc_work_len;
+    err = inflateWorkSize(&uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U32 out_len = 2 * (prefix_len + suffix_len);
+
+    U8 * c_work_bufs[NUM_FORKS];
+    U8 * uc_work_bufs[NUM_FORKS];
+    U8 * compressed_bufs[NUM_FORKS];
+    U8 * uncompressed_bufs[NUM_FORKS];
+    for (int i = 0; i < NUM_FORKS; i++) {
+        c_work_bufs[i] = (U8 *) malloc(c_work_len);
+        uc_work_bufs[i] = (U8 *) malloc(uc_work_len);
+        compressed_bufs[i] = (U8 *) malloc(out_len);
+        uncompressed_bufs[i] = (U8 *) malloc(out_len);
+        ASSERT_NE(c_work_bufs[i], (U8*)NULL);
+        ASSERT_NE(uc_work_bufs[i], (U8*)NULL);
+        ASSERT_NE(compressed_bufs[i], (U8*)NULL);
+        ASSERT_NE(uncompressed_bufs[i], (U8*)NULL);
+    }
+
+    printf("prime a deflate stream with a dictionary and prefix, then fork\n");
+    z_stream c_strms[NUM_FORKS];
+    memset(c_strms, 0, sizeof(c_strms));
+    c_strms[0].next_work = c_work_bufs[0];
+    c_strms[0].avail_work = c_work_len;
+    err = deflateInit(&c_strms[0], Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_OK);
+    err = deflateSetDictionary(&c_strms[0], alice_dictionary, dict_len);
+    EXPECT_EQ(err, Z_OK);
+    c_strms[0].next_in = source_buf;
+    c_strms[0].avail_in = prefix_len;
+    c_strms[0].next_out = compressed_bufs[0];
+    c_strms[0].avail_out = out_len;
+    err = deflate(&c_strms[0], Z_NO_FLUSH);
+    EXPECT_EQ(err, Z_OK);
+    U32 shared_out = c_strms[0].total_out;
+    EXPECT_GT(shared_out, 6U); // at least one block past the header
+
+    c_strms[1].next_work = c_work_bufs[1];
+    c_strms[1].avail_work = c_work_len - 1;
+    err = deflateCopyTo(&c_strms[1], &c_strms[0]);
+    EXPECT_EQ(err, Z_STREAM_ERROR); // too small
+    c_strms[1].avail_work = c_work_len;
+    err = deflateCopyTo(&c_strms[1], &c_strms[0]);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(c_strms[1].next_work, c_work_bufs[1] + c_work_len
+            - c_strms[1].avail_work);
+    memcpy(compressed_bufs[1], compressed_bufs[0], shared_out);
+    c_strms[1].next_out = compressed_bufs[1] + shared_out;
+
+    U32 compressed_lens[NUM_FORKS];
+    for (int i = 0; i < NUM_FORKS; i++) {
+        c_strms[i].next_in = suffixes[i];
+        c_strms[i].avail_in = suffix_len;
+        err = deflate(&c_strms[i], Z_FINISH);
+        EXPECT_EQ(err, Z_STREAM_END);
+        compressed_lens[i] = c_strms[i].total_out;
+        err = deflateEnd(&c_strms[i]);
+        EXPECT_EQ(err, Z_OK);
+    }
+    EXPECT_EQ(memcmp(compressed_bufs[0], compressed_bufs[1], shared_out), 0);
+
+    printf("inflate the shared part once, then fork\n");
+    z_stream d_strms[NUM_FORKS];
+    memset(d_strms, 0, sizeof(d_strms));
+    d_strms[0].next_work = uc_work_bufs[0];
+    d_strms[0].avail_work = uc_work_len;
+    err = inflateInit(&d_strms[0]);
+    EXPECT_EQ(err, Z_OK);
+    d_strms[0].next_in = compressed_bufs[0];
+    d_strms[0].avail_in = shared_out;
+    d_strms[0].next_out = uncompressed_bufs[0];
+    d_strms[0].avail_out = out_len;
+    err = inflate(&d_strms[0], Z_NO_FLUSH);
+    EXPECT_EQ(err, Z_NEED_DICT);
+    err = inflateSetDictionary(&d_strms[0], alice_dictionary, dict_len);
+    EXPECT_EQ(err, Z_OK);
+    err = inflate(&d_strms[0], Z_NO_FLUSH);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(d_strms[0].avail_in, 0U);
+    U32 shared_uc = d_strms[0].total_out;
+
+    d_strms[1].next_work = uc_work_bufs[1];
+    d_strms[1].avail_work = uc_work_len;
+    err = inflateCopyTo(&d_strms[1], &d_strms[0]);
+    EXPECT_EQ(err, Z_OK);
+    memcpy(uncompressed_bufs[1], uncompressed_bufs[0], shared_uc);
+    d_strms[1].next_out = uncompressed_bufs[1] + shared_uc;
+
+    for (int i = 0; i < NUM_FORKS; i++) {
+        d_strms[i].next_in = compressed_bufs[i] + shared_out;
+        d_strms[i].avail_in = compressed_lens[i] - shared_out;
+        err = inflate(&d_strms[i], Z_FINISH);
+        EXPECT_EQ(err, Z_STREAM_END);
+        EXPECT_EQ(d_strms[i].total_out, prefix_len + suffix_len);
+        EXPECT_EQ(memcmp(uncompressed_bufs[i], source_buf, prefix_len), 0);
+        EXPECT_EQ(memcmp(uncompressed_bufs[i] + prefix_len, suffixes[i],
+                suffix_len), 0);
+        err = inflateEnd(&d_strms[i]);
+        EXPECT_EQ(err, Z_OK);
+    }
+
+    printf("bad arguments\n");
+    err = deflateCopyTo(&c_strms[1], &c_strms[0]); // ended source
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    err = inflateCopyTo(&d_strms[1], &d_strms[0]); // ended source
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    err = deflateCopyTo(Z_NULL, &c_strms[0]);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    err = inflateCopyTo(Z_NULL, &d_strms[0]);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+
+    free(source_buf);
+    for (int i = 0; i < NUM_FORKS; i++) {
+        free(c_work_bufs[i]);
+        free(uc_work_bufs[i]);
+        free(compressed_bufs[i]);
+        free(uncompressed_bufs[i]);
+    }
+}
+
+// overwrite a state field in a saved image and fix up its CRC,
+// so only the loader's range checks can catch it
+void image_set_field(U8 *image, U32 image_len, U32 offset, I32 value)
+{
+    memcpy(image + 11 * 4 + offset, &value, sizeof(value)); // past header
+    U32 crc = crc32(0L, image, image_len - 4);
+    for (int i = 0; i < 4; i++) {
+        image[image_len - 4 + i] = (U8)(crc >> (8 * i));
+    }
+}
+
+TEST_F(ZlibTest, SaveLoadState) {
+    printf("test checkpoint and resume with deflate/inflate Save/LoadState\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    int source_buf_len = CORPUS_MAX_SIZE;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_TRUE(nread <= source_buf_len);
+    source_buf_len = nread;
+
+    ZlibReturn err;
+    const U32 in_chunk = 1000;
+    const U32 out_chunk = 97; // small, so output is pending at the save
+    U32 out_len = source_buf_len * 2;
+
+    U32 c_work_len;
+    err = deflateWorkSize(&c_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U32 uc_work_len;
+    err = inflateWorkSize(&uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U32 image_bound;
+    err = deflateStateImageBound(DEF_WBITS, DEF_MEM_LEVEL, &image_bound);
+    EXPECT_EQ(err, Z_OK);
+    U32 i_image_bound;
+    err = inflateStateImageBound(DEF_WBITS, &i_image_bound);
+    EXPECT_EQ(err, Z_OK);
+
+    U8 * work_a = (U8 *) malloc(c_work_len);
+    U8 * work_b = (U8 *) malloc(c_work_len);
+    U8 * image = (U8 *) malloc(image_bound);
+    U8 * compressed_buf = (U8 *) malloc(out_len);
+    U8 * resumed_buf = (U8 *) malloc(out_len);
+    ASSERT_NE(work_a, (U8*)NULL);
+    ASSERT_NE(work_b, (U8*)NULL);
+    ASSERT_NE(image, (U8*)NULL);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    ASSERT_NE(resumed_buf, (U8*)NULL);
+
+    printf("deflate, saving partway\n");
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    strm.next_work = work_a;
+    strm.avail_work = c_work_len;
+    err = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_OK);
+    strm.next_in = source_buf;
+    strm.next_out = compressed_buf;
+    U32 image_len = 0;
+    U32 calls = 0;
+    err = Z_OK;
+    while (err == Z_OK) {
+        strm.avail_in = ZMIN(in_chunk, source_buf_len - strm.total_in);
+        strm.avail_out = out_chunk;
+        ZlibFlush flush = (strm.total_in + strm.avail_in
+                == (U32)source_buf_len) ? Z_FINISH : Z_NO_FLUSH;
+        err = deflate(&strm, flush);
+        if (++calls == 300) {
+            image_len = 10;
+            EXPECT_EQ(deflateSaveState(&strm, image, &image_len),
+                    Z_BUF_ERROR);
+            EXPECT_GT(image_len, 10U);
+            EXPECT_LE(image_len, image_bound);
+            image_len = image_bound;
+            EXPECT_EQ(deflateSaveState(&strm, image, &image_len), Z_OK);
+            EXPECT_NE(strm.state->pending, 0U);
+            EXPECT_LT(image_len, c_work_len); // compact
+        }
+    }
+    EXPECT_EQ(err, Z_STREAM_END);
+    U32 compressed_len = strm.total_out;
+    EXPECT_EQ(deflateEnd(&strm), Z_OK);
+
+    printf("resume into another work buffer and match the output\n");
+    memset(work_b, 0xa5, c_work_len);
+    memset(&strm, 0x5a, sizeof(strm));
+    strm.next_work = work_b;
+    strm.avail_work = c_work_len;
+    err = deflateLoadState(&strm, image, image_len);
+    EXPECT_EQ(err, Z_OK);
+    U32 resume_out = strm.total_out;
+    strm.next_in = source_buf + strm.total_in;
+    strm.next_out = resumed_buf + resume_out;
+    while (err == Z_OK) {
+        strm.avail_in = ZMIN(in_chunk, source_buf_len - strm.total_in);
+        strm.avail_out = out_chunk;
+        ZlibFlush flush = (strm.total_in + strm.avail_in
+                == (U32)source_buf_len) ? Z_FINISH : Z_NO_FLUSH;
+        err = deflate(&strm, flush);
+    }
+    EXPECT_EQ(err, Z_STREAM_END);
+    EXPECT_EQ(strm.total_out, compressed_len);
+    EXPECT_EQ(memcmp(resumed_buf + resume_out, compressed_buf + resume_out,
+            compressed_len - resume_out), 0);
+    EXPECT_EQ(deflateEnd(&strm), Z_OK);
+
+    printf("out of range fields are rejected, with the work buffer kept\n");
+    U8 * good_image = (U8 *) malloc(image_len);
+    ASSERT_NE(good_image, (U8*)NULL);
+    memcpy(good_image, image, image_len);
+    const U32 bad_offsets[] = {
+        offsetof(deflate_state, level), offsetof(deflate_state, level),
+        offsetof(deflate_state, strategy), offsetof(deflate_state, insert),
+        offsetof(deflate_state, block_start),
+        offsetof(deflate_state, bi_valid), offsetof(deflate_state, ins_h),
+    };
+    const I32 bad_values[] = { -1, 10, Z_FIXED + 1, 0x7fffffff,
+            0x7fffffff, 17, 0x7fffffff };
+    for (U32 i = 0; i < sizeof(bad_values) / sizeof(bad_values[0]); i++) {
+        memcpy(image, good_image, image_len);
+        image_set_field(image, image_len, bad_offsets[i], bad_values[i]);
+        strm.next_work = work_b;
+        strm.avail_work = c_work_len;
+        EXPECT_EQ(deflateLoadState(&strm, image, image_len), Z_DATA_ERROR);
+        EXPECT_EQ(strm.next_work, work_b);
+        EXPECT_EQ(strm.avail_work, c_work_len);
+    }
+    free(good_image);
+
+    printf("inflate, saving partway, and resume\n");
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    memset(&strm, 0, sizeof(strm));
+    strm.next_work = work_a;
+    strm.avail_work = uc_work_len;
+    err = inflateInit(&strm);
+    EXPECT_EQ(err, Z_OK);
+    strm.next_in = compressed_buf;
+    strm.next_out = uncompressed_buf;
+    calls = 0;
+    while (err == Z_OK && calls < 200) {
+        strm.avail_in = ZMIN(out_chunk, compressed_len - strm.total_in);
+        strm.avail_out = in_chunk;
+        err = inflate(&strm, Z_NO_FLUSH);
+        calls++;
+    }
+    EXPECT_EQ(err, Z_OK);
+    image_len = i_image_bound;
+    EXPECT_EQ(inflateSaveState(&strm, image, &image_len), Z_OK);
+    EXPECT_LE(image_len, i_image_bound);
+    EXPECT_EQ(inflateEnd(&strm), Z_OK);
+
+    memset(work_b, 0xa5, uc_work_len);
+    memset(&strm, 0x5a, sizeof(strm));
+    strm.next_work = work_b;
+    strm.avail_work = uc_work_len;
+    err = inflateLoadState(&strm, image, image_len);
+    EXPECT_EQ(err, Z_OK);
+    strm.next_in = compressed_buf + strm.total_in;
+    strm.avail_in = compressed_len - strm.total_in;
+    strm.next_out = uncompressed_buf + strm.total_out;
+    strm.avail_out = source_buf_len - strm.total_out;
+    err = inflate(&strm, Z_FINISH);
+    EXPECT_EQ(err, Z_STREAM_END);
+    EXPECT_EQ(strm.total_out, (U32)source_buf_len);
+    EXPECT_EQ(memcmp(uncompressed_buf, source_buf, source_buf_len), 0);
+    EXPECT_EQ(inflateEnd(&strm), Z_OK);
+
+    printf("corrupt or truncated images are rejected\n");
+    strm.next_work = work_b;
+    strm.avail_work = uc_work_len;
+    image[image_len / 2] ^= 1;
+    EXPECT_EQ(inflateLoadState(&strm, image, image_len), Z_DATA_ERROR);
+    image[image_len / 2] ^= 1;
+    EXPECT_EQ(inflateLoadState(&strm, image, image_len - 1), Z_DATA_ERROR);
+    good_image = (U8 *) malloc(image_len);
+    ASSERT_NE(good_image, (U8*)NULL);
+    memcpy(good_image, image, image_len);
+    const U32 i_bad_offsets[] = {
+        offsetof(inflate_state, mode), offsetof(inflate_state, mode),
+        offsetof(inflate_state, bits), offsetof(inflate_state, ndist),
+    };
+    const I32 i_bad_values[] = { HEAD - 1, SYNC + 1, 33, 33 };
+    for (U32 i = 0; i < sizeof(i_bad_values) / sizeof(i_bad_values[0]); i++) {
+        memcpy(image, good_image, image_len);
+        image_set_field(image, image_len, i_bad_offsets[i], i_bad_values[i]);
+        strm.next_work = work_b;
+        strm.avail_work = uc_work_len;
+        EXPECT_EQ(inflateLoadState(&strm, image, image_len), Z_DATA_ERROR);
+        EXPECT_EQ(strm.next_work, work_b);
+        EXPECT_EQ(strm.avail_work, uc_work_len);
+    }
+    memcpy(image, good_image, image_len);
+    free(good_image);
+    EXPECT_EQ(deflateLoadState(&strm, image, image_len), Z_DATA_ERROR);
+    strm.avail_work = uc_work_len / 2;
+    EXPECT_EQ(inflateLoadState(&strm, image, image_len), Z_STREAM_ERROR);
+    EXPECT_EQ(strm.next_work, work_b); // untouched on failure
+    EXPECT_EQ(inflateLoadState(Z_NULL, image, image_len), Z_STREAM_ERROR);
+    EXPECT_EQ(deflateSaveState(Z_NULL, image, &image_len), Z_STREAM_ERROR);
+
+    free(source_buf);
+    free(work_a);
+    free(work_b);
+    free(image);
+    free(compressed_buf);
+    free(resumed_buf);
+    free(uncompressed_buf);
+}
+
 TEST_F(ZlibTest, DictionaryWouldFillWindow) {
     zlib_test_alice(WRAP_ZLIB,
             SCENARIO_BIG_DICTIONARY | SCENARIO_TINY);
@@ -1510,105 +1951,2500 @@ TEST_F(ZlibTest, ZSCCompressErrors) {
     free(work_buf);
 }
 
-TEST_F(ZlibTest, ZSCUncompressErrors) {
-    printf("test errors in zsc_uncompress\n");
-
+TEST_F(ZlibTest, ZSCCompressRace) {
+    printf("test zsc_compress_race picks the best entry per block\n");
 
     FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
     ASSERT_FALSE(file == NULL);
 
-    int source_buf_len = CORPUS_MAX_SIZE;
+    // mixed data: text, runs, and small noise, so no one strategy wins
+    const int part_len = 40000;
+    int source_buf_len = 3 * part_len;
     U8 * source_buf = (U8 *) malloc(source_buf_len);
-    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    int nread = fread(source_buf, 1, part_len, file);
     ASSERT_FALSE(ferror(file));
     fclose(file);
-    ASSERT_TRUE(nread <= source_buf_len);
-    source_buf_len = nread;
+    ASSERT_EQ(nread, part_len);
+    srand(88);
+    for (int i = 0; i < part_len; i++) {
+        source_buf[part_len + i] = (U8)((i / 37) % 4);
+        source_buf[2 * part_len + i] = (U8)(rand() % 5);
+    }
 
     ZlibReturn err;
+    int max_block_size = 20000;
+    int window_bits = DEF_WBITS;
+    int mem_level = DEF_MEM_LEVEL;
+    const zsc_race_entry entries[4] = {
+            {Z_DEFAULT_COMPRESSION, Z_DEFAULT_STRATEGY},
+            {Z_DEFAULT_COMPRESSION, Z_FILTERED},
+            {Z_DEFAULT_COMPRESSION, Z_RLE},
+            {Z_DEFAULT_COMPRESSION, Z_HUFFMAN_ONLY}};
 
     U32 compressed_buf_len;
-    U8 * compressed_buf;
-    U32 work_buf_len;
-    U8 * work_buf;
-    U32 compressed_buf_len_out;
-    int max_block_size = 10000;
-
-    int level = Z_DEFAULT_COMPRESSION;
-
     err = zsc_compress_get_max_output_size(source_buf_len, max_block_size,
-            level, &compressed_buf_len);
+            Z_NO_COMPRESSION, &compressed_buf_len);
     EXPECT_EQ(err, Z_OK);
-    compressed_buf = (U8 *) malloc(compressed_buf_len);
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
     ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
 
-
-    err = zsc_compress_get_min_work_buf_size(&work_buf_len);
+    U32 work_buf_len;
+    err = zsc_compress_race_get_min_work_buf_size(max_block_size,
+            window_bits, mem_level, &work_buf_len);
     EXPECT_EQ(err, Z_OK);
-    work_buf = (U8 *) malloc(work_buf_len);
+    U32 single_work_len;
+    err = zsc_compress_get_min_work_buf_size(&single_work_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_GT(work_buf_len, 3 * single_work_len);
+    U32 gzip_work_buf_len;
+    err = zsc_compress_race_get_min_work_buf_size(max_block_size,
+            DEF_WBITS + GZIP_CODE, mem_level, &gzip_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_GT(gzip_work_buf_len, work_buf_len); // room for gzip header
+    U8 * work_buf = (U8 *) malloc(gzip_work_buf_len);
     ASSERT_NE(work_buf, (U8*)NULL);
-    compressed_buf_len_out = compressed_buf_len;
 
-    err = zsc_compress(compressed_buf, &compressed_buf_len_out,
-            source_buf, source_buf_len,  max_block_size,
-            work_buf, work_buf_len, level);
+    // race, with default and explicit entries
+    U32 race_len = compressed_buf_len;
+    err = zsc_compress_race(compressed_buf, &race_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            window_bits, mem_level, Z_NULL, 0);
     EXPECT_EQ(err, Z_OK);
+    U32 race_len2 = compressed_buf_len;
+    err = zsc_compress_race(compressed_buf, &race_len2, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            window_bits, mem_level, entries, 4);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(race_len, race_len2);
 
-    free(work_buf);
-    free(source_buf);
-
-    U32 uncompressed_buf_len = source_buf_len;
-    U8 * uncompressed_buf = (U8 *) malloc(uncompressed_buf_len);
-    EXPECT_NE(uncompressed_buf, (U8 * )NULL);
-    err = zsc_uncompress_get_min_work_buf_size(&work_buf_len);
+    U32 uncompressed_len = source_buf_len;
+    U32 source_len = race_len;
+    U32 uc_work_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_len);
     EXPECT_EQ(err, Z_OK);
-    work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_LE(uc_work_len, work_buf_len);
+    err = zsc_uncompress(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(uncompressed_len, (U32)source_buf_len);
+    EXPECT_EQ(memcmp(uncompressed_buf, source_buf, source_buf_len), 0);
+
+    // never worse than racing any single entry alone, better than each here
+    for (int i = 0; i < 4; i++) {
+        U32 single_len = compressed_buf_len;
+        err = zsc_compress_race(compressed_buf, &single_len, source_buf,
+                source_buf_len, max_block_size, work_buf, work_buf_len,
+                window_bits, mem_level, &entries[i], 1);
+        EXPECT_EQ(err, Z_OK);
+        printf("strategy %d: %u bytes, race: %u bytes\n",
+                entries[i].strategy, single_len, race_len);
+        EXPECT_LT(race_len, single_len);
+    }
 
-    U32 compressed_buf_len_out2;
-    U32 uncompressed_buf_len_out;
+    printf("bound holds with small blocks\n");
+    for (int block_size = 1000; block_size < max_block_size;
+            block_size *= 3) {
+        U32 small_len = compressed_buf_len;
+        err = zsc_compress_race(compressed_buf, &small_len, source_buf,
+                source_buf_len, block_size, work_buf, work_buf_len,
+                window_bits, mem_level, entries, 4);
+        EXPECT_EQ(err, Z_OK);
+        for (int i = 0; i < 4; i++) {
+            U32 single_len = compressed_buf_len;
+            err = zsc_compress_race(compressed_buf, &single_len, source_buf,
+                    source_buf_len, block_size, work_buf, work_buf_len,
+                    window_bits, mem_level, &entries[i], 1);
+            EXPECT_EQ(err, Z_OK);
+            EXPECT_LE(small_len, single_len)
+                    << "block " << block_size << " entry " << i;
+        }
+    }
 
-    printf("work buf size = 0\n");
-    compressed_buf_len_out2 = compressed_buf_len_out;
-    uncompressed_buf_len_out = uncompressed_buf_len;
-    err = zsc_uncompress(uncompressed_buf, &uncompressed_buf_len_out,
-                            compressed_buf, &compressed_buf_len_out2,
-                            work_buf, 0);
-    EXPECT_EQ(err, Z_MEM_ERROR);
-    printf("zError:%s\n", zError(err));
+    printf("gzip and raw wrappers round trip\n");
+    for (int wb = 0; wb < 2; wb++) {
+        int bits = (wb == 0) ? DEF_WBITS + GZIP_CODE : -DEF_WBITS;
+        race_len = compressed_buf_len;
+        err = zsc_compress_race(compressed_buf, &race_len, source_buf,
+                source_buf_len, max_block_size, work_buf, gzip_work_buf_len,
+                bits, mem_level, Z_NULL, 0);
+        EXPECT_EQ(err, Z_OK);
+        uncompressed_len = source_buf_len;
+        source_len = race_len;
+        err = zsc_uncompress2(uncompressed_buf, &uncompressed_len,
+                compressed_buf, &source_len, work_buf, work_buf_len, bits);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(memcmp(uncompressed_buf, source_buf, source_buf_len), 0);
+    }
 
-    printf("bad window bits arg\n");
-    compressed_buf_len_out2 = compressed_buf_len_out;
-    uncompressed_buf_len_out = uncompressed_buf_len;
-    err = zsc_uncompress2(uncompressed_buf, &uncompressed_buf_len_out,
-                            compressed_buf, &compressed_buf_len_out2,
-                            work_buf, work_buf_len, 500);
+    printf("bad arguments\n");
+    race_len = compressed_buf_len;
+    err = zsc_compress_race(compressed_buf, &race_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len - 1,
+            window_bits, mem_level, Z_NULL, 0);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+    err = zsc_compress_race(compressed_buf, &race_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            window_bits, mem_level, entries, 0);
     EXPECT_EQ(err, Z_STREAM_ERROR);
-    printf("zError:%s\n", zError(err));
-
-    printf("output buf size small\n");
-    compressed_buf_len_out2 = compressed_buf_len_out;
-    uncompressed_buf_len_out = 42;
-    err = zsc_uncompress(uncompressed_buf, &uncompressed_buf_len_out,
-                            compressed_buf, &compressed_buf_len_out2,
-                            work_buf, work_buf_len);
+    const zsc_race_entry bad_entry = {10, Z_DEFAULT_STRATEGY};
+    err = zsc_compress_race(compressed_buf, &race_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            window_bits, mem_level, &bad_entry, 1);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    race_len = 100;
+    err = zsc_compress_race(compressed_buf, &race_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            window_bits, mem_level, Z_NULL, 0);
     EXPECT_EQ(err, Z_BUF_ERROR);
-    printf("zError:%s\n", zError(err));
 
-    printf("gzip header when not gzip\n");
-    gz_header header;
-    memset(&header, 0, sizeof(header));
-    compressed_buf_len_out2 = compressed_buf_len_out;
-    uncompressed_buf_len_out = uncompressed_buf_len;
-    err = zsc_uncompress_gzip2(uncompressed_buf, &uncompressed_buf_len_out,
-                            compressed_buf, &compressed_buf_len_out2,
-                            work_buf, work_buf_len, DEF_WBITS, &header);
+    free(source_buf);
+    free(compressed_buf);
+    free(uncompressed_buf);
+    free(work_buf);
+}
+
+TEST_F(ZlibTest, ZSCCompressVerify) {
+    printf("test zsc_compress_verify checks output as it is produced\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+    int source_buf_len = 100000;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_EQ(nread, source_buf_len);
+
+    ZlibReturn err;
+    int max_block_size = 10000;
+    U32 compressed_buf_len;
+    err = zsc_compress_get_max_output_size(source_buf_len, max_block_size,
+            Z_NO_COMPRESSION, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * plain_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(plain_buf, (U8*)NULL);
+
+    U32 work_buf_len;
+    err = zsc_compress_verify_get_min_work_buf_size2(DEF_WBITS + GZIP_CODE,
+            DEF_MEM_LEVEL, &work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U32 single_work_len;
+    err = zsc_compress_get_min_work_buf_size(&single_work_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_GT(work_buf_len, single_work_len);
+    U8 * work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+
+    // same output as without verification, for each wrapper
+    for (int wb = 0; wb < 3; wb++) {
+        int bits = (wb == 0) ? DEF_WBITS
+                : (wb == 1) ? DEF_WBITS + GZIP_CODE : -DEF_WBITS;
+        U32 bad_block = 0;
+        U32 verify_len = compressed_buf_len;
+        err = zsc_compress_verify2(compressed_buf, &verify_len, source_buf,
+                source_buf_len, max_block_size, work_buf, work_buf_len,
+                Z_DEFAULT_COMPRESSION, bits, DEF_MEM_LEVEL,
+                Z_DEFAULT_STRATEGY, Z_NULL, &bad_block);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(bad_block, U32_MAX);
+        U32 plain_len = compressed_buf_len;
+        err = zsc_compress2(plain_buf, &plain_len, source_buf,
+                source_buf_len, max_block_size, work_buf, work_buf_len,
+                Z_DEFAULT_COMPRESSION, bits, DEF_MEM_LEVEL,
+                Z_DEFAULT_STRATEGY);
+        EXPECT_EQ(err, Z_OK);
+        ASSERT_EQ(verify_len, plain_len);
+        EXPECT_EQ(memcmp(compressed_buf, plain_buf, plain_len), 0);
+    }
+
+    // default settings, and the smallest zlib window
+    U32 bad_block = 0;
+    U32 verify_len = compressed_buf_len;
+    err = zsc_compress_verify(compressed_buf, &verify_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_BEST_COMPRESSION, &bad_block);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(bad_block, U32_MAX);
+    verify_len = compressed_buf_len;
+    err = zsc_compress_verify2(compressed_buf, &verify_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, 8, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY,
+            Z_NULL, &bad_block);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(bad_block, U32_MAX);
+
+    printf("bad arguments\n");
+    U32 default_work_len;
+    err = zsc_compress_verify_get_min_work_buf_size2(DEF_WBITS,
+            DEF_MEM_LEVEL, &default_work_len);
+    EXPECT_EQ(err, Z_OK);
+    verify_len = compressed_buf_len;
+    err = zsc_compress_verify(compressed_buf, &verify_len, source_buf,
+            source_buf_len, max_block_size, work_buf, default_work_len - 1,
+            Z_DEFAULT_COMPRESSION, &bad_block);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+    err = zsc_compress_verify_get_min_work_buf_size2(7, DEF_MEM_LEVEL,
+            &default_work_len);
     EXPECT_EQ(err, Z_STREAM_ERROR);
-    printf("zError:%s\n", zError(err));
+    verify_len = 100;
+    err = zsc_compress_verify(compressed_buf, &verify_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &bad_block);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    EXPECT_EQ(bad_block, U32_MAX);
 
+    free(source_buf);
     free(compressed_buf);
-    free(uncompressed_buf);
+    free(plain_buf);
     free(work_buf);
+}
+
+TEST_F(ZlibTest, ZSCCompressFilter) {
+    printf("test filters ahead of zsc_compress\n");
+
+    // telemetry: 16 byte records of a counter, a slow ramp, and a float
+    const int record_len = 16;
+    const int num_records = 8192;
+    int source_buf_len = record_len * num_records;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    srand(91);
+    for (int r = 0; r < num_records; r++) {
+        U8 *rec = source_buf + r * record_len;
+        U32 counter = 100000 + r;
+        U32 ramp = 5000000 + r * 37 + (rand() % 4);
+        float sample = 20.0f + (float)(r % 500) * 0.01f;
+        U32 bits;
+        memcpy(&bits, &sample, sizeof(bits));
+        for (int b = 0; b < 4; b++) {
+            rec[b] = (U8)(counter >> (8 * b));
+            rec[4 + b] = (U8)(ramp >> (8 * b));
+            rec[8 + b] = (U8)(bits >> (8 * b));
+            rec[12 + b] = 0;
+        }
+    }
+
+    ZlibReturn err;
+    int max_block_size = 16384;
+    U32 compressed_buf_len;
+    err = zsc_compress_get_max_output_size(source_buf_len, max_block_size,
+            Z_NO_COMPRESSION, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    compressed_buf_len += ZSC_FILTER_HEADER_LEN;
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+
+    const zsc_filter filters[4] = {
+            {ZSC_FILTER_NONE, 0},
+            {ZSC_FILTER_DELTA, record_len},
+            {ZSC_FILTER_XOR, record_len},
+            {ZSC_FILTER_TRANSPOSE, record_len}};
+    U32 work_buf_len;
+    err = zsc_compress_filter_get_min_work_buf_size2(max_block_size,
+            DEF_WBITS + GZIP_CODE, DEF_MEM_LEVEL, &filters[1], &work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U32 uc_work_len;
+    err = zsc_uncompress_filter_get_min_work_buf_size2(max_block_size,
+            DEF_WBITS + GZIP_CODE, &filters[1], &uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    work_buf_len = ZMAX(work_buf_len, uc_work_len);
+    U8 * work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+
+    U32 plain_len = compressed_buf_len;
+    err = zsc_compress(compressed_buf, &plain_len, source_buf, source_buf_len,
+            max_block_size, work_buf, work_buf_len, Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_OK);
+
+    for (int f = 0; f < 4; f++) {
+        U32 filtered_len = compressed_buf_len;
+        err = zsc_compress_filter(compressed_buf, &filtered_len, source_buf,
+                source_buf_len, max_block_size, work_buf, work_buf_len,
+                Z_DEFAULT_COMPRESSION, &filters[f]);
+        EXPECT_EQ(err, Z_OK);
+        printf("filter %d: %u bytes, unfiltered: %u bytes\n",
+                filters[f].type, filtered_len, plain_len);
+        if (filters[f].type == ZSC_FILTER_NONE) {
+            EXPECT_EQ(filtered_len, plain_len + ZSC_FILTER_HEADER_LEN);
+        } else {
+            EXPECT_LT(filtered_len, plain_len);
+        }
+
+        U32 uncompressed_len = source_buf_len;
+        U32 source_len = filtered_len;
+        err = zsc_uncompress_filter(uncompressed_buf, &uncompressed_len,
+                compressed_buf, &source_len, work_buf, work_buf_len);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(source_len, filtered_len);
+        ASSERT_EQ(uncompressed_len, (U32)source_buf_len);
+        EXPECT_EQ(memcmp(uncompressed_buf, source_buf, source_buf_len), 0);
+    }
+
+    printf("gzip wrapper, odd length, and a corrupt block\n");
+    const zsc_filter delta = {ZSC_FILTER_DELTA, 4};
+    U32 odd_len = source_buf_len - 5;
+    U32 filtered_len = compressed_buf_len;
+    err = zsc_compress_filter2(compressed_buf, &filtered_len, source_buf,
+            odd_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, DEF_WBITS + GZIP_CODE, DEF_MEM_LEVEL,
+            Z_DEFAULT_STRATEGY, &delta);
+    EXPECT_EQ(err, Z_OK);
+    U32 uncompressed_len = source_buf_len;
+    U32 source_len = filtered_len;
+    err = zsc_uncompress_filter2(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len,
+            DEF_WBITS + GZIP_CODE);
+    EXPECT_EQ(err, Z_OK);
+    ASSERT_EQ(uncompressed_len, odd_len);
+    EXPECT_EQ(memcmp(uncompressed_buf, source_buf, odd_len), 0);
+
+    // corrupt the middle of the stream; later blocks still come back right
+    filtered_len = compressed_buf_len;
+    err = zsc_compress_filter(compressed_buf, &filtered_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &delta);
+    EXPECT_EQ(err, Z_OK);
+    // make the block after a middle flush point an invalid block type
+    U32 mark = filtered_len / 2;
+    while (mark + 4 < filtered_len && !(compressed_buf[mark] == 0
+            && compressed_buf[mark + 1] == 0
+            && compressed_buf[mark + 2] == 0xff
+            && compressed_buf[mark + 3] == 0xff)) {
+        mark++;
+    }
+    ASSERT_LT(mark + 4, filtered_len);
+    compressed_buf[mark + 4] |= 0x06;
+    uncompressed_len = source_buf_len;
+    source_len = filtered_len;
+    err = zsc_uncompress_filter(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+    EXPECT_EQ(uncompressed_len, (U32)(source_buf_len - max_block_size));
+    EXPECT_EQ(memcmp(uncompressed_buf, source_buf, max_block_size), 0);
+    EXPECT_EQ(memcmp(uncompressed_buf + uncompressed_len - max_block_size,
+            source_buf + source_buf_len - max_block_size, max_block_size), 0);
+
+    printf("bad arguments\n");
+    const zsc_filter bad_type = {(zsc_filter_type)9, 4};
+    const zsc_filter bad_width = {ZSC_FILTER_XOR, 0};
+    EXPECT_EQ(zsc_filter_check(&bad_type), Z_STREAM_ERROR);
+    EXPECT_EQ(zsc_filter_check(&bad_width), Z_STREAM_ERROR);
+    filtered_len = compressed_buf_len;
+    err = zsc_compress_filter(compressed_buf, &filtered_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &bad_width);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    U32 min_len;
+    err = zsc_compress_filter_get_min_work_buf_size2(max_block_size,
+            DEF_WBITS, DEF_MEM_LEVEL, &delta, &min_len);
+    EXPECT_EQ(err, Z_OK);
+    err = zsc_compress_filter(compressed_buf, &filtered_len, source_buf,
+            source_buf_len, max_block_size, work_buf, min_len - 1,
+            Z_DEFAULT_COMPRESSION, &delta);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+    filtered_len = 4;
+    err = zsc_compress_filter(compressed_buf, &filtered_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &delta);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    filtered_len = compressed_buf_len;
+    err = zsc_compress_filter(compressed_buf, &filtered_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &delta);
+    EXPECT_EQ(err, Z_OK);
+    uncompressed_len = source_buf_len - 1;
+    source_len = filtered_len;
+    err = zsc_uncompress_filter(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    uncompressed_len = source_buf_len;
+    source_len = filtered_len;
+    err = zsc_uncompress_filter(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, 1000);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+    compressed_buf[1] = 'X';
+    uncompressed_len = source_buf_len;
+    source_len = filtered_len;
+    err = zsc_uncompress_filter(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+    EXPECT_EQ(uncompressed_len, 0U);
+
+    free(source_buf);
+    free(compressed_buf);
+    free(uncompressed_buf);
+    free(work_buf);
+}
+
+TEST_F(ZlibTest, ZSCFilterShuffle) {
+    printf("test the transpose filter as a byte shuffle\n");
+
+    // byte planes, in order, then any partial element
+    const int len = 16 * 1000 + 7;
+    U8 * source_buf = (U8 *) malloc(len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    U8 * shuffled_buf = (U8 *) malloc(len);
+    ASSERT_NE(shuffled_buf, (U8*)NULL);
+    U8 * unshuffled_buf = (U8 *) malloc(len);
+    ASSERT_NE(unshuffled_buf, (U8*)NULL);
+    srand(92);
+    for (int i = 0; i < len; i++) {
+        source_buf[i] = (U8)rand();
+    }
+    const U32 widths[7] = {1, 2, 3, 4, 8, 12, 16};
+    for (int k = 0; k < 7; k++) {
+        zsc_filter shuffle = {ZSC_FILTER_TRANSPOSE, widths[k]};
+        ASSERT_EQ(zsc_filter_encode(&shuffle, shuffled_buf, source_buf, len),
+                Z_OK);
+        U32 n = len / widths[k];
+        int bad = 0;
+        for (U32 r = 0; r < n; r++) {
+            for (U32 b = 0; b < widths[k]; b++) {
+                bad += shuffled_buf[b * n + r] != source_buf[r * widths[k] + b];
+            }
+        }
+        for (U32 i = n * widths[k]; i < (U32)len; i++) {
+            bad += shuffled_buf[i] != source_buf[i];
+        }
+        EXPECT_EQ(bad, 0) << "width " << widths[k];
+        ASSERT_EQ(zsc_filter_decode(&shuffle, unshuffled_buf, shuffled_buf,
+                len), Z_OK);
+        EXPECT_EQ(memcmp(unshuffled_buf, source_buf, len), 0)
+                << "width " << widths[k];
+    }
+
+    // float32 samples compress better shuffled
+    const int num_samples = 32768;
+    int sample_len = num_samples * 4;
+    U8 * sample_buf = (U8 *) malloc(sample_len);
+    ASSERT_NE(sample_buf, (U8*)NULL);
+    for (int i = 0; i < num_samples; i++) {
+        float sample = 1000.0f + (float)(rand() % 2000) * 0.125f;
+        memcpy(sample_buf + 4 * i, &sample, 4);
+    }
+    int max_block_size = 32768;
+    U32 compressed_buf_len;
+    ZlibReturn err = zsc_compress_get_max_output_size(sample_len,
+            max_block_size, Z_NO_COMPRESSION, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    compressed_buf_len += ZSC_FILTER_HEADER_LEN;
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    const zsc_filter none = {ZSC_FILTER_NONE, 0};
+    const zsc_filter shuffle4 = {ZSC_FILTER_TRANSPOSE, 4};
+    U32 work_buf_len;
+    err = zsc_compress_filter_get_min_work_buf_size2(max_block_size,
+            DEF_WBITS, DEF_MEM_LEVEL, &shuffle4, &work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+    U32 plain_len = compressed_buf_len;
+    err = zsc_compress_filter(compressed_buf, &plain_len, sample_buf,
+            sample_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &none);
+    EXPECT_EQ(err, Z_OK);
+    U32 shuffled_len = compressed_buf_len;
+    err = zsc_compress_filter(compressed_buf, &shuffled_len, sample_buf,
+            sample_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &shuffle4);
+    EXPECT_EQ(err, Z_OK);
+    printf("float32: %u bytes, shuffled: %u bytes\n", plain_len, shuffled_len);
+    EXPECT_LT(shuffled_len, plain_len);
+
+    free(source_buf);
+    free(shuffled_buf);
+    free(unshuffled_buf);
+    free(sample_buf);
+    free(compressed_buf);
+    free(work_buf);
+}
+
+TEST_F(ZlibTest, ZSCFilterPNG) {
+    printf("test PNG predictor filter on a 16 bit image\n");
+
+    // smooth 16 bit gradient with a little sensor noise
+    const int cols = 256;
+    const int rows = 256;
+    const U32 stride = cols * 2;
+    int source_buf_len = stride * rows;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    srand(93);
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            U32 pixel = 20000 + 37 * x + 23 * y + (rand() % 8);
+            source_buf[y * stride + 2 * x] = (U8)(pixel >> 8);
+            source_buf[y * stride + 2 * x + 1] = (U8)pixel;
+        }
+    }
+
+    const zsc_filter png = {ZSC_FILTER_PNG, 2, stride};
+    const zsc_filter none = {ZSC_FILTER_NONE, 0, 0};
+    U32 size = 0;
+    EXPECT_EQ(zsc_filter_get_encoded_len(&png, stride * 3 + 5, &size), Z_OK);
+    EXPECT_EQ(size, stride * 3 + 3 + 5);
+    EXPECT_EQ(zsc_filter_get_decoded_len(&png, size, &size), Z_OK);
+    EXPECT_EQ(size, stride * 3 + 5);
+    EXPECT_EQ(zsc_filter_get_decoded_len(&png, stride, &size), Z_DATA_ERROR);
+
+    // direct round trip, with a partial last row
+    U32 len = stride * 4 + 7;
+    U32 enc_len = 0;
+    ASSERT_EQ(zsc_filter_get_encoded_len(&png, len, &enc_len), Z_OK);
+    U8 * encoded_buf = (U8 *) malloc(enc_len);
+    ASSERT_NE(encoded_buf, (U8*)NULL);
+    U8 * decoded_buf = (U8 *) malloc(len);
+    ASSERT_NE(decoded_buf, (U8*)NULL);
+    ASSERT_EQ(zsc_filter_encode(&png, encoded_buf, source_buf, len), Z_OK);
+    for (U32 r = 0; r < 4; r++) {
+        EXPECT_LE(encoded_buf[r * (stride + 1)], (U8)ZSC_PNG_PAETH);
+    }
+    ASSERT_EQ(zsc_filter_decode(&png, decoded_buf, encoded_buf, len), Z_OK);
+    EXPECT_EQ(memcmp(decoded_buf, source_buf, len), 0);
+    encoded_buf[stride + 1] = 9; // no such row type
+    EXPECT_EQ(zsc_filter_decode(&png, decoded_buf, encoded_buf, len),
+            Z_DATA_ERROR);
+
+    // through deflate, blocks of whole rows
+    ZlibReturn err;
+    int max_block_size = stride * 32;
+    U32 compressed_buf_len;
+    err = zsc_compress_get_max_output_size(source_buf_len + rows,
+            max_block_size, Z_NO_COMPRESSION, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    compressed_buf_len += ZSC_FILTER_HEADER_LEN;
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    U32 work_buf_len;
+    err = zsc_compress_filter_get_min_work_buf_size2(max_block_size,
+            DEF_WBITS, DEF_MEM_LEVEL, &png, &work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U32 uc_work_len;
+    err = zsc_uncompress_filter_get_min_work_buf_size2(max_block_size,
+            DEF_WBITS, &png, &uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    work_buf_len = ZMAX(work_buf_len, uc_work_len);
+    U8 * work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+
+    U32 plain_len = compressed_buf_len;
+    err = zsc_compress_filter(compressed_buf, &plain_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &none);
+    EXPECT_EQ(err, Z_OK);
+    U32 filtered_len = compressed_buf_len;
+    err = zsc_compress_filter(compressed_buf, &filtered_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &png);
+    EXPECT_EQ(err, Z_OK);
+    printf("image: %u bytes, PNG filtered: %u bytes\n", plain_len,
+            filtered_len);
+    EXPECT_LT(filtered_len, plain_len);
+
+    U32 uncompressed_len = source_buf_len;
+    U32 source_len = filtered_len;
+    err = zsc_uncompress_filter(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(uncompressed_len, (U32)source_buf_len);
+    EXPECT_EQ(source_len, filtered_len);
+    EXPECT_EQ(memcmp(uncompressed_buf, source_buf, source_buf_len), 0);
+
+    // corrupt header with a stride too long for a row and its type byte
+    const zsc_filter long_stride = {ZSC_FILTER_PNG, 2, U32_MAX};
+    EXPECT_EQ(zsc_filter_check(&long_stride), Z_STREAM_ERROR);
+    EXPECT_EQ(zsc_filter_get_decoded_len(&long_stride, stride, &size),
+            Z_STREAM_ERROR);
+    const zsc_filter max_stride = {ZSC_FILTER_PNG, 2, ZSC_FILTER_MAX_STRIDE};
+    EXPECT_EQ(zsc_filter_check(&max_stride), Z_OK);
+    memset(compressed_buf + 12, 0xFF, 4); // stride field of the header
+    uncompressed_len = source_buf_len;
+    source_len = filtered_len;
+    err = zsc_uncompress_filter(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+    EXPECT_EQ(uncompressed_len, (U32)0);
+
+    // stride shorter than a pixel
+    const zsc_filter bad_stride = {ZSC_FILTER_PNG, 4, 2};
+    EXPECT_EQ(zsc_filter_check(&bad_stride), Z_STREAM_ERROR);
+    filtered_len = compressed_buf_len;
+    err = zsc_compress_filter(compressed_buf, &filtered_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION, &bad_stride);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+
+    free(source_buf);
+    free(encoded_buf);
+    free(decoded_buf);
+    free(compressed_buf);
+    free(uncompressed_buf);
+    free(work_buf);
+}
+
+TEST_F(ZlibTest, ZSCCompressDedup) {
+    printf("test deduplication of regions beyond the window\n");
+
+    // a calibration table repeated far apart, between unrelated data
+    const int table_len = 48 * 1024;
+    const int gap_len = 80 * 1024;
+    int source_buf_len = 3 * table_len + 2 * gap_len;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    srand(94);
+    for (int i = 0; i < source_buf_len; i++) {
+        source_buf[i] = (U8)(rand() >> 4);
+    }
+    memcpy(source_buf + table_len + gap_len, source_buf, table_len);
+    memcpy(source_buf + 2 * (table_len + gap_len), source_buf, table_len);
+
+    ZlibReturn err;
+    int max_block_size = 32768;
+    U32 compressed_buf_len;
+    err = zsc_compress_dedup_get_max_output_size2(source_buf_len,
+            max_block_size, Z_DEFAULT_COMPRESSION, DEF_WBITS, DEF_MEM_LEVEL,
+            &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    U32 work_buf_len;
+    err = zsc_compress_dedup_get_min_work_buf_size2(source_buf_len,
+            DEF_WBITS, DEF_MEM_LEVEL, &work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+
+    U32 plain_len = compressed_buf_len;
+    err = zsc_compress(compressed_buf, &plain_len, source_buf, source_buf_len,
+            max_block_size, work_buf, work_buf_len, Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_OK);
+    U32 dedup_len = compressed_buf_len;
+    err = zsc_compress_dedup(compressed_buf, &dedup_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_OK);
+    printf("plain: %u bytes, deduplicated: %u bytes\n", plain_len, dedup_len);
+    // most of both copies cost only table entries
+    EXPECT_LT(dedup_len, plain_len - table_len);
+
+    U32 uncompressed_len = source_buf_len;
+    U32 source_len = dedup_len;
+    err = zsc_uncompress_dedup(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(uncompressed_len, (U32)source_buf_len);
+    EXPECT_EQ(source_len, dedup_len);
+    EXPECT_EQ(memcmp(uncompressed_buf, source_buf, source_buf_len), 0);
+
+    // short inputs are one chunk, empty input none
+    const U32 short_lens[3] = {0, 1, ZSC_DEDUP_MIN_CHUNK + 1};
+    for (int k = 0; k < 3; k++) {
+        U32 short_len = compressed_buf_len;
+        err = zsc_compress_dedup(compressed_buf, &short_len, source_buf,
+                short_lens[k], max_block_size, work_buf, work_buf_len,
+                Z_DEFAULT_COMPRESSION);
+        EXPECT_EQ(err, Z_OK);
+        uncompressed_len = source_buf_len;
+        source_len = short_len;
+        err = zsc_uncompress_dedup(uncompressed_buf, &uncompressed_len,
+                compressed_buf, &source_len, work_buf, work_buf_len);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(uncompressed_len, short_lens[k]);
+        EXPECT_EQ(memcmp(uncompressed_buf, source_buf, short_lens[k]), 0);
+    }
+
+    printf("corrupt containers\n");
+    dedup_len = compressed_buf_len;
+    err = zsc_compress_dedup(compressed_buf, &dedup_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_OK);
+    uncompressed_len = source_buf_len - 1;
+    source_len = dedup_len;
+    err = zsc_uncompress_dedup(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    uncompressed_len = source_buf_len;
+    source_len = dedup_len - 100;
+    err = zsc_uncompress_dedup(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+    // point the second chunk forward, at itself plus one
+    U8 saved = compressed_buf[ZSC_DEDUP_HEADER_LEN + ZSC_DEDUP_ENTRY_LEN + 4];
+    compressed_buf[ZSC_DEDUP_HEADER_LEN + ZSC_DEDUP_ENTRY_LEN + 4] += 1;
+    uncompressed_len = source_buf_len;
+    source_len = dedup_len;
+    err = zsc_uncompress_dedup(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+    compressed_buf[ZSC_DEDUP_HEADER_LEN + ZSC_DEDUP_ENTRY_LEN + 4] = saved;
+    compressed_buf[1] = 'X';
+    uncompressed_len = source_buf_len;
+    source_len = dedup_len;
+    err = zsc_uncompress_dedup(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+    compressed_buf[1] = ZSC_DEDUP_ID2;
+
+    printf("blocks after a corrupt one are recovered in place\n");
+    U32 table_end = ZSC_DEDUP_HEADER_LEN;
+    while (table_end < dedup_len && (compressed_buf[table_end] != 0x78
+            || compressed_buf[table_end + 1] != 0x9c)) {
+        table_end += ZSC_DEDUP_ENTRY_LEN; // find the zlib header
+    }
+    ASSERT_LT(table_end, dedup_len);
+    // the data is random, so blocks are stored: give the first block
+    // the reserved block type
+    compressed_buf[table_end + 2] ^= 0x06;
+    memset(uncompressed_buf, 0xAA, source_buf_len);
+    uncompressed_len = source_buf_len;
+    source_len = dedup_len;
+    err = zsc_uncompress_dedup(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+    EXPECT_EQ(uncompressed_len, (U32)source_buf_len);
+    // the first table copy starts in the first block, the gap after it
+    // is in later ones
+    EXPECT_NE(memcmp(uncompressed_buf, source_buf, max_block_size), 0);
+    EXPECT_EQ(memcmp(uncompressed_buf + table_len, source_buf + table_len,
+            gap_len), 0);
+    EXPECT_EQ(memcmp(uncompressed_buf + 2 * table_len + gap_len,
+            source_buf + 2 * table_len + gap_len, gap_len), 0);
+    compressed_buf[table_end + 2] ^= 0x06;
+
+    printf("bad arguments\n");
+    dedup_len = compressed_buf_len;
+    err = zsc_compress_dedup(compressed_buf, &dedup_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len - 1,
+            Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+    dedup_len = ZSC_DEDUP_HEADER_LEN + 2 * ZSC_DEDUP_ENTRY_LEN;
+    err = zsc_compress_dedup(compressed_buf, &dedup_len, source_buf,
+            source_buf_len, max_block_size, work_buf, work_buf_len,
+            Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+
+    free(source_buf);
+    free(compressed_buf);
+    free(uncompressed_buf);
+    free(work_buf);
+}
+
+TEST_F(ZlibTest, ZSCCompressFrame) {
+    printf("test frames compressed against the previous frame\n");
+
+    // telemetry frames that change a little from one to the next
+    const int frame_len = 8192;
+    const int num_frames = 20;
+    const U32 interval = 8;
+    U8 * frames_buf = (U8 *) malloc(frame_len * num_frames);
+    ASSERT_NE(frames_buf, (U8*)NULL);
+    srand(95);
+    for (int i = 0; i < frame_len; i++) {
+        frames_buf[i] = (U8)((rand() % 64) + (i % 16) * 8);
+    }
+    for (int f = 1; f < num_frames; f++) {
+        U8 *frame = frames_buf + f * frame_len;
+        memcpy(frame, frame - frame_len, frame_len);
+        for (int k = 0; k < frame_len / 100; k++) {
+            frame[rand() % frame_len] = (U8)rand();
+        }
+    }
+
+    ZlibReturn err;
+    U32 out_buf_len;
+    err = zsc_compress_get_max_output_size(frame_len, frame_len,
+            Z_DEFAULT_COMPRESSION, &out_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * out_buf = (U8 *) malloc(out_buf_len * num_frames);
+    ASSERT_NE(out_buf, (U8*)NULL);
+    U32 out_lens[num_frames];
+    U8 * uncompressed_buf = (U8 *) malloc(frame_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    U32 comp_work_len;
+    err = zsc_compress_frame_get_min_work_buf_size2(DEF_WBITS,
+            DEF_MEM_LEVEL, &comp_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * comp_work = (U8 *) malloc(comp_work_len);
+    ASSERT_NE(comp_work, (U8*)NULL);
+    U32 uncomp_work_len;
+    err = zsc_uncompress_frame_get_min_work_buf_size2(DEF_WBITS,
+            &uncomp_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uncomp_work = (U8 *) malloc(uncomp_work_len);
+    ASSERT_NE(uncomp_work, (U8*)NULL);
+
+    U32 plain_total = 0;
+    for (int f = 0; f < num_frames; f++) {
+        U32 plain_len = out_buf_len;
+        err = zsc_compress(out_buf, &plain_len, frames_buf + f * frame_len,
+                frame_len, frame_len, comp_work, comp_work_len,
+                Z_DEFAULT_COMPRESSION);
+        EXPECT_EQ(err, Z_OK);
+        plain_total += plain_len;
+    }
+
+    zsc_frame comp;
+    err = zsc_compress_frame_init(&comp, comp_work, comp_work_len,
+            Z_DEFAULT_COMPRESSION, DEF_WBITS, DEF_MEM_LEVEL,
+            Z_DEFAULT_STRATEGY, interval);
+    EXPECT_EQ(err, Z_OK);
+    U32 frame_total = 0;
+    for (int f = 0; f < num_frames; f++) {
+        out_lens[f] = out_buf_len;
+        err = zsc_compress_frame(&comp, out_buf + f * out_buf_len,
+                &out_lens[f], frames_buf + f * frame_len, frame_len);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(comp.frames, (U32)(f % interval) + 1);
+        frame_total += out_lens[f];
+    }
+    printf("frames alone: %u bytes, against previous: %u bytes\n",
+            plain_total, frame_total);
+    EXPECT_LT(frame_total * 2, plain_total);
+
+    // every frame back, in order
+    zsc_frame uncomp;
+    err = zsc_uncompress_frame_init(&uncomp, uncomp_work, uncomp_work_len,
+            DEF_WBITS);
+    EXPECT_EQ(err, Z_OK);
+    for (int f = 0; f < num_frames; f++) {
+        U32 uncompressed_len = frame_len;
+        U32 source_len = out_lens[f];
+        err = zsc_uncompress_frame(&uncomp, uncompressed_buf,
+                &uncompressed_len, out_buf + f * out_buf_len, &source_len);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(uncompressed_len, (U32)frame_len);
+        EXPECT_EQ(source_len, out_lens[f]);
+        EXPECT_EQ(memcmp(uncompressed_buf, frames_buf + f * frame_len,
+                frame_len), 0) << "frame " << f;
+    }
+
+    // frame 3 lost: the rest fail until the keyframe
+    printf("resync after a lost frame\n");
+    err = zsc_uncompress_frame_init(&uncomp, uncomp_work, uncomp_work_len,
+            DEF_WBITS);
+    EXPECT_EQ(err, Z_OK);
+    for (int f = 0; f < num_frames; f++) {
+        if (f == 3) {
+            continue;
+        }
+        U32 uncompressed_len = frame_len;
+        U32 source_len = out_lens[f];
+        err = zsc_uncompress_frame(&uncomp, uncompressed_buf,
+                &uncompressed_len, out_buf + f * out_buf_len, &source_len);
+        if (f > 3 && f < (int)interval) {
+            EXPECT_EQ(err, Z_DATA_ERROR) << "frame " << f;
+        } else {
+            EXPECT_EQ(err, Z_OK) << "frame " << f;
+            EXPECT_EQ(memcmp(uncompressed_buf, frames_buf + f * frame_len,
+                    frame_len), 0) << "frame " << f;
+        }
+    }
+
+    printf("bad arguments\n");
+    EXPECT_EQ(zsc_compress_frame_init(&comp, comp_work, comp_work_len - 1,
+            Z_DEFAULT_COMPRESSION, DEF_WBITS, DEF_MEM_LEVEL,
+            Z_DEFAULT_STRATEGY, interval), Z_MEM_ERROR);
+    EXPECT_EQ(zsc_compress_frame_init(&comp, comp_work, comp_work_len,
+            Z_DEFAULT_COMPRESSION, -DEF_WBITS, DEF_MEM_LEVEL,
+            Z_DEFAULT_STRATEGY, interval), Z_STREAM_ERROR);
+    EXPECT_EQ(zsc_uncompress_frame_init(&uncomp, uncomp_work,
+            uncomp_work_len, DEF_WBITS + GZIP_CODE), Z_STREAM_ERROR);
+    // an output too small fails, and makes the next frame a keyframe
+    err = zsc_compress_frame_init(&comp, comp_work, comp_work_len,
+            Z_DEFAULT_COMPRESSION, DEF_WBITS, DEF_MEM_LEVEL,
+            Z_DEFAULT_STRATEGY, 0);
+    EXPECT_EQ(err, Z_OK);
+    U32 small_len = out_buf_len;
+    err = zsc_compress_frame(&comp, out_buf, &small_len, frames_buf,
+            frame_len);
+    EXPECT_EQ(err, Z_OK);
+    small_len = 10;
+    err = zsc_compress_frame(&comp, out_buf, &small_len,
+            frames_buf + frame_len, frame_len);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    EXPECT_EQ(comp.ref_len, 0U);
+
+    free(frames_buf);
+    free(out_buf);
+    free(uncompressed_buf);
+    free(comp_work);
+    free(uncomp_work);
+}
+
+TEST_F(ZlibTest, ZSCDictRegistry) {
+    printf("test dictionaries found by id\n");
+
+    // a dictionary per message class, of the text its messages share
+    const char *dict_text[3] = {
+            "status: mode=SAFE temp_c= volts= amps= heater=ON heater=OFF "
+            "wheel_rpm= attitude_ok=TRUE attitude_ok=FALSE seq=",
+            "event: severity=WARNING severity=INFO severity=FATAL "
+            "source=POWER source=THERMAL source=GNC code= count= seq=",
+            "image: camera=NAVCAM camera=HAZCAM exposure_ms= gain= "
+            "width=1024 height=1024 compressed=TRUE seq="};
+    zsc_dict_registry reg;
+    EXPECT_EQ(zsc_dict_registry_init(&reg), Z_OK);
+    U32 ids[3];
+    for (int d = 0; d < 3; d++) {
+        EXPECT_EQ(zsc_dict_register(&reg, (const U8 *)dict_text[d],
+                strlen(dict_text[d]), &ids[d]), Z_OK);
+        EXPECT_EQ(ids[d], adler32(1, (const U8 *)dict_text[d],
+                strlen(dict_text[d])));
+        EXPECT_EQ(zsc_dict_find(&reg, ids[d]), &reg.dicts[d]);
+    }
+    // registering again gives the same id, and no new entry
+    U32 again;
+    EXPECT_EQ(zsc_dict_register(&reg, (const U8 *)dict_text[1],
+            strlen(dict_text[1]), &again), Z_OK);
+    EXPECT_EQ(again, ids[1]);
+    EXPECT_EQ(reg.num_dicts, 3U);
+    EXPECT_EQ(zsc_dict_find(&reg, ids[0] + 1), (const zsc_dict *)NULL);
+
+    const char *messages[3] = {
+            "status: mode=SAFE temp_c=21.5 volts=28.1 amps=1.9 heater=OFF "
+            "wheel_rpm=1200 attitude_ok=TRUE seq=1041",
+            "event: severity=WARNING source=THERMAL code=17 count=3 seq=1042",
+            "image: camera=HAZCAM exposure_ms=12 gain=2 width=1024 "
+            "height=1024 compressed=TRUE seq=1043"};
+
+    ZlibReturn err;
+    U32 work_buf_len;
+    err = zsc_compress_get_min_work_buf_size(&work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+    U8 compressed_buf[512];
+    U8 uncompressed_buf[512];
+    for (int m = 0; m < 3; m++) {
+        U32 msg_len = strlen(messages[m]);
+        U32 plain_len = sizeof(compressed_buf);
+        err = zsc_compress(compressed_buf, &plain_len,
+                (const U8 *)messages[m], msg_len, msg_len, work_buf,
+                work_buf_len, Z_DEFAULT_COMPRESSION);
+        EXPECT_EQ(err, Z_OK);
+        U32 uncompressed_len = sizeof(uncompressed_buf);
+        U32 source_len = plain_len;
+        // messages without a dictionary still decompress
+        err = zsc_uncompress_dict(uncompressed_buf, &uncompressed_len,
+                compressed_buf, &source_len, work_buf, work_buf_len, &reg);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(uncompressed_len, msg_len);
+
+        U32 dict_len = sizeof(compressed_buf);
+        err = zsc_compress_dict(compressed_buf, &dict_len,
+                (const U8 *)messages[m], msg_len, msg_len, work_buf,
+                work_buf_len, Z_DEFAULT_COMPRESSION, &reg, ids[m]);
+        EXPECT_EQ(err, Z_OK);
+        printf("message %d: %u bytes, alone %u, with dictionary %u\n",
+                m, msg_len, plain_len, dict_len);
+        EXPECT_LT(dict_len, plain_len);
+
+        uncompressed_len = sizeof(uncompressed_buf);
+        source_len = dict_len;
+        err = zsc_uncompress_dict(uncompressed_buf, &uncompressed_len,
+                compressed_buf, &source_len, work_buf, work_buf_len, &reg);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(uncompressed_len, msg_len);
+        EXPECT_EQ(source_len, dict_len);
+        EXPECT_EQ(memcmp(uncompressed_buf, messages[m], msg_len), 0);
+    }
+
+    printf("missing dictionary\n");
+    zsc_dict_registry other;
+    EXPECT_EQ(zsc_dict_registry_init(&other), Z_OK);
+    U32 uncompressed_len = sizeof(uncompressed_buf);
+    U32 source_len = sizeof(compressed_buf);
+    U32 dict_len = sizeof(compressed_buf);
+    err = zsc_compress_dict(compressed_buf, &dict_len,
+            (const U8 *)messages[0], strlen(messages[0]), 512, work_buf,
+            work_buf_len, Z_DEFAULT_COMPRESSION, &reg, ids[0]);
+    EXPECT_EQ(err, Z_OK);
+    source_len = dict_len;
+    err = zsc_uncompress_dict(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, work_buf, work_buf_len, &other);
+    EXPECT_EQ(err, Z_NEED_DICT);
+    dict_len = sizeof(compressed_buf);
+    err = zsc_compress_dict(compressed_buf, &dict_len,
+            (const U8 *)messages[0], strlen(messages[0]), 512, work_buf,
+            work_buf_len, Z_DEFAULT_COMPRESSION, &other, ids[0]);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    dict_len = sizeof(compressed_buf);
+    err = zsc_compress_dict2(compressed_buf, &dict_len,
+            (const U8 *)messages[0], strlen(messages[0]), 512, work_buf,
+            work_buf_len, Z_DEFAULT_COMPRESSION, DEF_WBITS + GZIP_CODE,
+            DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, &reg, ids[0]);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+
+    printf("registry limits\n");
+    const int long_len = 40000;
+    U8 * long_dict = (U8 *) malloc(long_len);
+    ASSERT_NE(long_dict, (U8*)NULL);
+    for (int i = 0; i < long_len; i++) {
+        long_dict[i] = (U8)(i * 7 + i / 251);
+    }
+    U32 long_id;
+    EXPECT_EQ(zsc_dict_register(&other, long_dict, long_len, &long_id),
+            Z_OK);
+    EXPECT_EQ(long_id, adler32(1, long_dict + long_len - ZSC_DICT_MAX_LEN,
+            ZSC_DICT_MAX_LEN));
+    EXPECT_EQ(zsc_dict_register(&other, long_dict, 0, &long_id),
+            Z_STREAM_ERROR);
+    for (int d = 1; d < ZSC_DICT_MAX; d++) {
+        EXPECT_EQ(zsc_dict_register(&other, long_dict + d, 1000, &long_id),
+                Z_OK);
+    }
+    EXPECT_EQ(zsc_dict_register(&other, long_dict + 100, 1000, &long_id),
+            Z_STREAM_ERROR);
+    for (int d = 1; d < ZSC_DICT_MAX; d++) {
+        EXPECT_EQ(zsc_dict_find(&other, other.dicts[d].id), &other.dicts[d]);
+    }
+
+    free(long_dict);
+    free(work_buf);
+}
+
+TEST_F(ZlibTest, ZSCEstimateRatio) {
+    printf("test estimating compressed size\n");
+
+    ZlibReturn err;
+    U32 est_work_buf_len;
+    err = zsc_estimate_get_min_work_buf_size(&est_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * est_work_buf = (U8 *) malloc(est_work_buf_len);
+    ASSERT_NE(est_work_buf, (U8*)NULL);
+    U32 work_buf_len;
+    err = zsc_compress_get_min_work_buf_size(&work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+    U8 * source_buf = (U8 *) malloc(CORPUS_MAX_SIZE);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    U32 compressed_buf_len;
+    err = zsc_compress_get_max_output_size(CORPUS_MAX_SIZE, CORPUS_MAX_SIZE,
+            Z_DEFAULT_COMPRESSION, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+
+    // within 10% of the actual size, at a fast and the default level,
+    // but for highly repetitive files, which compress to a few percent of
+    // their length and are only estimated within a factor of four
+    const I32 levels[2] = {1, Z_DEFAULT_COMPRESSION};
+    const char * repetitive[5] = {
+            "corpus/cantrbry/kennedy.xls",
+            "corpus/artificl/a.txt",
+            "corpus/artificl/aaa.txt",
+            "corpus/artificl/alphabet.txt",
+            "corpus/calgary/pic"};
+    for (int j = 0; j < NUM_CORPUS; j++) {
+        bool loose = false;
+        for (int r = 0; r < 5; r++) {
+            loose = loose || (strcmp(corpus_files[j], repetitive[r]) == 0);
+        }
+        FILE * file = fopen(corpus_files[j], "r");
+        ASSERT_FALSE(file == NULL);
+        U32 source_len = fread(source_buf, 1, CORPUS_MAX_SIZE, file);
+        ASSERT_FALSE(ferror(file));
+        fclose(file);
+        for (int l = 0; l < 2; l++) {
+            U32 est_len = 0;
+            err = zsc_estimate_ratio(source_buf, source_len, levels[l],
+                    est_work_buf, est_work_buf_len, &est_len);
+            EXPECT_EQ(err, Z_OK);
+            U32 actual_len = compressed_buf_len;
+            err = zsc_compress(compressed_buf, &actual_len, source_buf,
+                    source_len, source_len, work_buf, work_buf_len,
+                    levels[l]);
+            EXPECT_EQ(err, Z_OK);
+            if (loose) {
+                EXPECT_LE(est_len, 4 * actual_len) << corpus_files[j]
+                        << " level " << levels[l] << " actual " << actual_len;
+                EXPECT_GE(4 * est_len, actual_len) << corpus_files[j]
+                        << " level " << levels[l] << " actual " << actual_len;
+            } else {
+                U32 diff = (est_len > actual_len) ? est_len - actual_len
+                        : actual_len - est_len;
+                EXPECT_LE(diff, actual_len / 10) << corpus_files[j]
+                        << " level " << levels[l] << " estimated " << est_len
+                        << " actual " << actual_len;
+            }
+        }
+    }
+
+    // level 0, and empty input, give the stored size
+    U32 est_len = 0;
+    err = zsc_estimate_ratio(source_buf, 1000, 0, est_work_buf,
+            est_work_buf_len, &est_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(est_len, 1000U + 6 + 5);
+    err = zsc_estimate_ratio(source_buf, 0, 6, est_work_buf,
+            est_work_buf_len, &est_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(est_len, 6U + 5);
+    // random bytes are estimated as stored, near enough
+    U32 rand_state = 12345;
+    for (U32 i = 0; i < 100000; i++) {
+        rand_state = rand_state * 1103515245 + 12345;
+        source_buf[i] = (U8)(rand_state >> 23);
+    }
+    err = zsc_estimate_ratio(source_buf, 100000, 9, est_work_buf,
+            est_work_buf_len, &est_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_GE(est_len, 99000U);
+    EXPECT_LE(est_len, 100000U + 6 + 5 * 2);
+
+    err = zsc_estimate_ratio(source_buf, 1000, 10, est_work_buf,
+            est_work_buf_len, &est_len);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    err = zsc_estimate_ratio(source_buf, 1000, 6, est_work_buf,
+            est_work_buf_len - 1, &est_len);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+
+    free(est_work_buf);
+    free(work_buf);
+    free(source_buf);
+    free(compressed_buf);
+}
+
+TEST_F(ZlibTest, DeflateAccel) {
+    printf("test skipping through unmatched input at fast levels\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    // text, then noise, then text again
+    const U32 text_len = 65536;
+    const U32 noise_len = 131072;
+    U32 source_buf_len = 2 * text_len + noise_len;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    U32 nread = fread(source_buf, 1, text_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_EQ(nread, text_len);
+    U32 rand_state = 98;
+    for (U32 i = 0; i < noise_len; i++) {
+        rand_state = rand_state * 1103515245 + 12345;
+        source_buf[text_len + i] = (U8)(rand_state >> 23);
+    }
+    memcpy(source_buf + text_len + noise_len, source_buf, text_len);
+
+    ZlibReturn err;
+    U32 c_work_len;
+    err = deflateWorkSize(&c_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+    U32 uc_work_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    U32 compressed_buf_len = source_buf_len * 2;
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+
+    U32 plain_len = 0;
+    for (I32 level = 1; level <= 3; level++) {
+        for (I32 accel = 0; accel <= 7; accel++) {
+            z_stream strm;
+            memset(&strm, 0, sizeof(strm));
+            strm.next_work = c_work_buf;
+            strm.avail_work = c_work_len;
+            err = deflateInit(&strm, level);
+            EXPECT_EQ(err, Z_OK);
+            err = deflateAccel(&strm, accel);
+            EXPECT_EQ(err, Z_OK);
+            strm.next_in = source_buf;
+            strm.avail_in = source_buf_len;
+            strm.next_out = compressed_buf;
+            strm.avail_out = compressed_buf_len;
+            err = deflate(&strm, Z_FINISH);
+            EXPECT_EQ(err, Z_STREAM_END);
+            U32 out_len = strm.total_out;
+            err = deflateEnd(&strm);
+            EXPECT_EQ(err, Z_OK);
+
+            U32 uncompressed_len = source_buf_len;
+            U32 source_len = out_len;
+            err = zsc_uncompress(uncompressed_buf, &uncompressed_len,
+                    compressed_buf, &source_len, uc_work_buf, uc_work_len);
+            EXPECT_EQ(err, Z_OK);
+            EXPECT_EQ(uncompressed_len, source_buf_len);
+            EXPECT_EQ(memcmp(source_buf, uncompressed_buf, source_buf_len),
+                    0);
+
+            // the repeated text is still found after the noise
+            if (accel == 0) {
+                plain_len = out_len;
+            }
+            EXPECT_LE(out_len, plain_len + plain_len / 10)
+                    << "level " << level << " accel " << accel;
+        }
+    }
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    strm.next_work = c_work_buf;
+    strm.avail_work = c_work_len;
+    err = deflateInit(&strm, 1);
+    EXPECT_EQ(err, Z_OK);
+    err = deflateAccel(&strm, 8);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    err = deflateAccel(&strm, -1);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    err = deflateEnd(&strm);
+    EXPECT_EQ(err, Z_OK);
+    err = deflateAccel(Z_NULL, 1);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+
+    free(source_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+    free(uncompressed_buf);
+    free(compressed_buf);
+}
+
+TEST_F(ZlibTest, DeflateAdaptChain) {
+    printf("test adapting the chain search limit\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    // text, then four-letter noise with long, unrewarding hash chains
+    const U32 text_len = 65536;
+    const U32 noise_len = 65536;
+    U32 source_buf_len = text_len + noise_len;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    U32 nread = fread(source_buf, 1, text_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_EQ(nread, text_len);
+    U32 rand_state = 99;
+    for (U32 i = 0; i < noise_len; i++) {
+        rand_state = rand_state * 1103515245 + 12345;
+        source_buf[text_len + i] = "ACGT"[(rand_state >> 23) & 3];
+    }
+
+    ZlibReturn err;
+    U32 c_work_len;
+    err = deflateWorkSize(&c_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+    U32 uc_work_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    U32 compressed_buf_len = source_buf_len * 2;
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+
+    for (I32 level = 4; level <= 9; level++) {
+        U32 plain_len = 0;
+        for (I32 adapt = 0; adapt <= 1; adapt++) {
+            z_stream strm;
+            memset(&strm, 0, sizeof(strm));
+            strm.next_work = c_work_buf;
+            strm.avail_work = c_work_len;
+            err = deflateInit(&strm, level);
+            EXPECT_EQ(err, Z_OK);
+            err = deflateAdaptChain(&strm, adapt);
+            EXPECT_EQ(err, Z_OK);
+            strm.next_in = source_buf;
+            strm.avail_in = source_buf_len;
+            strm.next_out = compressed_buf;
+            strm.avail_out = compressed_buf_len;
+            err = deflate(&strm, Z_FINISH);
+            EXPECT_EQ(err, Z_STREAM_END);
+            U32 out_len = strm.total_out;
+            err = deflateEnd(&strm);
+            EXPECT_EQ(err, Z_OK);
+
+            U32 uncompressed_len = source_buf_len;
+            U32 source_len = out_len;
+            err = zsc_uncompress(uncompressed_buf, &uncompressed_len,
+                    compressed_buf, &source_len, uc_work_buf, uc_work_len);
+            EXPECT_EQ(err, Z_OK);
+            EXPECT_EQ(uncompressed_len, source_buf_len);
+            EXPECT_EQ(memcmp(source_buf, uncompressed_buf, source_buf_len),
+                    0);
+
+            // shorter searches cost little compression
+            if (adapt == 0) {
+                plain_len = out_len;
+            }
+            EXPECT_LE(out_len, plain_len + plain_len / 50)
+                    << "level " << level;
+        }
+    }
+
+    printf("retuning restarts the adaptation from the level's limits\n");
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    strm.next_work = c_work_buf;
+    strm.avail_work = c_work_len;
+    err = deflateInit(&strm, 9);
+    EXPECT_EQ(err, Z_OK);
+    err = deflateAdaptChain(&strm, 1);
+    EXPECT_EQ(err, Z_OK);
+    U32 level_min = strm.state->min_chain_length;
+    EXPECT_GT(level_min, 4U);
+    err = deflateTune(&strm, 4, 5, 16, 4);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(strm.state->min_chain_length, 4U);
+    err = deflateTune(&strm, 32, 258, 258, 4096);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(strm.state->min_chain_length, level_min);
+    strm.state->deep_walks = 1;
+    strm.state->deep_cost = 1;
+    strm.state->deep_gain = 1;
+    err = deflateTune(&strm, 32, 258, 258, 4096);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(strm.state->deep_walks, 0U);
+    EXPECT_EQ(strm.state->deep_cost, 0U);
+    EXPECT_EQ(strm.state->deep_gain, 0U);
+    strm.state->deep_walks = 1;
+    strm.state->deep_cost = 1;
+    strm.state->deep_gain = 1;
+    strm.state->chain_limit = 1;
+    strm.next_out = compressed_buf;
+    strm.avail_out = compressed_buf_len;
+    err = deflateParams(&strm, 6, Z_DEFAULT_STRATEGY);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(strm.state->chain_limit, strm.state->max_chain_length);
+    EXPECT_EQ(strm.state->deep_walks, 0U);
+    EXPECT_EQ(strm.state->deep_cost, 0U);
+    EXPECT_EQ(strm.state->deep_gain, 0U);
+    err = deflateEnd(&strm);
+    EXPECT_EQ(err, Z_OK);
+
+    err = deflateAdaptChain(Z_NULL, 1);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+
+    free(source_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+    free(uncompressed_buf);
+    free(compressed_buf);
+}
+
+TEST_F(ZlibTest, DeflateFastRuns) {
+    printf("test emitting long runs without searching them\n");
+
+    // sparse pages: mostly zeros, with a few bytes set and some short runs
+    // that end inside longer ones
+    const U32 page_len = 4096;
+    const U32 n_pages = 64;
+    U32 source_buf_len = page_len * n_pages;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    memset(source_buf, 0, source_buf_len);
+    U32 rand_state = 7;
+    for (U32 p = 0; p < n_pages; p++) {
+        U8 * page = source_buf + p * page_len;
+        for (U32 k = 0; k < 12; k++) {
+            rand_state = rand_state * 1103515245 + 12345;
+            U32 pos = (rand_state >> 8) % (page_len - 600);
+            U32 len = 1 + ((rand_state >> 20) & 7);
+            memset(page + pos, (U8)(rand_state >> 24) | 1, len);
+        }
+        if ((p % 4) == 0) {
+            memset(page + 1000, 0xFF, 300 + p);
+        }
+    }
+
+    ZlibReturn err;
+    U32 c_work_len;
+    err = deflateWorkSize(&c_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+    U32 uc_work_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    U32 compressed_buf_len = source_buf_len * 2;
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * default_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(default_buf, (U8*)NULL);
+
+    for (I32 level = 1; level <= 9; level++) {
+        U32 default_len = 0;
+        U32 plain_len = 0;
+        // -1 for the default, without calling deflateFastRuns()
+        for (I32 fast_runs = -1; fast_runs <= 1; fast_runs++) {
+            z_stream strm;
+            memset(&strm, 0, sizeof(strm));
+            strm.next_work = c_work_buf;
+            strm.avail_work = c_work_len;
+            err = deflateInit(&strm, level);
+            EXPECT_EQ(err, Z_OK);
+            if (fast_runs >= 0) {
+                err = deflateFastRuns(&strm, fast_runs);
+                EXPECT_EQ(err, Z_OK);
+            }
+            strm.next_in = source_buf;
+            strm.avail_in = source_buf_len;
+            strm.next_out = (fast_runs < 0) ? default_buf : compressed_buf;
+            strm.avail_out = compressed_buf_len;
+            err = deflate(&strm, Z_FINISH);
+            EXPECT_EQ(err, Z_STREAM_END);
+            U32 out_len = strm.total_out;
+            err = deflateEnd(&strm);
+            EXPECT_EQ(err, Z_OK);
+
+            U32 uncompressed_len = source_buf_len;
+            U32 source_len = out_len;
+            err = zsc_uncompress(uncompressed_buf, &uncompressed_len,
+                    (fast_runs < 0) ? default_buf : compressed_buf,
+                    &source_len, uc_work_buf, uc_work_len);
+            EXPECT_EQ(err, Z_OK);
+            EXPECT_EQ(uncompressed_len, source_buf_len);
+            EXPECT_EQ(memcmp(source_buf, uncompressed_buf, source_buf_len),
+                    0);
+
+            if (fast_runs < 0) {
+                default_len = out_len;
+            } else if (fast_runs == 0) {
+                // off is the default, and changes nothing
+                plain_len = out_len;
+                EXPECT_EQ(out_len, default_len) << "level " << level;
+                EXPECT_EQ(memcmp(compressed_buf, default_buf, out_len), 0)
+                        << "level " << level;
+            } else if (level <= 3) {
+                // no effect at the fast levels
+                EXPECT_EQ(out_len, plain_len) << "level " << level;
+                EXPECT_EQ(memcmp(compressed_buf, default_buf, out_len), 0)
+                        << "level " << level;
+            } else {
+                // on trades some compression on sparse data for speed
+                EXPECT_LE(out_len, plain_len + plain_len / 5)
+                        << "level " << level;
+            }
+        }
+    }
+
+    err = deflateFastRuns(Z_NULL, 1);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+
+    free(source_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+    free(uncompressed_buf);
+    free(compressed_buf);
+    free(default_buf);
+}
+
+TEST_F(ZlibTest, DeflateParamsAfterFlush) {
+    printf("test changing parameters with nothing left to flush\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    const U32 source_buf_len = 65536;
+    const U32 part_len = source_buf_len / 4;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    U32 nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_EQ(nread, source_buf_len);
+
+    ZlibReturn err;
+    U32 c_work_len;
+    err = deflateWorkSize(&c_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+    U32 uc_work_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    U32 compressed_buf_len = source_buf_len * 2;
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    strm.next_work = c_work_buf;
+    strm.avail_work = c_work_len;
+    err = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
+    EXPECT_EQ(err, Z_OK);
+    strm.next_in = source_buf;
+    strm.avail_in = part_len;
+    strm.next_out = compressed_buf;
+    strm.avail_out = compressed_buf_len;
+
+    printf("after a full flush, the change takes effect without output\n");
+    err = deflate(&strm, Z_FULL_FLUSH);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(strm.avail_in, (U32)0);
+    U32 out_len = strm.total_out;
+    U32 avail_out = strm.avail_out;
+    strm.avail_out = 0;
+    err = deflateParams(&strm, 1, Z_HUFFMAN_ONLY);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(strm.total_out, out_len);
+
+    printf("with unflushed input, the change still needs output space\n");
+    strm.avail_out = avail_out;
+    strm.avail_in = part_len;
+    err = deflate(&strm, Z_NO_FLUSH);
+    EXPECT_EQ(err, Z_OK);
+    avail_out = strm.avail_out;
+    strm.avail_out = 0;
+    err = deflateParams(&strm, 9, Z_FILTERED);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    strm.avail_out = avail_out;
+    err = deflateParams(&strm, 9, Z_FILTERED);
+    EXPECT_EQ(err, Z_OK);
+
+    strm.avail_in = source_buf_len - 2 * part_len;
+    err = deflate(&strm, Z_FINISH);
+    EXPECT_EQ(err, Z_STREAM_END);
+    out_len = strm.total_out;
+    err = deflateEnd(&strm);
+    EXPECT_EQ(err, Z_OK);
+
+    U32 uncompressed_len = source_buf_len;
+    U32 source_len = out_len;
+    err = zsc_uncompress(uncompressed_buf, &uncompressed_len,
+            compressed_buf, &source_len, uc_work_buf, uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(uncompressed_len, source_buf_len);
+    EXPECT_EQ(memcmp(source_buf, uncompressed_buf, source_buf_len), 0);
+
+    free(source_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+    free(uncompressed_buf);
+    free(compressed_buf);
+}
+
+TEST_F(ZlibTest, DeflateHuffRleBulk) {
+    printf("test Huffman-only and RLE deflate on noisy samples\n");
+
+    // 16-bit samples of a slow ramp with noise, and some flat stretches
+    U32 source_buf_len = 300000;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(source_buf, (U8*)NULL);
+    U32 rand_state = 100;
+    for (U32 i = 0; i < source_buf_len; i += 2) {
+        rand_state = rand_state * 1103515245 + 12345;
+        U32 sample = 2048 + ((i / 64) & 0x1ff) + ((rand_state >> 24) & 0x1f);
+        if ((i / 4096) % 5 == 0) {
+            sample = 2048;
+        }
+        source_buf[i] = (U8)(sample & 0xff);
+        source_buf[i + 1] = (U8)(sample >> 8);
+    }
+
+    ZlibReturn err;
+    U32 c_work_len;
+    err = deflateWorkSize(&c_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+    U32 uc_work_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    U32 compressed_buf_len = source_buf_len * 2;
+    U8 * whole_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(whole_buf, (U8*)NULL);
+    U8 * chunked_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(chunked_buf, (U8*)NULL);
+
+    const ZlibStrategy strategies[2] = {Z_HUFFMAN_ONLY, Z_RLE};
+    for (int st = 0; st < 2; st++) {
+        // all at once
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+        strm.next_work = c_work_buf;
+        strm.avail_work = c_work_len;
+        err = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                DEF_WBITS, DEF_MEM_LEVEL, strategies[st]);
+        EXPECT_EQ(err, Z_OK);
+        strm.next_in = source_buf;
+        strm.avail_in = source_buf_len;
+        strm.next_out = whole_buf;
+        strm.avail_out = compressed_buf_len;
+        err = deflate(&strm, Z_FINISH);
+        EXPECT_EQ(err, Z_STREAM_END);
+        U32 whole_len = strm.total_out;
+        err = deflateEnd(&strm);
+        EXPECT_EQ(err, Z_OK);
+
+        U32 uncompressed_len = source_buf_len;
+        U32 source_len = whole_len;
+        err = zsc_uncompress(uncompressed_buf, &uncompressed_len, whole_buf,
+                &source_len, uc_work_buf, uc_work_len);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(uncompressed_len, source_buf_len);
+        EXPECT_EQ(memcmp(source_buf, uncompressed_buf, source_buf_len), 0);
+
+        // in small pieces, the blocks and so the output are the same
+        memset(&strm, 0, sizeof(strm));
+        strm.next_work = c_work_buf;
+        strm.avail_work = c_work_len;
+        err = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                DEF_WBITS, DEF_MEM_LEVEL, strategies[st]);
+        EXPECT_EQ(err, Z_OK);
+        strm.next_in = source_buf;
+        strm.next_out = chunked_buf;
+        strm.avail_out = compressed_buf_len;
+        while (strm.total_in < source_buf_len) {
+            strm.avail_in = MIN(777, source_buf_len - strm.total_in);
+            err = deflate(&strm, Z_NO_FLUSH);
+            EXPECT_EQ(err, Z_OK);
+        }
+        err = deflate(&strm, Z_FINISH);
+        EXPECT_EQ(err, Z_STREAM_END);
+        EXPECT_EQ(strm.total_out, whole_len);
+        EXPECT_EQ(memcmp(whole_buf, chunked_buf, whole_len), 0);
+        err = deflateEnd(&strm);
+        EXPECT_EQ(err, Z_OK);
+
+        // switching to matching after the window has slid
+        memset(&strm, 0, sizeof(strm));
+        strm.next_work = c_work_buf;
+        strm.avail_work = c_work_len;
+        err = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                DEF_WBITS, DEF_MEM_LEVEL, strategies[st]);
+        EXPECT_EQ(err, Z_OK);
+        strm.next_in = source_buf;
+        strm.avail_in = source_buf_len / 2;
+        strm.next_out = chunked_buf;
+        strm.avail_out = compressed_buf_len;
+        err = deflate(&strm, Z_NO_FLUSH);
+        EXPECT_EQ(err, Z_OK);
+        err = deflateParams(&strm, Z_DEFAULT_COMPRESSION,
+                Z_DEFAULT_STRATEGY);
+        EXPECT_EQ(err, Z_OK);
+        strm.avail_in = source_buf_len - strm.total_in;
+        err = deflate(&strm, Z_FINISH);
+        EXPECT_EQ(err, Z_STREAM_END);
+        U32 switched_len = strm.total_out;
+        err = deflateEnd(&strm);
+        EXPECT_EQ(err, Z_OK);
+
+        uncompressed_len = source_buf_len;
+        source_len = switched_len;
+        err = zsc_uncompress(uncompressed_buf, &uncompressed_len,
+                chunked_buf, &source_len, uc_work_buf, uc_work_len);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(uncompressed_len, source_buf_len);
+        EXPECT_EQ(memcmp(source_buf, uncompressed_buf, source_buf_len), 0);
+    }
+
+    free(source_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+    free(uncompressed_buf);
+    free(whole_buf);
+    free(chunked_buf);
+}
+
+TEST_F(ZlibTest, ZSCUncompressErrors) {
+    printf("test errors in zsc_uncompress\n");
+
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    int source_buf_len = CORPUS_MAX_SIZE;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_TRUE(nread <= source_buf_len);
+    source_buf_len = nread;
+
+    ZlibReturn err;
+
+    U32 compressed_buf_len;
+    U8 * compressed_buf;
+    U32 work_buf_len;
+    U8 * work_buf;
+    U32 compressed_buf_len_out;
+    int max_block_size = 10000;
+
+    int level = Z_DEFAULT_COMPRESSION;
+
+    err = zsc_compress_get_max_output_size(source_buf_len, max_block_size,
+            level, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+
+
+    err = zsc_compress_get_min_work_buf_size(&work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+    compressed_buf_len_out = compressed_buf_len;
+
+    err = zsc_compress(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len,  max_block_size,
+            work_buf, work_buf_len, level);
+    EXPECT_EQ(err, Z_OK);
+
+    free(work_buf);
+    free(source_buf);
+
+    U32 uncompressed_buf_len = source_buf_len;
+    U8 * uncompressed_buf = (U8 *) malloc(uncompressed_buf_len);
+    EXPECT_NE(uncompressed_buf, (U8 * )NULL);
+    err = zsc_uncompress_get_min_work_buf_size(&work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    work_buf = (U8 *) malloc(work_buf_len);
+
+    U32 compressed_buf_len_out2;
+    U32 uncompressed_buf_len_out;
+
+    printf("work buf size = 0\n");
+    compressed_buf_len_out2 = compressed_buf_len_out;
+    uncompressed_buf_len_out = uncompressed_buf_len;
+    err = zsc_uncompress(uncompressed_buf, &uncompressed_buf_len_out,
+                            compressed_buf, &compressed_buf_len_out2,
+                            work_buf, 0);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+    printf("zError:%s\n", zError(err));
+
+    printf("bad window bits arg\n");
+    compressed_buf_len_out2 = compressed_buf_len_out;
+    uncompressed_buf_len_out = uncompressed_buf_len;
+    err = zsc_uncompress2(uncompressed_buf, &uncompressed_buf_len_out,
+                            compressed_buf, &compressed_buf_len_out2,
+                            work_buf, work_buf_len, 500);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    printf("zError:%s\n", zError(err));
+
+    printf("output buf size small\n");
+    compressed_buf_len_out2 = compressed_buf_len_out;
+    uncompressed_buf_len_out = 42;
+    err = zsc_uncompress(uncompressed_buf, &uncompressed_buf_len_out,
+                            compressed_buf, &compressed_buf_len_out2,
+                            work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    printf("zError:%s\n", zError(err));
+
+    printf("gzip header when not gzip\n");
+    gz_header header;
+    memset(&header, 0, sizeof(header));
+    compressed_buf_len_out2 = compressed_buf_len_out;
+    uncompressed_buf_len_out = uncompressed_buf_len;
+    err = zsc_uncompress_gzip2(uncompressed_buf, &uncompressed_buf_len_out,
+                            compressed_buf, &compressed_buf_len_out2,
+                            work_buf, work_buf_len, DEF_WBITS, &header);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+    printf("zError:%s\n", zError(err));
+
+    free(compressed_buf);
+    free(uncompressed_buf);
+    free(work_buf);
+
+}
+
+TEST_F(ZlibTest, ZSCIovec) {
+    printf("test scatter/gather zsc_compress and zsc_uncompress\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    int source_buf_len = CORPUS_MAX_SIZE;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_TRUE(nread <= source_buf_len);
+    source_buf_len = nread;
+
+    ZlibReturn err;
+    int level = Z_DEFAULT_COMPRESSION;
+    int max_block_size = 10000;
+
+    U32 compressed_buf_len;
+    err = zsc_compress_get_max_output_size(source_buf_len, max_block_size,
+            level, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * iov_compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(iov_compressed_buf, (U8*)NULL);
+
+    U32 work_buf_len;
+    err = zsc_compress_get_min_work_buf_size(&work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+
+    // contiguous reference
+    U32 compressed_buf_len_out = compressed_buf_len;
+    err = zsc_compress(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len, max_block_size,
+            work_buf, work_buf_len, level);
+    EXPECT_EQ(err, Z_OK);
+
+    // a single segment gives the same stream as the contiguous call
+    zsc_const_iovec source_one = {source_buf, (U32)source_buf_len};
+    zsc_iovec comp_one = {iov_compressed_buf, compressed_buf_len};
+    U32 iov_compressed_len_out = 0;
+    err = zsc_compress_iov(&comp_one, 1, &iov_compressed_len_out,
+            &source_one, 1, max_block_size, work_buf, work_buf_len, level);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(iov_compressed_len_out, compressed_buf_len_out);
+    EXPECT_EQ(0, memcmp(compressed_buf, iov_compressed_buf,
+            compressed_buf_len_out));
+
+    // split input and output into uneven segments, including empty ones,
+    // that don't line up with blocks
+    enum { NUM_SEGS = 8 };
+    U32 seg_lens[NUM_SEGS] = {0, 1, 4093, 0, 17, 65536, 12345, 0};
+    zsc_const_iovec source_iov[NUM_SEGS + 1];
+    zsc_iovec comp_iov[NUM_SEGS + 1];
+    U32 off_in = 0;
+    U32 off_out = 0;
+    for (int i = 0; i < NUM_SEGS; i++) {
+        U32 len_in = MIN(seg_lens[i], source_buf_len - off_in);
+        source_iov[i].base = source_buf + off_in;
+        source_iov[i].len = len_in;
+        off_in += len_in;
+        U32 len_out = MIN(seg_lens[i], compressed_buf_len - off_out);
+        comp_iov[i].base = iov_compressed_buf + off_out;
+        comp_iov[i].len = len_out;
+        off_out += len_out;
+    }
+    source_iov[NUM_SEGS].base = source_buf + off_in;
+    source_iov[NUM_SEGS].len = source_buf_len - off_in;
+    comp_iov[NUM_SEGS].base = iov_compressed_buf + off_out;
+    comp_iov[NUM_SEGS].len = compressed_buf_len - off_out;
+
+    iov_compressed_len_out = 0;
+    err = zsc_compress_iov(comp_iov, NUM_SEGS + 1, &iov_compressed_len_out,
+            source_iov, NUM_SEGS + 1, max_block_size,
+            work_buf, work_buf_len, level);
+    EXPECT_EQ(err, Z_OK);
+
+    free(work_buf);
+    err = zsc_uncompress_get_min_work_buf_size(&work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    work_buf = (U8 *) malloc(work_buf_len);
+    ASSERT_NE(work_buf, (U8*)NULL);
+
+    U32 uncompressed_buf_len = source_buf_len;
+    U8 * uncompressed_buf = (U8 *) malloc(uncompressed_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+
+    // gather the segmented stream, scatter output into the same uneven pattern
+    zsc_const_iovec in_iov[NUM_SEGS + 1];
+    zsc_iovec uncomp_iov[NUM_SEGS + 1];
+    off_in = 0;
+    off_out = 0;
+    for (int i = 0; i < NUM_SEGS; i++) {
+        U32 len_in = MIN(seg_lens[i], iov_compressed_len_out - off_in);
+        in_iov[i].base = iov_compressed_buf + off_in;
+        in_iov[i].len = len_in;
+        off_in += len_in;
+        U32 len_out = MIN(seg_lens[i], uncompressed_buf_len - off_out);
+        uncomp_iov[i].base = uncompressed_buf + off_out;
+        uncomp_iov[i].len = len_out;
+        off_out += len_out;
+    }
+    in_iov[NUM_SEGS].base = iov_compressed_buf + off_in;
+    in_iov[NUM_SEGS].len = iov_compressed_len_out - off_in;
+    uncomp_iov[NUM_SEGS].base = uncompressed_buf + off_out;
+    uncomp_iov[NUM_SEGS].len = uncompressed_buf_len - off_out;
+
+    U32 uncompressed_len_out = 0;
+    U32 compressed_len_used = 0;
+    memset(uncompressed_buf, 0xa5, uncompressed_buf_len);
+    err = zsc_uncompress_iov(uncomp_iov, NUM_SEGS + 1, &uncompressed_len_out,
+            in_iov, NUM_SEGS + 1, &compressed_len_used,
+            work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(uncompressed_len_out, (U32)source_buf_len);
+    EXPECT_EQ(compressed_len_used, iov_compressed_len_out);
+    EXPECT_EQ(0, memcmp(source_buf, uncompressed_buf, source_buf_len));
+
+    printf("output segments too small\n");
+    err = zsc_uncompress_iov(uncomp_iov, NUM_SEGS, &uncompressed_len_out,
+            in_iov, NUM_SEGS + 1, &compressed_len_used,
+            work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    printf("zError:%s\n", zError(err));
+
+    printf("input segments truncated\n");
+    err = zsc_uncompress_iov(uncomp_iov, NUM_SEGS + 1, &uncompressed_len_out,
+            in_iov, NUM_SEGS / 2, &compressed_len_used,
+            work_buf, work_buf_len);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    printf("zError:%s\n", zError(err));
+
+    free(compressed_buf);
+    free(iov_compressed_buf);
+    free(uncompressed_buf);
+    free(source_buf);
+    free(work_buf);
+}
+
+TEST_F(ZlibTest, ZSCUncompressGetSize) {
+    printf("test counting the uncompressed size\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    int source_buf_len = CORPUS_MAX_SIZE;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_TRUE(nread <= source_buf_len);
+    source_buf_len = nread;
+
+    ZlibReturn err;
+    int max_block_size = 10000;
+
+    U32 compressed_buf_len;
+    err = zsc_compress_get_max_output_size(source_buf_len, max_block_size,
+            Z_NO_COMPRESSION, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+
+    U32 c_work_buf_len;
+    err = zsc_compress_get_min_work_buf_size(&c_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_buf_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+
+    U32 uc_work_buf_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_buf_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+
+    U32 compressed_buf_len_out;
+    U32 size_out;
+    // stored, fixed, and dynamic blocks
+    int levels[4] = {Z_NO_COMPRESSION, Z_BEST_SPEED, Z_DEFAULT_COMPRESSION,
+            Z_BEST_COMPRESSION};
+    for (int i = 0; i < 4; i++) {
+        compressed_buf_len_out = compressed_buf_len;
+        err = zsc_compress(compressed_buf, &compressed_buf_len_out,
+                source_buf, source_buf_len, max_block_size,
+                c_work_buf, c_work_buf_len, levels[i]);
+        EXPECT_EQ(err, Z_OK);
+
+        size_out = 0;
+        err = zsc_uncompress_get_size(compressed_buf, compressed_buf_len_out,
+                uc_work_buf, uc_work_buf_len, &size_out);
+        EXPECT_EQ(err, Z_OK);
+        EXPECT_EQ(size_out, (U32)source_buf_len);
+    }
+
+    printf("gzip wrapper\n");
+    compressed_buf_len_out = compressed_buf_len;
+    err = zsc_compress_gzip(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len, max_block_size,
+            c_work_buf, c_work_buf_len, Z_DEFAULT_COMPRESSION, Z_NULL);
+    EXPECT_EQ(err, Z_OK);
+    err = zsc_uncompress_get_size2(compressed_buf, compressed_buf_len_out,
+            uc_work_buf, uc_work_buf_len, DEF_WBITS + GZIP_CODE, &size_out);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(size_out, (U32)source_buf_len);
+
+    printf("truncated input\n");
+    err = zsc_uncompress_get_size2(compressed_buf, compressed_buf_len_out / 2,
+            uc_work_buf, uc_work_buf_len, DEF_WBITS + GZIP_CODE, &size_out);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    EXPECT_LT(size_out, (U32)source_buf_len);
+    printf("zError:%s\n", zError(err));
+
+    printf("work buf size = 0\n");
+    err = zsc_uncompress_get_size(compressed_buf, compressed_buf_len_out,
+            uc_work_buf, 0, &size_out);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+    printf("zError:%s\n", zError(err));
+
+    printf("check value is validated again after reset\n");
+    U8 * uncompressed_buf = (U8 *) malloc(source_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+    compressed_buf[compressed_buf_len_out - 8] ^= 1; // corrupt the crc
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.next_work = uc_work_buf;
+    stream.avail_work = uc_work_buf_len;
+    err = inflateInit2(&stream, DEF_WBITS + GZIP_CODE);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(inflateCount(&stream, 1), Z_OK);
+    stream.next_in = compressed_buf;
+    stream.avail_in = compressed_buf_len_out;
+    stream.next_out = uncompressed_buf;
+    stream.avail_out = U32_MAX;
+    err = inflate(&stream, Z_FINISH);
+    EXPECT_EQ(err, Z_STREAM_END); // not checked while counting
+    EXPECT_EQ(stream.total_out, (U32)source_buf_len);
+    EXPECT_EQ(inflateReset(&stream), Z_OK);
+    stream.next_in = compressed_buf;
+    stream.avail_in = compressed_buf_len_out;
+    stream.next_out = uncompressed_buf;
+    stream.avail_out = source_buf_len;
+    err = inflate(&stream, Z_FINISH);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+    EXPECT_EQ(inflateEnd(&stream), Z_OK);
+    free(uncompressed_buf);
+
+    free(source_buf);
+    free(compressed_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+}
+
+TEST_F(ZlibTest, ZSCUncompressBatch) {
+    printf("test decompressing a batch of messages\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    int source_buf_len = CORPUS_MAX_SIZE;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_TRUE(nread <= source_buf_len);
+    source_buf_len = nread;
+
+    ZlibReturn err;
+    const int NUM_ITEMS = 8;
+    const U32 MSG_LEN = 500;
+    const U32 SLOT_LEN = 1000;
+    U8 * compressed_buf = (U8 *) malloc(NUM_ITEMS * SLOT_LEN);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+    U8 * uncompressed_buf = (U8 *) malloc(NUM_ITEMS * SLOT_LEN);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+
+    U32 c_work_buf_len;
+    err = zsc_compress_get_min_work_buf_size(&c_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_buf_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+
+    U32 uc_work_buf_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_buf_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+
+    zsc_batch_item items[NUM_ITEMS];
+    U32 compressed_lens[NUM_ITEMS];
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        compressed_lens[i] = SLOT_LEN;
+        err = zsc_compress(compressed_buf + i * SLOT_LEN, &compressed_lens[i],
+                source_buf + i * MSG_LEN, MSG_LEN, MSG_LEN,
+                c_work_buf, c_work_buf_len, Z_DEFAULT_COMPRESSION);
+        EXPECT_EQ(err, Z_OK);
+        items[i].source = compressed_buf + i * SLOT_LEN;
+        items[i].source_len = compressed_lens[i];
+        items[i].dest = uncompressed_buf + i * SLOT_LEN;
+        items[i].dest_len = SLOT_LEN;
+    }
+
+    err = zsc_uncompress_batch(items, NUM_ITEMS, uc_work_buf, uc_work_buf_len,
+            DEF_WBITS, Z_NULL, 0);
+    EXPECT_EQ(err, Z_OK);
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        EXPECT_EQ(items[i].err, Z_OK);
+        EXPECT_EQ(items[i].source_len, compressed_lens[i]);
+        EXPECT_EQ(items[i].dest_len, MSG_LEN);
+        EXPECT_EQ(memcmp(items[i].dest, source_buf + i * MSG_LEN, MSG_LEN), 0);
+    }
+
+    printf("failed items don't stop the batch\n");
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        items[i].source_len = compressed_lens[i];
+        items[i].dest_len = SLOT_LEN;
+    }
+    items[2].dest_len = MSG_LEN / 2; // too small
+    compressed_buf[5 * SLOT_LEN] ^= 0xFF; // bad zlib header
+    err = zsc_uncompress_batch(items, NUM_ITEMS, uc_work_buf, uc_work_buf_len,
+            DEF_WBITS, Z_NULL, 0);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    EXPECT_EQ(items[2].err, Z_BUF_ERROR);
+    EXPECT_EQ(items[2].dest_len, MSG_LEN / 2);
+    EXPECT_EQ(items[5].err, Z_DATA_ERROR);
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        if (i != 2 && i != 5) {
+            EXPECT_EQ(items[i].err, Z_OK);
+            EXPECT_EQ(items[i].dest_len, MSG_LEN);
+            EXPECT_EQ(memcmp(items[i].dest, source_buf + i * MSG_LEN,
+                    MSG_LEN), 0);
+        }
+    }
+    compressed_buf[5 * SLOT_LEN] ^= 0xFF;
+
+    printf("shared dictionary, raw deflate\n");
+    const U8 * dictionary = source_buf + NUM_ITEMS * MSG_LEN;
+    U32 dict_len = 4096;
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        stream.next_work = c_work_buf;
+        stream.avail_work = c_work_buf_len;
+        err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                -DEF_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+        EXPECT_EQ(err, Z_OK);
+        err = deflateSetDictionary(&stream, dictionary, dict_len);
+        EXPECT_EQ(err, Z_OK);
+        stream.next_in = source_buf + i * MSG_LEN;
+        stream.avail_in = MSG_LEN;
+        stream.next_out = compressed_buf + i * SLOT_LEN;
+        stream.avail_out = SLOT_LEN;
+        err = deflate(&stream, Z_FINISH);
+        EXPECT_EQ(err, Z_STREAM_END);
+        items[i].source_len = stream.total_out;
+        items[i].dest_len = SLOT_LEN;
+        err = deflateEnd(&stream);
+        EXPECT_EQ(err, Z_OK);
+    }
+    err = zsc_uncompress_batch(items, NUM_ITEMS, uc_work_buf, uc_work_buf_len,
+            -DEF_WBITS, dictionary, dict_len);
+    EXPECT_EQ(err, Z_OK);
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        EXPECT_EQ(items[i].err, Z_OK);
+        EXPECT_EQ(items[i].dest_len, MSG_LEN);
+        EXPECT_EQ(memcmp(items[i].dest, source_buf + i * MSG_LEN, MSG_LEN), 0);
+    }
+
+    printf("shared dictionary, zlib wrapper\n");
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        stream.next_work = c_work_buf;
+        stream.avail_work = c_work_buf_len;
+        err = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
+        EXPECT_EQ(err, Z_OK);
+        err = deflateSetDictionary(&stream, dictionary, dict_len);
+        EXPECT_EQ(err, Z_OK);
+        stream.next_in = source_buf + i * MSG_LEN;
+        stream.avail_in = MSG_LEN;
+        stream.next_out = compressed_buf + i * SLOT_LEN;
+        stream.avail_out = SLOT_LEN;
+        err = deflate(&stream, Z_FINISH);
+        EXPECT_EQ(err, Z_STREAM_END);
+        compressed_lens[i] = stream.total_out;
+        // trailing bytes must not be counted as used
+        items[i].source_len = compressed_lens[i] + 3;
+        items[i].dest_len = SLOT_LEN;
+        err = deflateEnd(&stream);
+        EXPECT_EQ(err, Z_OK);
+    }
+    err = zsc_uncompress_batch(items, NUM_ITEMS, uc_work_buf, uc_work_buf_len,
+            DEF_WBITS, dictionary, dict_len);
+    EXPECT_EQ(err, Z_OK);
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        EXPECT_EQ(items[i].err, Z_OK);
+        EXPECT_EQ(items[i].source_len, compressed_lens[i]);
+        EXPECT_EQ(items[i].dest_len, MSG_LEN);
+        EXPECT_EQ(memcmp(items[i].dest, source_buf + i * MSG_LEN, MSG_LEN), 0);
+    }
+
+    printf("work buf size = 0\n");
+    err = zsc_uncompress_batch(items, NUM_ITEMS, uc_work_buf, 0,
+            -DEF_WBITS, dictionary, dict_len);
+    EXPECT_EQ(err, Z_MEM_ERROR);
+    for (int i = 0; i < NUM_ITEMS; i++) {
+        EXPECT_EQ(items[i].err, Z_MEM_ERROR);
+        EXPECT_EQ(items[i].dest_len, (U32)0);
+    }
+    printf("zError:%s\n", zError(err));
+
+    free(source_buf);
+    free(compressed_buf);
+    free(uncompressed_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+}
+
+TEST_F(ZlibTest, ZSCGzipInfo) {
+    printf("test zsc info in the gzip extra field\n");
+
+    FILE * file = fopen("corpus/cantrbry/alice29.txt", "r");
+    ASSERT_FALSE(file == NULL);
+
+    int source_buf_len = CORPUS_MAX_SIZE;
+    U8 * source_buf = (U8 *) malloc(source_buf_len);
+    int nread = fread(source_buf, 1, source_buf_len, file);
+    ASSERT_FALSE(ferror(file));
+    fclose(file);
+    ASSERT_TRUE(nread <= source_buf_len);
+    source_buf_len = nread;
+
+    ZlibReturn err;
+    int level = Z_DEFAULT_COMPRESSION;
+    int max_block_size = 10000;
+
+    U32 compressed_buf_len;
+    err = zsc_compress_get_max_output_size_gzip(source_buf_len, max_block_size,
+            level, Z_NULL, &compressed_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    compressed_buf_len += ZSC_INFO_HEADER_LEN + 100;
+    U8 * compressed_buf = (U8 *) malloc(compressed_buf_len);
+    ASSERT_NE(compressed_buf, (U8*)NULL);
+
+    U32 c_work_buf_len;
+    err = zsc_compress_get_min_work_buf_size(&c_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * c_work_buf = (U8 *) malloc(c_work_buf_len);
+    ASSERT_NE(c_work_buf, (U8*)NULL);
+
+    U32 uc_work_buf_len;
+    err = zsc_uncompress_get_min_work_buf_size(&uc_work_buf_len);
+    EXPECT_EQ(err, Z_OK);
+    U8 * uc_work_buf = (U8 *) malloc(uc_work_buf_len);
+    ASSERT_NE(uc_work_buf, (U8*)NULL);
+
+    U32 uncompressed_buf_len = source_buf_len;
+    U8 * uncompressed_buf = (U8 *) malloc(uncompressed_buf_len);
+    ASSERT_NE(uncompressed_buf, (U8*)NULL);
+
+    // caller extra field is kept after the info
+    U8 caller_extra[8] = {'A', 'B', 4, 0, 1, 2, 3, 4};
+    gz_header head;
+    memset(&head, 0, sizeof(head));
+    head.extra = caller_extra;
+    head.extra_len = 8;
+
+    U32 compressed_buf_len_out = compressed_buf_len;
+    err = zsc_compress_gzip_info(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len, max_block_size,
+            c_work_buf, c_work_buf_len, level, &head);
+    EXPECT_EQ(err, Z_OK);
+
+    zsc_info info;
+    err = zsc_uncompress_get_info(compressed_buf, compressed_buf_len_out, &info);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(info.source_len, (U32)source_buf_len);
+    EXPECT_EQ(info.num_blocks,
+            (U32)(source_buf_len + max_block_size - 1) / max_block_size);
+    EXPECT_EQ(info.max_block_len, (U32)max_block_size);
+
+    // still a standard gzip stream
+    U8 extra_out[64];
+    gz_header head_out;
+    memset(&head_out, 0, sizeof(head_out));
+    head_out.extra = extra_out;
+    head_out.extra_max = 64;
+    U32 compressed_len_used = compressed_buf_len_out;
+    U32 uncompressed_buf_len_out = uncompressed_buf_len;
+    err = zsc_uncompress_gzip(uncompressed_buf, &uncompressed_buf_len_out,
+            compressed_buf, &compressed_len_used,
+            uc_work_buf, uc_work_buf_len, &head_out);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(uncompressed_buf_len_out, (U32)source_buf_len);
+    EXPECT_EQ(0, memcmp(source_buf, uncompressed_buf, source_buf_len));
+    EXPECT_EQ(head_out.extra_len, (U32)(ZSC_INFO_SUBFIELD_LEN + 8));
+    EXPECT_EQ(0, memcmp(caller_extra, extra_out + ZSC_INFO_SUBFIELD_LEN, 8));
+
+    printf("output too small for info\n");
+    // without a header crc, the info is only a hint, so inflate runs out
+    compressed_len_used = compressed_buf_len_out;
+    uncompressed_buf_len_out = source_buf_len - 1;
+    err = zsc_uncompress_gzip(uncompressed_buf, &uncompressed_buf_len_out,
+            compressed_buf, &compressed_len_used,
+            uc_work_buf, uc_work_buf_len, Z_NULL);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    EXPECT_EQ(uncompressed_buf_len_out, (U32)source_buf_len - 1);
+    printf("zError:%s\n", zError(err));
+
+    printf("flipped bit in unchecked info\n");
+    // the info source_len is at the front of the extra field
+    compressed_buf[12 + 4 + 3] ^= 0x40;
+    err = zsc_uncompress_get_info(compressed_buf, compressed_buf_len_out, &info);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_GT(info.source_len, (U32)source_buf_len);
+    compressed_len_used = compressed_buf_len_out;
+    uncompressed_buf_len_out = uncompressed_buf_len;
+    err = zsc_uncompress_gzip(uncompressed_buf, &uncompressed_buf_len_out,
+            compressed_buf, &compressed_len_used,
+            uc_work_buf, uc_work_buf_len, Z_NULL);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(uncompressed_buf_len_out, (U32)source_buf_len);
+    EXPECT_EQ(0, memcmp(source_buf, uncompressed_buf, source_buf_len));
+
+    printf("output too small for info with header crc\n");
+    head.hcrc = 1;
+    compressed_buf_len_out = compressed_buf_len;
+    err = zsc_compress_gzip_info(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len, max_block_size,
+            c_work_buf, c_work_buf_len, level, &head);
+    EXPECT_EQ(err, Z_OK);
+    head.hcrc = 0;
+    err = zsc_uncompress_get_info(compressed_buf, compressed_buf_len_out, &info);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(info.source_len, (U32)source_buf_len);
+    compressed_len_used = compressed_buf_len_out;
+    uncompressed_buf_len_out = source_buf_len - 1;
+    err = zsc_uncompress_gzip(uncompressed_buf, &uncompressed_buf_len_out,
+            compressed_buf, &compressed_len_used,
+            uc_work_buf, uc_work_buf_len, Z_NULL);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    EXPECT_EQ(compressed_len_used, 0U);
+    // split output segments are checked against the info too
+    zsc_iovec dest_segs[2];
+    dest_segs[0].base = uncompressed_buf;
+    dest_segs[0].len = source_buf_len / 2;
+    dest_segs[1].base = uncompressed_buf + source_buf_len / 2;
+    dest_segs[1].len = source_buf_len - source_buf_len / 2 - 1;
+    zsc_const_iovec source_seg;
+    source_seg.base = compressed_buf;
+    source_seg.len = compressed_buf_len_out;
+    err = zsc_uncompress_iov_gzip2(dest_segs, 2, &uncompressed_buf_len_out,
+            &source_seg, 1, &compressed_len_used,
+            uc_work_buf, uc_work_buf_len, DEF_WBITS + GZIP_CODE, Z_NULL);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+    EXPECT_EQ(compressed_len_used, 0U);
+    dest_segs[1].len++;
+    err = zsc_uncompress_iov_gzip2(dest_segs, 2, &uncompressed_buf_len_out,
+            &source_seg, 1, &compressed_len_used,
+            uc_work_buf, uc_work_buf_len, DEF_WBITS + GZIP_CODE, Z_NULL);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(uncompressed_buf_len_out, (U32)source_buf_len);
+    EXPECT_EQ(0, memcmp(source_buf, uncompressed_buf, source_buf_len));
+
+    printf("flipped bit in checked info\n");
+    compressed_buf[12 + 4 + 3] ^= 0x40;
+    err = zsc_uncompress_get_info(compressed_buf, compressed_buf_len_out, &info);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+
+    printf("default header\n");
+    compressed_buf_len_out = compressed_buf_len;
+    err = zsc_compress_gzip_info(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len, max_block_size,
+            c_work_buf, c_work_buf_len, level, Z_NULL);
+    EXPECT_EQ(err, Z_OK);
+    err = zsc_uncompress_get_info(compressed_buf, compressed_buf_len_out, &info);
+    EXPECT_EQ(err, Z_OK);
+    EXPECT_EQ(info.source_len, (U32)source_buf_len);
+    err = zsc_uncompress_get_info(compressed_buf, 14, &info);
+    EXPECT_EQ(err, Z_BUF_ERROR);
+
+    printf("info without gzip wrapper\n");
+    compressed_buf_len_out = compressed_buf_len;
+    err = zsc_compress_gzip_info2(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len, max_block_size,
+            c_work_buf, c_work_buf_len, level, DEF_WBITS, DEF_MEM_LEVEL,
+            Z_DEFAULT_STRATEGY, Z_NULL);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+
+    printf("caller extra too long\n");
+    head.extra_len = ZSC_INFO_EXTRA_MAX;
+    compressed_buf_len_out = compressed_buf_len;
+    err = zsc_compress_gzip_info(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len, max_block_size,
+            c_work_buf, c_work_buf_len, level, &head);
+    EXPECT_EQ(err, Z_STREAM_ERROR);
+
+    printf("no info without it\n");
+    compressed_buf_len_out = compressed_buf_len;
+    err = zsc_compress_gzip(compressed_buf, &compressed_buf_len_out,
+            source_buf, source_buf_len, max_block_size,
+            c_work_buf, c_work_buf_len, level, Z_NULL);
+    EXPECT_EQ(err, Z_OK);
+    err = zsc_uncompress_get_info(compressed_buf, compressed_buf_len_out, &info);
+    EXPECT_EQ(err, Z_DATA_ERROR);
+
+    free(source_buf);
+    free(compressed_buf);
+    free(uncompressed_buf);
+    free(c_work_buf);
+    free(uc_work_buf);
+}
+
+TEST_F(ZlibTest, ChecksumMulti) {
+    printf("test crc32_multi() and adler32_multi() against single buffers\n");
+
+    const U32 num_bufs = 11;
+    const U8 *bufs[num_bufs];
+    z_size_t lens[num_bufs];
+    U32 crcs[num_bufs];
+    U32 adlers[num_bufs];
+    U32 i;
+    const U8 *text = alice_dictionary;
+    const z_size_t text_len = strlen((const char *)text);
+
+    /* mixed lengths, including empty, unaligned, and > NMAX */
+    for (i = 0; i < num_bufs; i++) {
+        bufs[i] = text + (i % 3);
+        lens[i] = (i * 7) % (text_len - 3);
+        crcs[i] = crc32(0L, Z_NULL, 0);
+        adlers[i] = adler32(0L, Z_NULL, 0);
+    }
+    U8 *big = (U8 *)malloc(6000);
+    ASSERT_NE(big, nullptr);
+    for (i = 0; i < 6000; i++) {
+        big[i] = (U8)(0xff - (i % 7));
+    }
+    for (i = 4; i < 8; i++) {
+        bufs[i] = big + (i - 4);
+        lens[i] = 5990 - i;
+    }
+    bufs[9] = Z_NULL;
+    crcs[10] = crc32(0L, text, 5);
+    adlers[10] = adler32(0L, text, 5);
+
+    U32 crcs_in[num_bufs];
+    U32 adlers_in[num_bufs];
+    memcpy(crcs_in, crcs, sizeof(crcs));
+    memcpy(adlers_in, adlers, sizeof(adlers));
+
+    EXPECT_EQ(crc32_multi(crcs, bufs, lens, num_bufs), Z_OK);
+    EXPECT_EQ(adler32_multi(adlers, bufs, lens, num_bufs), Z_OK);
+    for (i = 0; i < num_bufs; i++) {
+        EXPECT_EQ(crcs[i], crc32_z(crcs_in[i], bufs[i], lens[i]));
+        EXPECT_EQ(adlers[i], adler32_z(adlers_in[i], bufs[i], lens[i]));
+    }
+
+    printf("null arrays give error\n");
+    EXPECT_EQ(crc32_multi(Z_NULL, bufs, lens, num_bufs), Z_STREAM_ERROR);
+    EXPECT_EQ(crc32_multi(crcs, Z_NULL, lens, num_bufs), Z_STREAM_ERROR);
+    EXPECT_EQ(crc32_multi(crcs, bufs, Z_NULL, num_bufs), Z_STREAM_ERROR);
+    EXPECT_EQ(adler32_multi(Z_NULL, bufs, lens, num_bufs), Z_STREAM_ERROR);
+    EXPECT_EQ(adler32_multi(adlers, Z_NULL, lens, num_bufs), Z_STREAM_ERROR);
+    EXPECT_EQ(adler32_multi(adlers, bufs, Z_NULL, num_bufs), Z_STREAM_ERROR);
+    EXPECT_EQ(crc32_multi(crcs, bufs, lens, 0), Z_OK);
 
+    free(big);
 }
 
 TEST_F(ZlibTest, DeflateErrors) {
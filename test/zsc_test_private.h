@@ -68,6 +68,16 @@
 #define ZSC_ASSERT3(test, arg1, arg2, arg3) assert(test)
 #define ZSC_ASSERT_DBL1(test, arg1) assert(test)
 
+/* Paranoid asserts re-check, on every iteration of an inner loop, an
+   invariant that is already asserted once per call. They are kept on
+   for testing; an application may define them as nothing for speed.
+   If they are not defined, zutil.h defines them as ZSC_ASSERT.
+ */
+#define ZSC_ASSERT_PARANOID(test) assert(test)
+#define ZSC_ASSERT_PARANOID1(test, arg1) assert(test)
+#define ZSC_ASSERT_PARANOID2(test, arg1, arg2) assert(test)
+#define ZSC_ASSERT_PARANOID3(test, arg1, arg2, arg3) assert(test)
+
 // if your framework has messaging/logging infrastructure, replace here
 // or define as nothing to disable
 #define ZSC_WARN(fmt) printf("ZSC WARNING "fmt"\n")